@@ -0,0 +1,241 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// One retired instruction
+struct CommitRecord {
+    uint64_t cycle = 0;    // mcycle at retirement
+    uint32_t pc = 0;
+    uint32_t instr = 0;
+    uint8_t rd = 0;        // 0 = no register write
+    uint32_t rd_value = 0;
+    bool load = false, store = false;
+    uint32_t mem_addr = 0;
+    uint32_t mem_data = 0; // stored value (loads: see rd_value)
+};
+
+// Binary commit log format: the 8-byte magic, then one variable-length record per retirement.
+//   flags   1 byte, the COMMIT_* bits below
+//   cycle   LEB128 delta to the previous record
+//   pc      4 bytes, unless COMMIT_SEQUENTIAL (previous PC + 4)
+//   instr   4 bytes, only the first time a PC appears (COMMIT_INSTR), later looked up by PC
+//   rd      1 byte + 4 byte value with COMMIT_RD
+//   address 4 bytes with COMMIT_LOAD/COMMIT_STORE, plus 4 data bytes with COMMIT_STORE
+// Integers are little endian. A straight-line ALU instruction takes 7 bytes.
+static const char COMMIT_LOG_MAGIC[8] = {'R', 'V', 'C', 'O', 'M', 'M', 'I', '1'};
+enum : uint8_t {
+    COMMIT_SEQUENTIAL = 1 << 0,
+    COMMIT_INSTR      = 1 << 1,
+    COMMIT_RD         = 1 << 2,
+    COMMIT_LOAD       = 1 << 3,
+    COMMIT_STORE      = 1 << 4,
+};
+
+// Encodes records into 1MB buffers that a background thread writes out, so the simulation
+// only pays for the encoding. Not shared between testers.
+class CommitLogWriter {
+public:
+    static const size_t BUFFER_SIZE = 1 << 20;
+
+    ~CommitLogWriter() { close(); }
+
+    bool open(const std::string& filename) {
+        close();
+        file = std::fopen(filename.c_str(), "wb");
+        if (!file) return false;
+        std::fwrite(COMMIT_LOG_MAGIC, 1, sizeof(COMMIT_LOG_MAGIC), file);
+        prev_cycle = 0;
+        prev_pc = 0;
+        seen_pcs.clear();
+        count = 0;
+        stopping = false;
+        buffer.reserve(BUFFER_SIZE);
+        writer = std::thread([this]() { write_loop(); });
+        return true;
+    }
+
+    bool is_open() const { return file != nullptr; }
+    uint64_t records() const { return count; }
+
+    void append(const CommitRecord& r) {
+        uint8_t flags = 0;
+        if (r.pc == prev_pc + 4) flags |= COMMIT_SEQUENTIAL;
+        if (seen_pcs.insert(r.pc).second) flags |= COMMIT_INSTR;
+        if (r.rd) flags |= COMMIT_RD;
+        if (r.load) flags |= COMMIT_LOAD;
+        if (r.store) flags |= COMMIT_STORE;
+
+        buffer.push_back(flags);
+        for (uint64_t delta = r.cycle - prev_cycle;; delta >>= 7) {
+            if (delta < 0x80) {
+                buffer.push_back((uint8_t)delta);
+                break;
+            }
+            buffer.push_back((uint8_t)(delta | 0x80));
+        }
+        if (!(flags & COMMIT_SEQUENTIAL)) put32(r.pc);
+        if (flags & COMMIT_INSTR) put32(r.instr);
+        if (r.rd) {
+            buffer.push_back(r.rd);
+            put32(r.rd_value);
+        }
+        if (r.load || r.store) put32(r.mem_addr);
+        if (r.store) put32(r.mem_data);
+
+        prev_cycle = r.cycle;
+        prev_pc = r.pc;
+        count++;
+        if (buffer.size() > BUFFER_SIZE - 32) hand_off();
+    }
+
+    // Write everything buffered and close the file
+    void close() {
+        if (!file) return;
+        hand_off();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_one();
+        writer.join();
+        std::fclose(file);
+        file = nullptr;
+    }
+
+private:
+    FILE* file = nullptr;
+    std::vector<uint8_t> buffer;
+    uint64_t prev_cycle = 0;
+    uint32_t prev_pc = 0;
+    std::unordered_set<uint32_t> seen_pcs;
+    uint64_t count = 0;
+
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::vector<uint8_t>> full; // buffers waiting for the writer thread
+    std::vector<std::vector<uint8_t>> spare; // written buffers, reused
+    bool stopping = false;
+
+    void put32(uint32_t value) {
+        for (int i = 0; i < 4; i++) buffer.push_back((uint8_t)(value >> (8 * i)));
+    }
+
+    void hand_off() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!buffer.empty()) full.push_back(std::move(buffer));
+        buffer.clear();
+        if (!spare.empty()) {
+            buffer = std::move(spare.back());
+            spare.pop_back();
+        }
+        buffer.reserve(BUFFER_SIZE);
+        ready.notify_one();
+    }
+
+    void write_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ready.wait(lock, [this]() { return stopping || !full.empty(); });
+            if (full.empty()) return; // stopping with nothing left
+            std::vector<uint8_t> out = std::move(full.front());
+            full.pop_front();
+            lock.unlock();
+            std::fwrite(out.data(), 1, out.size(), file);
+            out.clear();
+            lock.lock();
+            spare.push_back(std::move(out));
+        }
+    }
+};
+
+// Reads a log written by CommitLogWriter, record by record
+class CommitLogReader {
+public:
+    ~CommitLogReader() {
+        if (file) std::fclose(file);
+    }
+
+    bool open(const std::string& filename) {
+        file = std::fopen(filename.c_str(), "rb");
+        char magic[sizeof(COMMIT_LOG_MAGIC)];
+        return file && std::fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+               !std::memcmp(magic, COMMIT_LOG_MAGIC, sizeof(magic));
+    }
+
+    // False at the end of the log (or on a truncated record)
+    bool next(CommitRecord& r) {
+        int flags = std::fgetc(file);
+        if (flags == EOF) return false;
+        uint64_t delta = 0;
+        for (int shift = 0;; shift += 7) {
+            int byte = std::fgetc(file);
+            if (byte == EOF || shift > 63) return false;
+            delta |= (uint64_t)(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) break;
+        }
+        r = CommitRecord();
+        r.cycle = prev.cycle + delta;
+        bool ok = true;
+        r.pc = (flags & COMMIT_SEQUENTIAL) ? prev.pc + 4 : get32(ok);
+        if (flags & COMMIT_INSTR) instrs[r.pc] = get32(ok);
+        r.instr = instrs.count(r.pc) ? instrs[r.pc] : 0;
+        if (flags & COMMIT_RD) {
+            int rd = std::fgetc(file);
+            ok = ok && rd != EOF;
+            r.rd = (uint8_t)rd;
+            r.rd_value = get32(ok);
+        }
+        r.load = flags & COMMIT_LOAD;
+        r.store = flags & COMMIT_STORE;
+        if (r.load || r.store) r.mem_addr = get32(ok);
+        if (r.store) r.mem_data = get32(ok);
+        prev = r;
+        return ok;
+    }
+
+private:
+    FILE* file = nullptr;
+    CommitRecord prev;
+    std::unordered_map<uint32_t, uint32_t> instrs;
+
+    uint32_t get32(bool& ok) {
+        uint8_t b[4];
+        if (std::fread(b, 1, 4, file) != 4) {
+            ok = false;
+            return 0;
+        }
+        return b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+    }
+};
+
+// One line in the format of `spike --log-commits` (RV32, machine mode), optionally prefixed
+// with the cycle, e.g.
+//   core   0: 3 0x00000010 (0x00002083) x1  0x00000037 mem 0x00000000
+//   core   0: 3 0x0000001c (0x00202023) mem 0x00000000 0x00000059
+inline std::string spike_commit_line(const CommitRecord& r, bool with_cycle = false) {
+    char line[128];
+    int n = 0;
+    if (with_cycle) n += std::snprintf(line + n, sizeof(line) - n, "%10llu ", (unsigned long long)r.cycle);
+    n += std::snprintf(line + n, sizeof(line) - n, "core   0: 3 0x%08x (0x%08x)", r.pc, r.instr);
+    if (r.rd) n += std::snprintf(line + n, sizeof(line) - n, " x%-2d 0x%08x", r.rd, r.rd_value);
+    if (r.load || r.store) n += std::snprintf(line + n, sizeof(line) - n, " mem 0x%08x", r.mem_addr);
+    if (r.store) {
+        // Spike prints the stored value at the access width
+        switch ((r.instr >> 12) & 3) {
+            case 0: n += std::snprintf(line + n, sizeof(line) - n, " 0x%02x", r.mem_data & 0xFF); break;
+            case 1: n += std::snprintf(line + n, sizeof(line) - n, " 0x%04x", r.mem_data & 0xFFFF); break;
+            default: n += std::snprintf(line + n, sizeof(line) - n, " 0x%08x", r.mem_data); break;
+        }
+    }
+    return line;
+}
@@ -0,0 +1,45 @@
+// Converts a binary commit log (soc_tb --commit-log) to the text of `spike --log-commits`, so
+// a run can be diffed against the reference simulator:
+//   commit_log_spike [--cycles] fibo.commits [fibo.log]
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "commit_log.hpp"
+
+int main(int argc, char** argv) {
+    bool with_cycle = false;
+    const char* input = nullptr;
+    const char* output = nullptr;
+    for (int i = 1; i < argc; i++) {
+        if (!std::strcmp(argv[i], "--cycles"))
+            with_cycle = true;
+        else if (!input)
+            input = argv[i];
+        else if (!output)
+            output = argv[i];
+    }
+    if (!input) {
+        std::fprintf(stderr, "Usage: %s [--cycles] LOG.commits [OUT.log]\n"
+                             "  --cycles  prefix every line with the cycle the instruction retired in\n", argv[0]);
+        return 2;
+    }
+
+    CommitLogReader reader;
+    if (!reader.open(input)) {
+        std::fprintf(stderr, "%s: not a commit log\n", input);
+        return 1;
+    }
+    FILE* out = output ? std::fopen(output, "w") : stdout;
+    if (!out) {
+        std::fprintf(stderr, "Cannot write %s\n", output);
+        return 1;
+    }
+
+    CommitRecord r;
+    while (reader.next(r)) {
+        std::fputs(spike_commit_line(r, with_cycle).c_str(), out);
+        std::fputc('\n', out);
+    }
+    if (out != stdout) std::fclose(out);
+    return 0;
+}
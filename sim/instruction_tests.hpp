@@ -3,37 +3,137 @@
 #include <string>
 #include <vector>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
 #include <sstream>
+#include <unistd.h>
 #include <verilated.h>
-#include <verilated_vcd_c.h>
+#include <verilated_save.h>
+#if SOC_TRACE
+#include <verilated_fst_c.h>
+#endif
 #include "Vsoc_multicycle.h"
+#include "memory_map.hpp"
+#include "program_loader.hpp"
+#include "rv32i_iss.hpp"
+#include "sparse_memory.hpp"
+#include "latency_injector.hpp"
+#include "profiler.hpp"
+#include "commit_log.hpp"
+#include "workloads.hpp"
 
 # define CYCLE_LIMIT 50
-# define ROM_SIZE 1024
-# define RAM_SIZE 1024
 
-// Memory map
-// RAM: 4KB 32-bit words: 0x0000_0000 - 0x0000_0FFF
-#define RAM_BASE 0x00000000
-#define RAM_TOP  0x00000FFF
-// UART: 0x1000_0000 - 0x1000_00FF
-#define UART_BASE 0x10000000
-#define UART_TOP  0x100000FF
+// Build configuration, set by the Makefile
+#ifndef SOC_MULDIV_IMPL
+#define SOC_MULDIV_IMPL 0
+#endif
+#ifndef SOC_DCACHE
+#define SOC_DCACHE 0
+#endif
+// ROM/RAM data path behind the caches in bits (make MEM_WIDTH=...)
+#ifndef SOC_MEM_WIDTH
+#define SOC_MEM_WIDTH 32
+#endif
+// 1 = verilated with --trace-fst (make TRACE=1), otherwise the model has no trace code
+#ifndef SOC_TRACE
+#define SOC_TRACE 0
+#endif
+
+// Appended after every test program so the CPU halts as soon as the program is done
+# define ECALL 0x00000073
+# define NOP   0x00000013
 
 struct TestResult {
     std::string test_name;
     bool passed;
     std::string message;
+    int cycles; // cycles until the DUT halted
+};
+
+// Parts of a run a traced build records besides trace_enabled and the firmware's TRACE_CTRL.
+// Cycles count from reset, the PC trigger fires once per run.
+struct TraceTriggers {
+    uint64_t from_cycle = 0, to_cycle = 0; // window [from, to), empty = none
+    bool on_pc = false;
+    uint32_t pc = 0;
+    uint64_t pc_cycles = 0;                // cycles recorded once the PC is reached, 0 = the rest of the run
+};
+
+inline void print_results(const std::vector<TestResult>& results) {
+    for (const auto& result : results) {
+        std::cout << "Test: " << result.test_name << " - " << (result.passed ? "PASSED" : "FAILED!!!!!")
+                  << " (" << result.cycles << " cycles)\n";
+        if (!result.passed) {
+            std::cout << result.message;
+        }
+    }
+}
+
+// A fresh file under $TMPDIR (default /tmp) for a test's checkpoint or log, removed when the
+// test returns. `path` is empty if the file could not be created.
+struct TempFile {
+    std::string path;
+
+    explicit TempFile(const std::string& stem) {
+        const char* dir = std::getenv("TMPDIR");
+        std::string name = std::string(dir && *dir ? dir : "/tmp") + "/" + stem + ".XXXXXX";
+        int fd = mkstemp(&name[0]);
+        if (fd >= 0) {
+            close(fd);
+            path = name;
+        }
+    }
+    ~TempFile() {
+        if (!path.empty()) std::remove(path.c_str());
+    }
+    TempFile(const TempFile&) = delete;
+    TempFile& operator=(const TempFile&) = delete;
 };
 
 class InstructionTest {
 public:
+    // Every tester owns its own context and model, so testers can run on separate threads
+    VerilatedContext* contextp;
     Vsoc_multicycle* dut;
-    VerilatedVcdC* tfp = nullptr;
+#if SOC_TRACE
+    VerilatedFstC* tfp = nullptr; // opened when the first cycle is recorded
+#endif
     vluint64_t sim_time = 0;
-    bool vcd_enabled = false; // set to true to record waveforms for a specific test
+    uint64_t cycles_since_reset = 0;
+    bool idle_fast_forward = true; // skip cycles the CPU sleeps in WFI (never while tracing)
+    uint64_t idle_cycles_skipped = 0;
+
+    // Waveforms (traced builds only): the whole run with trace_enabled, else the triggers
+    bool trace_enabled = false; // set to true to record waveforms for a specific test
+    TraceTriggers trace_triggers;
+    bool tracing = false;       // the current cycle is recorded
+    uint64_t traced_cycles = 0;
+    std::string trace_file = "soc_tb.fst";
     std::vector<TestResult> results;
 
+    // Word ranges [begin, end) written by the loader, so the next load only clears those
+    size_t rom_touched_begin = 0, rom_touched_end = 0;
+    size_t ram_touched_begin = 0, ram_touched_end = 0;
+
+#if SOC_SPARSE_MEM
+    // ROM/RAM contents, reached by the model through its rom_store/ram_store handles
+    SparseMemory rom_store{ROM_SIZE, NOP};
+    SparseMemory ram_store{RAM_SIZE, 0};
+#endif
+
+    // Random memory latency, see set_jitter
+    LatencyInjector latency;
+
+    // Cycle attribution to PC, core state and bus waits, collected while `profiling` is set
+    bool profiling = false;
+    CycleProfiler profile{profile_state_names()};
+
+    // Binary retirement trace, written while open (commit_log.open(file))
+    CommitLogWriter commit_log;
+
     // Helper function to convert uint32_t to hexadecimal string
     std::string to_hex(uint32_t value) {
         std::stringstream ss;
@@ -42,33 +142,178 @@ public:
     }
 
     InstructionTest() {
-        dut = new Vsoc_multicycle;
+        contextp = new VerilatedContext;
+#if SOC_TRACE
+        contextp->traceEverOn(true);
+#endif
+        dut = new Vsoc_multicycle(contextp);
+        attach_host_models();
     }
 
     ~InstructionTest() {
+#if SOC_TRACE
+        if (tfp) {
+            tfp->close();
+            delete tfp;
+        }
+#endif
+        dut->final();
         delete dut;
+        delete contextp;
     }
 
-    // Load instructions into ROM
-    void load_instructions(const std::vector<uint32_t>& instructions) {
-        for (size_t i = 0; i < instructions.size(); i++) {
-            dut->soc_multicycle__DOT__rom_inst__DOT__rom_mem[i] = instructions[i];
-        }
+#if SOC_TRACE
+    // Attach an FST writer the first time a cycle is recorded
+    void open_trace() {
+        tfp = new VerilatedFstC;
+        dut->trace(tfp, 99);
+        tfp->open(trace_file.c_str());
+    }
+#endif
+
+    // Point the model at this tester's sparse stores and latency injector (again after
+    // restoring a checkpoint)
+    void attach_host_models() {
+#if SOC_SPARSE_MEM
+        dut->rom_store = reinterpret_cast<uintptr_t>(&rom_store);
+        dut->ram_store = reinterpret_cast<uintptr_t>(&ram_store);
+#endif
+        dut->latency_injector = latency.active() ? reinterpret_cast<uintptr_t>(&latency) : 0;
+    }
 
-        // Fill remaining ROM with NOPs (0x00000013)
-        for (size_t i = instructions.size(); i < ROM_SIZE; i++) {
-            dut->soc_multicycle__DOT__rom_inst__DOT__rom_mem[i] = 0x00000013;
+    // Fixed ROM/RAM/UART latency in cycles (1-255), 0 keeps the build's *_LATENCY parameter.
+    // Takes effect from the next request, no rebuild needed.
+    void set_latency(int imem, int dmem, int uart = 0) {
+        dut->imem_latency = imem;
+        dut->dmem_latency = dmem;
+        dut->uart_latency = uart;
+    }
+
+    // Random extra cycles per request of a region, on top of its fixed latency. The draws
+    // follow latency.reseed(seed) and start with the request after the current one.
+    void set_jitter(LatencyRegion region, const JitterDistribution& jitter) {
+        latency.jitter[region] = jitter;
+        attach_host_models();
+    }
+
+#if !SOC_SPARSE_MEM
+    // Direct pointers to the Verilated memory arrays (contiguous words)
+    uint32_t* rom_words() {
+        return &dut->soc_multicycle__DOT__rom_inst__DOT__rom_mem[0];
+    }
+
+    uint32_t* ram_words() {
+        return &dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[0];
+    }
+#endif
+
+    // Copy a block of words into ROM/RAM and remember the touched range
+    void write_rom(size_t word_index, const uint32_t* words, size_t count) {
+#if SOC_SPARSE_MEM
+        rom_store.write(word_index, words, count);
+#else
+        std::memcpy(rom_words() + word_index, words, count * sizeof(uint32_t));
+#endif
+        touch(rom_touched_begin, rom_touched_end, word_index, word_index + count);
+    }
+
+    void write_ram(size_t word_index, const uint32_t* words, size_t count) {
+#if SOC_SPARSE_MEM
+        ram_store.write(word_index, words, count);
+#else
+        std::memcpy(ram_words() + word_index, words, count * sizeof(uint32_t));
+#endif
+        touch(ram_touched_begin, ram_touched_end, word_index, word_index + count);
+    }
+
+    // Undo the previous load: NOPs in ROM, zeros in RAM, only over the ranges it wrote
+    // (sparse stores drop the pages those ranges cover)
+    void clear_loaded() {
+#if SOC_SPARSE_MEM
+        rom_store.clear(rom_touched_begin, rom_touched_end);
+        ram_store.clear(ram_touched_begin, ram_touched_end);
+#else
+        std::fill(rom_words() + rom_touched_begin, rom_words() + rom_touched_end, NOP);
+        std::fill(ram_words() + ram_touched_begin, ram_words() + ram_touched_end, 0);
+#endif
+        rom_touched_begin = rom_touched_end = 0;
+        ram_touched_begin = ram_touched_end = 0;
+    }
+
+    // Load instructions into ROM, followed by an ECALL that ends the program.
+    // Fails, leaving ROM empty, if the program and its ECALL do not fit.
+    bool load_instructions(const std::vector<uint32_t>& instructions) {
+        clear_loaded();
+        if (instructions.size() >= ROM_SIZE) return false;
+        write_rom(0, instructions.data(), instructions.size());
+        const uint32_t ecall = ECALL;
+        write_rom(instructions.size(), &ecall, 1);
+        return true;
+    }
+
+    // load_instructions for a test, a program that does not fit fails the test
+    bool load_test_program(const std::string& test_name, const std::vector<uint32_t>& instructions) {
+        if (load_instructions(instructions)) return true;
+        results.push_back({test_name, false,
+                           std::to_string(instructions.size()) + " instructions and the ECALL do not fit in ROM (" +
+                           std::to_string(ROM_SIZE) + " words)\n",
+                           0});
+        return false;
+    }
+
+    // Load an ELF/hex image segment by segment. Fails if a segment does not fit.
+    bool load_image(const ProgramImage& image, std::string& error) {
+        clear_loaded();
+        for (const auto& segment : image.rom) {
+            if (segment.address % 4 != 0 || segment.address / 4 + segment.words.size() > ROM_SIZE) {
+                error = "ROM segment at 0x" + to_hex(segment.address) + " does not fit in ROM";
+                return false;
+            }
+            write_rom(segment.address / 4, segment.words.data(), segment.words.size());
+        }
+        for (const auto& segment : image.ram) {
+            if (segment.address % 4 != 0 || segment.address > RAM_TOP ||
+                (segment.address - RAM_BASE) / 4 + segment.words.size() > RAM_SIZE) {
+                error = "RAM segment at 0x" + to_hex(segment.address) + " does not fit in RAM";
+                return false;
+            }
+            write_ram((segment.address - RAM_BASE) / 4, segment.words.data(), segment.words.size());
         }
+        return true;
     }
 
     void dump() {
-        if (tfp && vcd_enabled) tfp->dump(sim_time);
+#if SOC_TRACE
+        if (tracing) {
+            if (!tfp) open_trace();
+            tfp->dump(sim_time);
+        }
+#endif
         sim_time++;
     }
 
-    // Run the simulation for a specified number of cycles
-    void run_simulation(int cycles = CYCLE_LIMIT) {
-        // Reset the DUT for 1 cycle
+#if SOC_TRACE
+    // Whether the cycle about to be clocked is recorded
+    void update_trace() {
+        const TraceTriggers& t = trace_triggers;
+        if (t.on_pc && !pc_triggered && dut->pc == t.pc) {
+            pc_triggered = true;
+            pc_trace_end = t.pc_cycles ? cycles_since_reset + t.pc_cycles : UINT64_MAX;
+        }
+        tracing = trace_enabled || dut->trace_on ||
+                  (cycles_since_reset >= t.from_cycle && cycles_since_reset < t.to_cycle) ||
+                  (pc_triggered && cycles_since_reset < pc_trace_end);
+        if (tracing) traced_cycles++;
+    }
+#endif
+
+    // Reset the DUT for 1 cycle (the PC comes up at dut->reset_vector)
+    void reset() {
+        cycles_since_reset = 0;
+#if SOC_TRACE
+        tracing = trace_enabled;
+        pc_triggered = false;
+#endif
         dut->clk = 0;
         dut->rst = 1;
         dut->eval(); dump();
@@ -82,17 +327,258 @@ public:
 
         dut->clk = 1;
         dut->eval(); dump();
+        if (profiling) profile_sync();
+    }
 
-        // Main simulation loop
-        for (int i = 0; i < cycles; i++) {
-            // Loopback for UART
-            dut->uart_rx = dut->uart_tx;
+    // Advance one clock cycle. Returns true if an instruction retired on this edge.
+    bool tick() {
+        // Loopback for UART
+        dut->uart_rx = dut->uart_tx;
+#if SOC_TRACE
+        update_trace();
+#endif
 
-            dut->clk = 0;
-            dut->eval(); dump();
-            dut->clk = 1;
-            dut->eval(); dump();
+        dut->clk = 0;
+        dut->eval(); dump();
+        bool retired = dut->retire;
+        const bool logging = retired && commit_log.is_open();
+        CommitRecord commit;
+        if (profiling || commit_log.is_open()) sample_cycle();
+        if (logging) commit_begin(commit);
+        dut->clk = 1;
+        dut->eval(); dump();
+        if (profiling) profile_record(retired);
+        if (logging) commit_end(commit);
+        cycles_since_reset++;
+        return retired;
+    }
+
+    // Target time in cycles (CLINT mtime)
+    uint64_t read_mtime() {
+        return dut->soc_multicycle__DOT__clint_inst__DOT__mtime;
+    }
+
+    // Idle cycles that can be skipped in one jump, at most `budget`. While the CPU sleeps in WFI
+    // only mcycle, mtime and the UART bit timers move, so the jump stops one cycle short of the
+    // next UART bit boundary (or of a state where the lines can still change) and when mtime
+    // reaches mtimecmp. Nothing is skipped once the timer is due, the core has to be clocked
+    // to take the interrupt.
+    int idle_skip_limit(int budget) {
+        if (!idle_fast_forward || tracing || !dut->cpu_idle) return 0;
+
+        const uint32_t baud = dut->soc_multicycle__DOT__uart_inst__DOT__baud_rate_reg;
+        const uint32_t tx_state = dut->soc_multicycle__DOT__uart_inst__DOT__tx_state;
+        const uint32_t tx_count = dut->soc_multicycle__DOT__uart_inst__DOT__tx_cycle_count;
+        const uint32_t rx_state = dut->soc_multicycle__DOT__uart_inst__DOT__rx_state;
+        const uint32_t rx_count = dut->soc_multicycle__DOT__uart_inst__DOT__rx_cycle_count;
+        if (baud == 0 || dut->soc_multicycle__DOT__uart_inst__DOT__rx_done) return 0;
+
+        int64_t limit = budget;
+#if SOC_TRACE
+        // Wake up for the trace window
+        if (trace_triggers.from_cycle > cycles_since_reset && trace_triggers.from_cycle < trace_triggers.to_cycle)
+            limit = std::min<int64_t>(limit, trace_triggers.from_cycle - cycles_since_reset);
+#endif
+        const uint64_t mtime = dut->soc_multicycle__DOT__clint_inst__DOT__mtime;
+        const uint64_t mtimecmp = dut->soc_multicycle__DOT__clint_inst__DOT__mtimecmp;
+        if (mtime >= mtimecmp) return 0;
+        if (mtimecmp - mtime < (uint64_t)limit) limit = (int64_t)(mtimecmp - mtime);
+        if (tx_state == 0) {
+            // Idle Tx only stays idle with nothing queued
+            if (dut->soc_multicycle__DOT__uart_inst__DOT__tx_fifo__DOT__level != 0) return 0;
+        } else {
+            // The line settles one cycle after entering a state
+            if (tx_count == 0) return 0;
+            limit = std::min<int64_t>(limit, (int64_t)baud - 1 - tx_count);
+        }
+        if (rx_state == 0) {
+            if (!dut->uart_tx) return 0; // start bit on the loopback
+        } else if (rx_state == 1) {
+            limit = std::min<int64_t>(limit, (int64_t)(baud / 2) - rx_count);
+        } else {
+            limit = std::min<int64_t>(limit, (int64_t)baud - 1 - rx_count);
         }
+        return limit > 0 ? (int)limit : 0;
+    }
+
+    // Jump over `cycles` idle cycles by advancing what they would have advanced, then settle
+    // the logic that depends on them (timer_irq, cpu_idle)
+    void skip_idle_cycles(int cycles) {
+        dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__mcycle += cycles;
+        dut->soc_multicycle__DOT__clint_inst__DOT__mtime += cycles;
+        if (dut->soc_multicycle__DOT__uart_inst__DOT__tx_state != 0)
+            dut->soc_multicycle__DOT__uart_inst__DOT__tx_cycle_count += cycles;
+        if (dut->soc_multicycle__DOT__uart_inst__DOT__rx_state != 0)
+            dut->soc_multicycle__DOT__uart_inst__DOT__rx_cycle_count += cycles;
+        dut->eval();
+        sim_time += 2 * (vluint64_t)cycles;
+        cycles_since_reset += cycles;
+        idle_cycles_skipped += cycles;
+        if (profiling) profile.add(instr_pc, cycle_state, false, cycles);
+    }
+
+    // One step of the run loops: a jump over idle cycles or a single tick.
+    // Returns the cycles advanced, `retired` is set if an instruction retired.
+    int advance(int budget, bool& retired) {
+        int skip = idle_skip_limit(budget);
+        if (skip > 0) {
+            skip_idle_cycles(skip);
+            retired = false;
+            return skip;
+        }
+        retired = tick();
+        return 1;
+    }
+
+    // Clock until the DUT halts or the cycle budget runs out, returns the cycles simulated
+    int run_cycles(int cycles) {
+        int i = 0;
+        bool retired;
+        while (i < cycles && !dut->halted) {
+            i += advance(cycles - i, retired);
+        }
+        return i;
+    }
+
+    // Clock until `instructions` more instructions have retired (the CPU is then between instructions),
+    // the DUT halts or the cycle budget runs out. Returns the cycles simulated.
+    int run_instructions(uint64_t instructions, int cycles) {
+        int i = 0;
+        bool retired;
+        while (instructions > 0 && i < cycles && !dut->halted) {
+            i += advance(cycles - i, retired);
+            if (retired) instructions--;
+        }
+        return i;
+    }
+
+    // Write the data cache's dirty lines back to RAM and invalidate it, so read_memory sees
+    // what the program stored. Without DCACHE there is nothing to write back and the model is
+    // not clocked, so a run ends on the cycle it halted.
+    void flush_dcache() {
+#if SOC_DCACHE
+        dut->dcache_flush = 1;
+        tick();
+        dut->dcache_flush = 0;
+        while (dut->dcache_busy) tick();
+#endif
+    }
+
+    // Save the complete model state (needs verilator --savable): memories, register file,
+    // controller/bus/UART FSMs, plus the harness time. Can be restored into any tester.
+    bool save_checkpoint(const std::string& filename) {
+        VerilatedSave os;
+        os.open(filename.c_str());
+        if (!os.isOpen()) return false;
+        os << sim_time;
+        os << *dut;
+#if SOC_SPARSE_MEM
+        rom_store.save(os);
+        ram_store.save(os);
+#endif
+        latency.save(os);
+        os.close();
+        return true;
+    }
+
+    bool restore_checkpoint(const std::string& filename) {
+        VerilatedRestore os;
+        os.open(filename.c_str());
+        if (!os.isOpen()) return false;
+        os >> sim_time;
+        os >> *dut;
+#if SOC_SPARSE_MEM
+        rom_store.restore(os);
+        ram_store.restore(os);
+#endif
+        latency.restore(os);
+        os.close();
+        attach_host_models();
+        if (profiling) profile_sync();
+        return true;
+    }
+
+    // Run the simulation from reset until the DUT halts or the cycle budget runs out.
+    // Returns the number of cycles actually simulated after reset.
+    int run_simulation(int cycles = CYCLE_LIMIT) {
+        reset();
+        return run_cycles(cycles);
+    }
+
+    // Start an ISS from the program currently loaded in ROM/RAM
+    void init_iss(Rv32iIss& iss) {
+#if SOC_SPARSE_MEM
+        rom_store.copy_to(iss.rom.data(), ROM_SIZE);
+        ram_store.copy_to(iss.ram.data(), RAM_SIZE);
+#else
+        std::memcpy(iss.rom.data(), rom_words(), ROM_SIZE * sizeof(uint32_t));
+        std::memcpy(iss.ram.data(), ram_words(), RAM_SIZE * sizeof(uint32_t));
+#endif
+    }
+
+    // Execute the first `instructions` instructions on the ISS at host speed, then hand the
+    // architectural state (PC, registers, RAM, UART baud rate and timer) to the RTL and continue
+    // cycle-accurately. Hand over while the UART is idle, its shift registers are not copied.
+    // Returns the RTL cycles simulated.
+    int run_fast_forward(uint64_t instructions, int cycles, Rv32iIss& iss) {
+        init_iss(iss);
+        iss.run(instructions);
+
+        dut->reset_vector = iss.pc;
+        reset();
+        dut->reset_vector = 0;
+
+        for (int i = 1; i < 32; i++) {
+            write_register(i, iss.regs[i]);
+        }
+#if SOC_SPARSE_MEM
+        ram_store.copy_from(iss.ram.data(), RAM_SIZE);
+#else
+        std::memcpy(ram_words(), iss.ram.data(), RAM_SIZE * sizeof(uint32_t));
+#endif
+        dut->soc_multicycle__DOT__uart_inst__DOT__baud_rate_reg = iss.uart_baud;
+        dut->soc_multicycle__DOT__clint_inst__DOT__mtime = iss.mtime;
+        dut->soc_multicycle__DOT__clint_inst__DOT__mtimecmp = iss.mtimecmp;
+
+        return run_cycles(cycles);
+    }
+
+    // Run the RTL with the ISS stepped once per retirement, comparing PC and registers.
+    // MMIO loads and counter reads take the value the RTL saw, timing is not modeled by the ISS.
+    // Returns the cycles simulated, `mismatch` describes the first divergence (empty if none).
+    int run_lockstep(int cycles, Rv32iIss& iss, std::string& mismatch) {
+        init_iss(iss);
+        reset();
+
+        int i = 0;
+        while (i < cycles && !dut->halted && mismatch.empty()) {
+            uint32_t pc = iss.pc;
+            bool retired = tick();
+            i++;
+            if (!retired) continue;
+
+            if (!iss.step()) {
+                mismatch = "ISS stopped on illegal instruction at PC 0x" + to_hex(pc) + "\n";
+                break;
+            }
+            if (iss.last_sync_rd) {
+                iss.regs[iss.last_sync_rd] = read_register(iss.last_sync_rd);
+            }
+
+            if (dut->pc != iss.pc) {
+                mismatch += "PC: expected 0x" + to_hex(iss.pc) + ", got 0x" + to_hex(dut->pc) + "\n";
+            }
+            for (int r = 1; r < 32; r++) {
+                if (read_register(r) != iss.regs[r]) {
+                    mismatch += "Register x" + std::to_string(r) + ": expected 0x" + to_hex(iss.regs[r]) +
+                                ", got 0x" + to_hex(read_register(r)) + "\n";
+                }
+            }
+            if (!mismatch.empty()) {
+                mismatch = "After instruction at PC 0x" + to_hex(pc) + " (cycle " + std::to_string(i) + "):\n" + mismatch;
+            }
+        }
+        return i;
     }
 
     uint32_t read_register(int reg_num) {
@@ -100,22 +586,96 @@ public:
             return 0; // x0 is always 0
         }
 
-        return dut->soc_multicycle__DOT__cpu_inst__DOT__regfile_inst__DOT__registers[reg_num];
+        return dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__regfile_inst__DOT__registers[reg_num];
+    }
+
+    void write_register(int reg_num, uint32_t value) {
+        if (reg_num == 0) return;
+        dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__regfile_inst__DOT__registers[reg_num] = value;
+    }
+
+    uint32_t read_rom(size_t word_index) {
+#if SOC_SPARSE_MEM
+        return rom_store.read(word_index);
+#else
+        return rom_words()[word_index % ROM_SIZE];
+#endif
     }
 
     uint32_t read_memory(int word_index) {
+#if SOC_SPARSE_MEM
+        return ram_store.read(word_index);
+#else
         return dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[word_index];
+#endif
+    }
+
+    // Preset a RAM word before the program runs (not undone by the next load)
+    void write_memory(int word_index, uint32_t value) {
+#if SOC_SPARSE_MEM
+        ram_store.write(word_index, value);
+#else
+        dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[word_index] = value;
+#endif
+    }
+
+    // x0-x31, four registers per line
+    std::string dump_registers() {
+        std::stringstream ss;
+        for (int i = 0; i < 32; i++) {
+            ss << (i < 10 ? " x" : "x") << i << " = 0x" << std::hex;
+            ss.width(8);
+            ss.fill('0');
+            ss << read_register(i) << std::dec << ((i % 4 == 3) ? "\n" : "   ");
+        }
+        return ss.str();
     }
 
     void run_test(const std::string& test_name, const std::vector<uint32_t>& instructions,
                   const std::vector<std::pair<int, uint32_t>>& expected_registers,
                   const std::vector<std::pair<int, uint32_t>>& expected_memory,
                   int cycles = CYCLE_LIMIT) {
-        load_instructions(instructions);
-        run_simulation(cycles);
+        if (!load_test_program(test_name, instructions)) return;
+        int cycles_run = run_simulation(cycles);
+
+        check_results(test_name, expected_registers, expected_memory, cycles, cycles_run);
+    }
+
+    // Run a bundled workload (workloads.hpp). The result message holds the instructions
+    // retired, the CPI and the result word, whether or not it passed.
+    void run_workload(const Workload& workload) {
+        if (!load_test_program(std::string(workload.name) + ": " + workload.description, workload.program)) return;
+        int cycles_run = run_simulation(workload.max_cycles);
+        const uint64_t instructions = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__minstret;
+        flush_dcache();
+        const uint32_t result = read_memory(WORKLOAD_RESULT_WORD);
+
+        char line[160];
+        std::snprintf(line, sizeof(line), "%llu instructions, CPI %.2f, result 0x%08x\n",
+                      (unsigned long long)instructions, instructions ? (double)cycles_run / instructions : 0.0, result);
+        std::string message = line;
+        bool passed = dut->halted && dut->tohost == 1 && result == workload.expected;
+        if (!dut->halted) {
+            message += "Did not halt within " + std::to_string(workload.max_cycles) + " cycles\n";
+        } else if (result != workload.expected) {
+            message += "Expected result 0x" + to_hex(workload.expected) + ", TOHOST = 0x" + to_hex(dut->tohost) + "\n";
+        }
+        results.push_back({std::string(workload.name) + ": " + workload.description, passed, message, cycles_run});
+    }
+
+    // Compare the DUT state after a run against the expected values and record the result
+    void check_results(const std::string& test_name,
+                       const std::vector<std::pair<int, uint32_t>>& expected_registers,
+                       const std::vector<std::pair<int, uint32_t>>& expected_memory,
+                       int cycles, int cycles_run, std::string message = "") {
+        bool passed = message.empty();
 
-        bool passed = true;
-        std::string message;
+        flush_dcache();
+
+        if (!dut->halted) {
+            passed = false;
+            message += "Did not halt within " + std::to_string(cycles) + " cycles\n";
+        }
 
         // Check register values
         for (const auto& [reg_num, expected_value] : expected_registers) {
@@ -137,15 +697,119 @@ public:
             }
         }
 
-        results.push_back({test_name, passed, message});
+        results.push_back({test_name, passed, message, cycles_run});
     }
 
     void print_results() {
-        for (const auto& result : results) {
-            std::cout << "Test: " << result.test_name << " - " << (result.passed ? "PASSED" : "FAILED!!!!!") << "\n";
-            if (!result.passed) {
-                std::cout << result.message;
-            }
+        ::print_results(results);
+    }
+
+    // Write the profile as folded stacks (flamegraph input) and as a summary table
+    void write_profile(std::ostream& folded, std::ostream& summary, size_t top = 20) {
+        auto instr_at = [this](uint32_t pc) { return read_rom(pc / 4); };
+        profile.write_folded(folded, instr_at);
+        profile.write_summary(summary, instr_at, top);
+    }
+
+private:
+    // Profiler and commit log state: the PC of the instruction in flight, the PC and core
+    // state of the cycle being clocked, and the stall counters (mhpmcounter3-6) after the last edge
+    uint32_t instr_pc = 0, cycle_pc = 0;
+    unsigned cycle_state = 0;
+    uint64_t profile_counters[4] = {};
+
+#if SOC_TRACE
+    bool pc_triggered = false;
+    uint64_t pc_trace_end = 0;
+#endif
+
+    // Names of the states passed to profile.add: the multicycle controller states by encoding,
+    // or for the pipelined core the stall its counters report
+    static std::vector<std::string> profile_state_names() {
+#if CORE_PIPELINED
+        return {"RUN", "FETCH_WAIT", "MEMORY_WAIT", "MULDIV"};
+#else
+        return {"FETCH", "DECODE", "EXECUTE", "MEMORY", "WRITEBACK", "FETCH_WAIT",
+                "MEMORY_WAIT", "HALT", "WFI", "MULDIV"};
+#endif
+    }
+
+    void stall_counters(uint64_t (&counters)[4]) {
+        counters[0] = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__mhpmcounter3;
+        counters[1] = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__mhpmcounter4;
+        counters[2] = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__mhpmcounter5;
+        counters[3] = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__mhpmcounter6;
+    }
+
+    void profile_sync() {
+        stall_counters(profile_counters);
+    }
+
+    // Before the edge: which instruction the cycle belongs to. The multicycle core's PC moves
+    // on in DECODE, so the instruction's PC is latched there; fetch cycles belong to the
+    // instruction being fetched. The pipelined core reports the next instruction to retire.
+    void sample_cycle() {
+#if CORE_PIPELINED
+        cycle_pc = dut->pc;
+#else
+        cycle_state = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__ctrl_inst__DOT__state;
+        if (cycle_state == 1) instr_pc = dut->pc; // DECODE
+        cycle_pc = (cycle_state == 0 || cycle_state == 5) ? dut->pc : instr_pc;
+#endif
+    }
+
+    // After the edge: the stall counters that moved tell the bus wait (and the pipelined
+    // core's state). A CSR write to a counter can miscount one cycle.
+    void profile_record(bool retired) {
+        uint64_t counters[4];
+        stall_counters(counters);
+        bool moved[4];
+        for (int i = 0; i < 4; i++) moved[i] = counters[i] == profile_counters[i] + 1;
+        std::copy(counters, counters + 4, profile_counters);
+#if CORE_PIPELINED
+        cycle_state = moved[1] ? 2 : moved[0] ? 1 : moved[3] ? 3 : 0;
+        instr_pc = cycle_pc;
+#endif
+        profile.add(cycle_pc, cycle_state, moved[2]);
+        if (retired) profile.retire(cycle_pc);
+    }
+
+    // Commit log, before the retiring edge: the instruction and its memory access. Older
+    // instructions have all written back and this one not yet, so the register file holds
+    // its source operands.
+    void commit_begin(CommitRecord& commit) {
+        const uint32_t instr = read_rom(cycle_pc / 4);
+        const uint32_t opcode = instr & 0x7F;
+        const uint32_t rs1 = read_register((instr >> 15) & 0x1F);
+        commit.pc = cycle_pc;
+        commit.instr = instr;
+        if (opcode == 0x03) {
+            commit.load = true;
+            commit.mem_addr = rs1 + ((int32_t)instr >> 20);
+        } else if (opcode == 0x23) {
+            commit.store = true;
+            commit.mem_addr = rs1 + (((int32_t)instr >> 25 << 5) | ((instr >> 7) & 0x1F));
+            commit.mem_data = read_register((instr >> 20) & 0x1F);
+        }
+        // Everything but stores, branches and ECALL/EBREAK/MRET/WFI writes rd
+        const bool writes_rd = opcode != 0x23 && opcode != 0x63 && !(opcode == 0x73 && ((instr >> 12) & 7) == 0);
+        if (writes_rd) commit.rd = (instr >> 7) & 0x1F;
+    }
+
+    // After the edge: the result and the cycle
+    void commit_end(CommitRecord& commit) {
+        commit.cycle = dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__mcycle;
+        if (commit.rd) commit.rd_value = read_register(commit.rd);
+        commit_log.append(commit);
+    }
+
+    static void touch(size_t& begin, size_t& end, size_t first, size_t last) {
+        if (begin == end) {
+            begin = first;
+            end = last;
+        } else {
+            begin = std::min(begin, first);
+            end = std::max(end, last);
         }
     }
 };
@@ -448,12 +1112,227 @@ void test_and(InstructionTest& tester) {
     );
 }
 
+// RV32M: operands x1 = -7, x2 = 3 unless noted, edge cases in the same program
+void test_mul(InstructionTest& tester) {
+    // ASM:
+    //   addi x1, x0, -7      # x1 = -7
+    //   addi x2, x0, 3       # x2 = 3
+    //   mul  x3, x1, x2      # x3 = -21
+    tester.run_test(
+        "MUL: x3 = -7 * 3 = -21",
+        { 0xFF900093,   // addi x1, x0, -7
+          0x00300113,   // addi x2, x0, 3
+          0x022081B3 }, // mul  x3, x1, x2
+        { {3, 0xFFFFFFEB} },
+        {}
+    );
+}
+
+void test_mulh(InstructionTest& tester) {
+    // ASM:
+    //   addi x1, x0, -7
+    //   addi x2, x0, 3
+    //   lui  x4, 0x80000     # x4 = -2^31
+    //   mulh x5, x4, x4      # x5 = (2^62) >> 32 = 0x40000000
+    //   mulh x6, x1, x2      # x6 = -21 >> 32 = -1
+    tester.run_test(
+        "MULH: high word of signed * signed",
+        { 0xFF900093,   // addi x1, x0, -7
+          0x00300113,   // addi x2, x0, 3
+          0x80000237,   // lui  x4, 0x80000
+          0x024212B3,   // mulh x5, x4, x4
+          0x02209333 }, // mulh x6, x1, x2
+        { {5, 0x40000000}, {6, 0xFFFFFFFF} },
+        {}
+    );
+}
+
+void test_mulhsu(InstructionTest& tester) {
+    // ASM:
+    //   addi   x1, x0, -7
+    //   addi   x2, x0, -1    # x2 = 2^32 - 1 as unsigned
+    //   mulhsu x3, x1, x2    # x3 = (-7 * (2^32 - 1)) >> 32 = -7
+    tester.run_test(
+        "MULHSU: high word of signed * unsigned",
+        { 0xFF900093,   // addi   x1, x0, -7
+          0xFFF00113,   // addi   x2, x0, -1
+          0x0220A1B3 }, // mulhsu x3, x1, x2
+        { {3, 0xFFFFFFF9} },
+        {}
+    );
+}
+
+void test_mulhu(InstructionTest& tester) {
+    // ASM:
+    //   addi  x2, x0, -1
+    //   mulhu x3, x2, x2     # x3 = ((2^32 - 1)^2) >> 32 = 0xFFFFFFFE
+    tester.run_test(
+        "MULHU: high word of unsigned * unsigned",
+        { 0xFFF00113,   // addi  x2, x0, -1
+          0x022131B3 }, // mulhu x3, x2, x2
+        { {3, 0xFFFFFFFE} },
+        {}
+    );
+}
+
+void test_div(InstructionTest& tester) {
+    // ASM:
+    //   addi x1, x0, -7
+    //   addi x2, x0, 3
+    //   div  x3, x1, x2      # x3 = -2 (rounds towards zero)
+    //   div  x5, x1, x0      # x5 = -1 (division by zero)
+    //   lui  x4, 0x80000
+    //   addi x7, x0, -1
+    //   div  x6, x4, x7      # x6 = -2^31 (overflow)
+    tester.run_test(
+        "DIV: signed, by zero and overflow",
+        { 0xFF900093,   // addi x1, x0, -7
+          0x00300113,   // addi x2, x0, 3
+          0x0220C1B3,   // div  x3, x1, x2
+          0x0200C2B3,   // div  x5, x1, x0
+          0x80000237,   // lui  x4, 0x80000
+          0xFFF00393,   // addi x7, x0, -1
+          0x02724333 }, // div  x6, x4, x7
+        { {3, 0xFFFFFFFE}, {5, 0xFFFFFFFF}, {6, 0x80000000} },
+        {}
+    );
+}
+
+void test_divu(InstructionTest& tester) {
+    // ASM:
+    //   addi x1, x0, -7      # x1 = 0xFFFFFFF9
+    //   addi x2, x0, 5
+    //   divu x3, x1, x2      # x3 = 0x33333331
+    //   divu x5, x1, x0      # x5 = 0xFFFFFFFF (division by zero)
+    tester.run_test(
+        "DIVU: unsigned and by zero",
+        { 0xFF900093,   // addi x1, x0, -7
+          0x00500113,   // addi x2, x0, 5
+          0x0220D1B3,   // divu x3, x1, x2
+          0x0200D2B3 }, // divu x5, x1, x0
+        { {3, 0x33333331}, {5, 0xFFFFFFFF} },
+        {}
+    );
+}
+
+void test_rem(InstructionTest& tester) {
+    // ASM:
+    //   addi x1, x0, -7
+    //   addi x2, x0, 3
+    //   rem  x3, x1, x2      # x3 = -1 (sign of the dividend)
+    //   rem  x5, x1, x0      # x5 = -7 (division by zero)
+    //   lui  x4, 0x80000
+    //   addi x7, x0, -1
+    //   rem  x6, x4, x7      # x6 = 0 (overflow)
+    tester.run_test(
+        "REM: signed, by zero and overflow",
+        { 0xFF900093,   // addi x1, x0, -7
+          0x00300113,   // addi x2, x0, 3
+          0x0220E1B3,   // rem  x3, x1, x2
+          0x0200E2B3,   // rem  x5, x1, x0
+          0x80000237,   // lui  x4, 0x80000
+          0xFFF00393,   // addi x7, x0, -1
+          0x02726333 }, // rem  x6, x4, x7
+        { {3, 0xFFFFFFFF}, {5, 0xFFFFFFF9}, {6, 0} },
+        {}
+    );
+}
+
+void test_remu(InstructionTest& tester) {
+    // ASM:
+    //   addi x1, x0, -7      # x1 = 0xFFFFFFF9
+    //   addi x2, x0, 5
+    //   remu x3, x1, x2      # x3 = 4
+    //   remu x5, x1, x0      # x5 = x1 (division by zero)
+    tester.run_test(
+        "REMU: unsigned and by zero",
+        { 0xFF900093,   // addi x1, x0, -7
+          0x00500113,   // addi x2, x0, 5
+          0x0220F1B3,   // remu x3, x1, x2
+          0x0200F2B3 }, // remu x5, x1, x0
+        { {3, 4}, {5, 0xFFFFFFF9} },
+        {}
+    );
+}
+
+void test_muldiv_speedup(InstructionTest& tester) {
+    // 0x123 * 0x80000001 as a shift-and-add loop (32 iterations) and as one MUL, timed on
+    // mcycle. The unit should win by an order of magnitude when single cycle and still
+    // a few times when iterative.
+    // ASM (software):
+    //   csrr x10, mcycle
+    //   lui  x2, 0x80000
+    //   addi x2, x2, 1               # multiplier
+    //   addi x1, x0, 0x123           # multiplicand
+    //   addi x3, x0, 0
+    // loop:
+    //   andi x4, x2, 1
+    //   beq  x4, x0, skip
+    //   add  x3, x3, x1
+    // skip:
+    //   slli x1, x1, 1
+    //   srli x2, x2, 1
+    //   bne  x2, x0, loop
+    //   csrr x11, mcycle
+    //   sub  x12, x11, x10
+    tester.run_test(
+        "MUL speedup: shift-and-add loop",
+        { 0xb0002573,   // csrr x10, mcycle
+          0x80000137,   // lui  x2, 0x80000
+          0x00110113,   // addi x2, x2, 1
+          0x12300093,   // addi x1, x0, 0x123
+          0x00000193,   // addi x3, x0, 0
+          0x00117213,   // andi x4, x2, 1
+          0x00020463,   // beq  x4, x0, 8
+          0x001181b3,   // add  x3, x3, x1
+          0x00109093,   // slli x1, x1, 1
+          0x00115113,   // srli x2, x2, 1
+          0xfe0116e3,   // bne  x2, x0, -20
+          0xb00025f3,   // csrr x11, mcycle
+          0x40a58633 }, // sub  x12, x11, x10
+        { {3, 0x80000123} },
+        {},
+        2000
+    );
+    uint32_t software_cycles = tester.read_register(12);
+
+    // ASM (hardware):
+    //   csrr x10, mcycle
+    //   lui  x2, 0x80000
+    //   addi x2, x2, 1
+    //   addi x1, x0, 0x123
+    //   mul  x3, x1, x2
+    //   csrr x11, mcycle
+    //   sub  x12, x11, x10
+    tester.run_test(
+        "MUL speedup: MUL instruction",
+        { 0xb0002573,   // csrr x10, mcycle
+          0x80000137,   // lui  x2, 0x80000
+          0x00110113,   // addi x2, x2, 1
+          0x12300093,   // addi x1, x0, 0x123
+          0x022081b3,   // mul  x3, x1, x2
+          0xb00025f3,   // csrr x11, mcycle
+          0x40a58633 }, // sub  x12, x11, x10
+        { {3, 0x80000123} },
+        {},
+        200
+    );
+    uint32_t hardware_cycles = tester.read_register(12);
+
+    uint32_t factor = SOC_MULDIV_IMPL == 0 ? 10 : 3;
+    bool passed = hardware_cycles * factor <= software_cycles;
+    tester.results.push_back({"MUL speedup: " + std::to_string(factor) + "x over software", passed,
+                              passed ? "" : "Software " + std::to_string(software_cycles) +
+                                            " cycles, MUL " + std::to_string(hardware_cycles) + " cycles\n",
+                              static_cast<int>(hardware_cycles)});
+}
+
 void test_lb(InstructionTest& tester) {
     // RAM word[0] is pre-filled with 0x000000AB before running.
     // ASM:
     //   addi x1, x0, 0       # x1 = 0 (base address)
     //   lb   x2, 0(x1)       # x2 = sign_ext(RAM[0][7:0]) = 0xAB -> 0xFFFFFFAB
-    tester.dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[0] = 0x000000AB;
+    tester.write_memory(0, 0x000000AB);
     tester.run_test(
         "LB: x2 = sign_ext(mem[0][7:0]) = 0xFFFFFFAB",
         { 0x00000093,   // addi x1, x0, 0
@@ -469,7 +1348,7 @@ void test_lh(InstructionTest& tester) {
     // ASM:
     //   addi x1, x0, 0       # x1 = 0
     //   lh   x2, 0(x1)       # x2 = sign_ext(0x8005) = 0xFFFF8005
-    tester.dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[0] = 0x00008005;
+    tester.write_memory(0, 0x00008005);
     tester.run_test(
         "LH: x2 = sign_ext(mem[0][15:0]) = 0xFFFF8005",
         { 0x00000093,   // addi x1, x0, 0
@@ -485,7 +1364,7 @@ void test_lw(InstructionTest& tester) {
     // ASM:
     //   addi x1, x0, 0       # x1 = 0
     //   lw   x2, 0(x1)       # x2 = 0xDEADBEEF
-    tester.dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[0] = 0xDEADBEEF;
+    tester.write_memory(0, 0xDEADBEEF);
     tester.run_test(
         "LW: x2 = mem[0] = 0xDEADBEEF",
         { 0x00000093,   // addi x1, x0, 0
@@ -501,7 +1380,7 @@ void test_lbu(InstructionTest& tester) {
     // ASM:
     //   addi x1, x0, 0
     //   lbu  x2, 0(x1)       # x2 = 0x000000AB (no sign extension)
-    tester.dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[0] = 0x000000AB;
+    tester.write_memory(0, 0x000000AB);
     tester.run_test(
         "LBU: x2 = zero_ext(mem[0][7:0]) = 0xAB",
         { 0x00000093,   // addi x1, x0, 0
@@ -517,7 +1396,7 @@ void test_lhu(InstructionTest& tester) {
     // ASM:
     //   addi x1, x0, 0
     //   lhu  x2, 0(x1)       # x2 = 0x00008005
-    tester.dut->soc_multicycle__DOT__ram_inst__DOT__ram_mem[0] = 0x00008005;
+    tester.write_memory(0, 0x00008005);
     tester.run_test(
         "LHU: x2 = zero_ext(mem[0][15:0]) = 0x8005",
         { 0x00000093,   // addi x1, x0, 0
@@ -730,6 +1609,262 @@ void test_bgeu(InstructionTest& tester) {
     );
 }
 
+void test_csr(InstructionTest& tester) {
+    // ASM:
+    //   addi   x1, x0, 0x55          # x1 = 0x55
+    //   csrrw  x0, mscratch, x1      # mscratch = 0x55
+    //   csrrs  x2, mscratch, x0      # x2 = 0x55 (read only, no write)
+    //   csrrsi x3, mscratch, 0x0A    # x3 = 0x55, mscratch = 0x5F
+    //   csrrci x4, mscratch, 0x05    # x4 = 0x5F, mscratch = 0x5A
+    //   csrr   x5, mscratch          # x5 = 0x5A
+    tester.run_test(
+        "CSR: CSRRW/CSRRS/CSRRSI/CSRRCI on mscratch",
+        { 0x05500093,   // addi   x1, x0, 0x55
+          0x34009073,   // csrrw  x0, mscratch, x1
+          0x34002173,   // csrrs  x2, mscratch, x0
+          0x340561f3,   // csrrsi x3, mscratch, 0x0A
+          0x3402f273,   // csrrci x4, mscratch, 0x05
+          0x340022f3 }, // csrr   x5, mscratch
+        { {2, 0x55}, {3, 0x55}, {4, 0x5F}, {5, 0x5A} },
+        {},
+        60
+    );
+}
+
+void test_counters(InstructionTest& tester) {
+    // minstret is read in EXECUTE, so it counts the instructions retired before the read.
+    // ASM:
+    //   csrr x1, minstret            # x1 = 0
+    //   nop
+    //   nop
+    //   csrr x2, minstret            # x2 = 3
+    //   sub  x3, x2, x1              # x3 = 3
+    //   csrr x4, mcycle
+    //   sltu x5, x0, x4              # x5 = (mcycle != 0) = 1
+    //   csrr x6, mhpmcounter3        # FETCH_WAIT cycles
+    //   sltu x7, x0, x6              # x7 = (FETCH_WAIT cycles != 0) = 1
+    tester.run_test(
+        "Counters: minstret delta = 3, mcycle and FETCH_WAIT counter running",
+        { 0xb02020f3,   // csrr x1, minstret
+          0x00000013,   // nop
+          0x00000013,   // nop
+          0xb0202173,   // csrr x2, minstret
+          0x401101b3,   // sub  x3, x2, x1
+          0xb0002273,   // csrr x4, mcycle
+          0x004032b3,   // sltu x5, x0, x4
+          0xb0302373,   // csrr x6, mhpmcounter3
+          0x006033b3 }, // sltu x7, x0, x6
+        { {1, 0}, {3, 3}, {5, 1}, {7, 1} },
+        {},
+        80
+    );
+}
+
+void test_hazards(InstructionTest& tester) {
+    // Back-to-back dependencies, a load-use pair and a taken branch with wrong-path instructions.
+    // Exercises forwarding, the load-use interlock and flushing on the pipelined core.
+    // ASM:
+    //   addi x1, x0, 5               # x1 = 5
+    //   addi x2, x1, 3               # x2 = 8   (x1 from the previous instruction)
+    //   add  x3, x1, x2              # x3 = 13  (x1 two back, x2 one back)
+    //   sw   x3, 0(x0)               # mem[0] = 13
+    //   lw   x4, 0(x0)               # x4 = 13
+    //   addi x5, x4, 1               # x5 = 14  (load-use)
+    //   beq  x5, x5, skip            # taken
+    //   addi x6, x0, 1               # skipped
+    //   addi x7, x0, 1               # skipped
+    // skip:
+    //   jal  x8, next                # x8 = 0x28
+    // next:
+    //   sub  x9, x8, x5              # x9 = 0x28 - 14 = 0x1A
+    tester.run_test(
+        "Hazards: forwarding, load-use and branch flush",
+        { 0x00500093,   // addi x1, x0, 5
+          0x00308113,   // addi x2, x1, 3
+          0x002081b3,   // add  x3, x1, x2
+          0x00302023,   // sw   x3, 0(x0)
+          0x00002203,   // lw   x4, 0(x0)
+          0x00120293,   // addi x5, x4, 1
+          0x00528663,   // beq  x5, x5, skip
+          0x00100313,   // addi x6, x0, 1
+          0x00100393,   // addi x7, x0, 1
+          0x0040046f,   // jal  x8, next
+          0x405404b3 }, // sub  x9, x8, x5
+        { {1, 5}, {2, 8}, {3, 13}, {4, 13}, {5, 14}, {6, 0}, {7, 0}, {8, 0x28}, {9, 0x1A} },
+        { {0, 13} },
+        100
+    );
+}
+
+void test_pipeline_throughput(InstructionTest& tester) {
+    // 16 dependent ALU instructions between two mcycle reads. The second read waits for the
+    // pipeline to drain (2 cycles), so 1 IPC gives a delta of 19 cycles.
+    // ASM:
+    //   csrr  x1, mcycle
+    //   addi  x5, x5, 1              # x 16
+    //   csrr  x2, mcycle
+    //   sub   x3, x2, x1
+    //   sltiu x4, x3, 21             # x4 = (delta <= 20)
+    tester.run_test(
+        "Pipeline: 16 dependent ALU instructions at 1 IPC",
+        { 0xb00020f3,   // csrr  x1, mcycle
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0xb0002173,   // csrr  x2, mcycle
+          0x401101b3,   // sub   x3, x2, x1
+          0x0151b213 }, // sltiu x4, x3, 21
+        { {4, 1}, {5, 16} },
+        {},
+        60
+    );
+}
+
+void test_overlapped_fetch(InstructionTest& tester) {
+    // Multicycle core: with the next instruction prefetched during DECODE/EXECUTE, ALU
+    // instructions take 2 cycles. 16 of them between two mcycle reads give a delta of 35
+    // (CSR WRITEBACK + 16 x 2 + DECODE/EXECUTE of the second read).
+    // ASM:
+    //   csrr  x1, mcycle
+    //   addi  x5, x5, 1              # x 16
+    //   csrr  x2, mcycle
+    //   sub   x3, x2, x1
+    //   sltiu x4, x3, 36             # x4 = (delta <= 35)
+    tester.run_test(
+        "Overlapped fetch: 16 ALU instructions at 2 cycles each",
+        { 0xb00020f3,   // csrr  x1, mcycle
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0x00128293,   // addi  x5, x5, 1
+          0xb0002173,   // csrr  x2, mcycle
+          0x401101b3,   // sub   x3, x2, x1
+          0x0241b213 }, // sltiu x4, x3, 36
+        { {4, 1}, {5, 16} },
+        {},
+        80
+    );
+}
+
+void test_store_buffer(InstructionTest& tester) {
+    // Loads right behind stores to the same word: forwarded from the store buffer when the
+    // buffered store covers them, otherwise they wait for it to drain.
+    // ASM:
+    //   lui  x1, 0x12345
+    //   addi x1, x1, 0x678           # x1 = 0x12345678
+    //   sw   x1, 8(x0)
+    //   lw   x2, 8(x0)               # x2 = 0x12345678 (forwarded)
+    //   lbu  x3, 9(x0)               # x3 = 0x56
+    //   sb   x0, 10(x0)              # mem[2] = 0x12005678
+    //   lh   x4, 10(x0)              # x4 = 0x1200 (byte store does not cover it)
+    //   lw   x5, 8(x0)               # x5 = 0x12005678
+    //   sh   x1, 12(x0)              # mem[3] = 0x5678
+    //   lhu  x6, 12(x0)              # x6 = 0x5678 (forwarded)
+    //   lb   x7, 13(x0)              # x7 = 0x56 (forwarded)
+    tester.run_test(
+        "Store buffer: store-to-load forwarding and partial overlap",
+        { 0x123450b7,   // lui  x1, 0x12345
+          0x67808093,   // addi x1, x1, 0x678
+          0x00102423,   // sw   x1, 8(x0)
+          0x00802103,   // lw   x2, 8(x0)
+          0x00904183,   // lbu  x3, 9(x0)
+          0x00000523,   // sb   x0, 10(x0)
+          0x00a01203,   // lh   x4, 10(x0)
+          0x00802283,   // lw   x5, 8(x0)
+          0x00101623,   // sh   x1, 12(x0)
+          0x00c05303,   // lhu  x6, 12(x0)
+          0x00d00383 }, // lb   x7, 13(x0)
+        { {2, 0x12345678}, {3, 0x56}, {4, 0x1200}, {5, 0x12005678}, {6, 0x5678}, {7, 0x56} },
+        { {2, 0x12005678}, {3, 0x00005678} },
+        100
+    );
+}
+
+// Shared with the ISS fast-forward/lockstep tests below
+const std::vector<uint32_t> FIBO_PROGRAM = {
+    0x00100093,
+    0x00102023,
+    0x00102223,
+    0x00a00513,
+    0x00002083,
+    0x00402103,
+    0x002081b3,
+    0x00202023,
+    0x00302223,
+    0x00100593,
+    0x40b50533,
+    0xfe0512e3 };
+
+void test_memory_size(InstructionTest& tester) {
+    // Store and load the last RAM word, wherever SOC_RAM_SIZE puts it (at least 4KB).
+    // ASM:
+    //   lui  x1, RAM_SIZE >> 12      # x1 = RAM_SIZE
+    //   lui  x2, 0x12345
+    //   addi x2, x2, 0x678
+    //   sw   x2, -4(x1)
+    //   lw   x3, -4(x1)              # x3 = 0x12345678
+    tester.run_test(
+        "Memory size: last RAM word",
+        { 0x000000b7 | (SOC_RAM_SIZE & 0xFFFFF000),   // lui  x1, RAM_SIZE >> 12
+          0x12345137,   // lui  x2, 0x12345
+          0x67810113,   // addi x2, x2, 0x678
+          0xfe20ae23,   // sw   x2, -4(x1)
+          0xffc0a183 }, // lw   x3, -4(x1)
+        { {3, 0x12345678} },
+        { {RAM_SIZE - 1, 0x12345678} }
+    );
+
+#if SOC_SPARSE_MEM
+    // One page each: the program in ROM and the last page of RAM
+    bool passed = tester.rom_store.pages() == 1 && tester.ram_store.pages() == 1;
+    tester.results.push_back({"Sparse memory: pages allocated on first touch", passed,
+                              passed ? "" : "Expected 1 ROM and 1 RAM page, got " +
+                                            std::to_string(tester.rom_store.pages()) + " and " +
+                                            std::to_string(tester.ram_store.pages()) + "\n",
+                              0});
+#endif
+
+    // A program filling the ROM up to the last word still gets its ECALL there, one word more
+    // leaves no room for it and is rejected
+    bool rejected = !tester.load_instructions(std::vector<uint32_t>(ROM_SIZE, NOP));
+    tester.run_test(
+        "Memory size: program filling the ROM",
+        std::vector<uint32_t>(ROM_SIZE - 1, NOP),
+        {},
+        {},
+        16 * ROM_SIZE
+    );
+    if (!rejected) {
+        tester.results.back().passed = false;
+        tester.results.back().message += "A program of " + std::to_string(ROM_SIZE) + " words was loaded\n";
+    }
+}
+
 void test_fibo(InstructionTest& tester) {
     // ASM:
     //   addi x1, x0, 1
@@ -749,31 +1884,561 @@ void test_fibo(InstructionTest& tester) {
     //   bne x10, x0, loop
     tester.run_test(
         "Fibonacci loop: computes 12th Fibonacci number = 144",
-        { 0x00100093,
-          0x00102023,
-          0x00102223,
-          0x00a00513,
-          0x00002083,
-          0x00402103,
-          0x002081b3,
-          0x00202023,
-          0x00302223,
-          0x00100593,
-          0x40b50533,
-          0xfe0512e3 },
+        FIBO_PROGRAM,
           { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
           { {0, 0x00000059}, {1, 0x00000090} },
           1000
     );
 }
 
+void test_icache(InstructionTest& tester) {
+    // Fibonacci again with the instruction cache enabled: only the first pass over each
+    // line misses, every loop iteration after that is served from the cache
+    tester.run_test(
+        "ICache: Fibonacci loop runs from the cache",
+        FIBO_PROGRAM,
+        { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
+        { {0, 0x00000059}, {1, 0x00000090} },
+        1000
+    );
+
+    uint32_t hits = tester.dut->icache_hits;
+    uint32_t misses = tester.dut->icache_misses;
+    bool passed = misses > 0 && hits >= 10 * misses;
+    tester.results.push_back({"ICache: hit/miss counters", passed,
+                              passed ? "" : "Expected >= 10 hits per miss, got " + std::to_string(hits) +
+                                            " hits and " + std::to_string(misses) + " misses\n",
+                              static_cast<int>(hits + misses)});
+
+    // Cycles per loop iteration (8 instructions) at a ROM latency of 1 and of 10: once the
+    // lines are filled, every iteration takes the same cycles and the ROM latency no longer
+    // shows. Two passes warm up, the pipelined core's fetch past the branch can refill the
+    // line after the loop while the second one starts.
+    std::vector<int> iterations[2];
+    const int rom_latency[2] = {1, 10};
+    for (int l = 0; l < 2; l++) {
+        tester.set_latency(rom_latency[l], 0);
+        tester.load_instructions(FIBO_PROGRAM);
+        tester.reset();
+        tester.run_instructions(4 + 2 * 8, 1000); // prologue and the refilling iterations
+        for (int i = 2; i < 10; i++) iterations[l].push_back(tester.run_instructions(8, 1000));
+    }
+    tester.set_latency(0, 0);
+
+    passed = true;
+    std::string message;
+    for (int l = 0; l < 2; l++) {
+        for (size_t i = 0; i < iterations[l].size(); i++) {
+            if (iterations[l][i] != iterations[0][0]) {
+                passed = false;
+                message += "ROM latency " + std::to_string(rom_latency[l]) + ", iteration " + std::to_string(i + 3) +
+                           ": " + std::to_string(iterations[l][i]) + " cycles, expected " +
+                           std::to_string(iterations[0][0]) + "\n";
+            }
+        }
+    }
+    tester.results.push_back({"ICache: loop iterations at hit latency with a 10-cycle ROM", passed, message,
+                              iterations[1].empty() ? 0 : iterations[1][0]});
+}
+
+void test_dcache(InstructionTest& tester) {
+    // Four stores 1KB apart map to the same set of the default 2-way cache, so the third and
+    // fourth evict dirty lines and the loads miss again and write back in turn. A byte store
+    // then merges into a cached word. The flush before the memory check writes the rest back.
+    // ASM:
+    //   addi x1, x0, 11
+    //   addi x2, x0, 1024
+    //   add  x3, x2, x2              # 2048
+    //   add  x4, x3, x2              # 3072
+    //   sw   x1, 0(x0)
+    //   sw   x2, 0(x2)
+    //   sw   x3, 0(x3)
+    //   sw   x4, 0(x4)
+    //   lw   x5, 0(x0)               # x5 = 11
+    //   lw   x6, 0(x2)               # x6 = 1024
+    //   lw   x7, 0(x3)               # x7 = 2048
+    //   lw   x8, 0(x4)               # x8 = 3072
+    //   addi x9, x0, 0x7F
+    //   sb   x9, 1(x0)               # mem[0] = 0x7F0B
+    //   lhu  x10, 0(x0)              # x10 = 0x7F0B
+    tester.run_test(
+        "DCache: dirty evictions, refills and byte merge",
+        { 0x00b00093,   // addi x1, x0, 11
+          0x40000113,   // addi x2, x0, 1024
+          0x002101b3,   // add  x3, x2, x2
+          0x00218233,   // add  x4, x3, x2
+          0x00102023,   // sw   x1, 0(x0)
+          0x00212023,   // sw   x2, 0(x2)
+          0x0031a023,   // sw   x3, 0(x3)
+          0x00422023,   // sw   x4, 0(x4)
+          0x00002283,   // lw   x5, 0(x0)
+          0x00012303,   // lw   x6, 0(x2)
+          0x0001a383,   // lw   x7, 0(x3)
+          0x00022403,   // lw   x8, 0(x4)
+          0x07f00493,   // addi x9, x0, 0x7F
+          0x009000a3,   // sb   x9, 1(x0)
+          0x00005503 }, // lhu  x10, 0(x0)
+        { {5, 11}, {6, 1024}, {7, 2048}, {8, 3072}, {10, 0x7F0B} },
+        { {0, 0x00007F0B}, {256, 1024}, {512, 2048}, {768, 3072} },
+        400
+    );
+
+    // The Fibonacci loop keeps its two words in one line
+    tester.run_test(
+        "DCache: Fibonacci loop runs from the cache",
+        FIBO_PROGRAM,
+        { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
+        { {0, 0x00000059}, {1, 0x00000090} },
+        1000
+    );
+
+    // One miss allocates the line, the 20 stores of the loop and the second prologue store
+    // hit (loads may be forwarded from the store buffer instead)
+    uint32_t hits = tester.dut->dcache_hits;
+    uint32_t misses = tester.dut->dcache_misses;
+    bool passed = misses == 1 && hits >= 21;
+    tester.results.push_back({"DCache: hit/miss counters", passed,
+                              passed ? "" : "Expected 1 miss and >= 21 hits, got " + std::to_string(hits) +
+                                            " hits and " + std::to_string(misses) + " misses\n",
+                              static_cast<int>(hits + misses)});
+
+    // Write-back: the store only dirties the cached line, RAM gets the word when the flush
+    // writes the line back
+    // ASM:
+    //   addi x1, x0, 0x5A
+    //   sw   x1, 64(x0)
+    tester.write_memory(16, 0);
+    tester.load_instructions({ 0x05a00093,    // addi x1, x0, 0x5A
+                               0x04102023 }); // sw   x1, 64(x0)
+    int cycles = tester.run_simulation(100);
+    const uint32_t before = tester.read_memory(16);
+    tester.flush_dcache();
+    const uint32_t after = tester.read_memory(16);
+    passed = tester.dut->halted && before == 0 && after == 0x5A;
+    tester.results.push_back({"DCache: dirty line reaches RAM on flush", passed,
+                              passed ? "" : "RAM[16] = 0x" + tester.to_hex(before) + " before the flush, 0x" +
+                                            tester.to_hex(after) + " after (expected 0 and 0x5A)\n",
+                              cycles});
+
+    // UART and CLINT accesses bypass the cache: nothing is counted and the second mtime read
+    // sees a later time rather than a cached copy
+    // ASM:
+    //   lui  x2, 0x10000             # UART base
+    //   addi x1, x0, 0x5A
+    //   sb   x1, 0(x2)               # UART_TX
+    // wait:
+    //   lw   x5, 8(x2)               # UART_STATUS
+    //   andi x5, x5, 2
+    //   beq  x5, x0, wait
+    //   lbu  x6, 4(x2)               # UART_RX = 0x5A
+    //   lui  x4, 0x200C              # CLINT mtime + 8
+    //   lw   x7, -8(x4)
+    //   lw   x8, -8(x4)
+    //   sltu x9, x7, x8              # x9 = 1
+    tester.run_test(
+        "DCache: UART and CLINT accesses are not cached",
+        { 0x10000137,   // lui  x2, 0x10000
+          0x05a00093,   // addi x1, x0, 0x5A
+          0x00110023,   // sb   x1, 0(x2)
+          0x00812283,   // lw   x5, 8(x2)
+          0x0022f293,   // andi x5, x5, 2
+          0xfe028ce3,   // beq  x5, x0, wait
+          0x00414303,   // lbu  x6, 4(x2)
+          0x0200c237,   // lui  x4, 0x200c
+          0xff822383,   // lw   x7, -8(x4)
+          0xff822403,   // lw   x8, -8(x4)
+          0x0083b4b3 }, // sltu x9, x7, x8
+        { {6, 0x5A}, {9, 1} },
+        {},
+        1000
+    );
+    if (tester.dut->dcache_hits != 0 || tester.dut->dcache_misses != 0) {
+        tester.results.back().passed = false;
+        tester.results.back().message += "Cache counted " + std::to_string(tester.dut->dcache_hits) + " hits and " +
+                                         std::to_string(tester.dut->dcache_misses) + " misses\n";
+    }
+}
+
+#if SOC_ICACHE || SOC_DCACHE
+// One line refill seen from the ROM/RAM side: cycles from the cache's request to the first beat,
+// the beats delivered and how many separate runs of consecutive cycles they came in
+struct RefillBurst {
+    int first_beat = 0;
+    int beats = 0;
+    int runs = 0;
+};
+
+// Run the Fibonacci program from reset and record every refill that starts during the run.
+// `refilling` reads the cache's refill state, `ready` the beat strobe of the memory behind it.
+template <typename Refilling, typename Ready>
+std::vector<RefillBurst> record_refills(InstructionTest& tester, Refilling refilling, Ready ready) {
+    std::vector<RefillBurst> bursts;
+    tester.load_instructions(FIBO_PROGRAM);
+    tester.reset();
+
+    bool active = false;
+    bool was_refilling = refilling(); // a refill already running at reset is not recorded
+    bool was_ready = false;
+    int waited = 0;
+    for (int i = 0; i < 2000 && !tester.dut->halted; i++) {
+        tester.tick();
+        const bool beat = ready();
+        if (active) {
+            waited++;
+            if (beat) {
+                RefillBurst& burst = bursts.back();
+                if (burst.beats == 0) burst.first_beat = waited;
+                if (!was_ready) burst.runs++;
+                burst.beats++;
+            }
+        }
+        const bool now = refilling();
+        if (now && !was_refilling) {
+            bursts.push_back({});
+            active = true;
+            waited = 0;
+        } else if (!now) {
+            active = false;
+        }
+        was_refilling = now;
+        was_ready = beat;
+    }
+    return bursts;
+}
+
+// Check that each line arrives in LINE_SIZE / (MEM_WIDTH / 8) beats, the first `latency`
+// cycles after the request and the rest on the consecutive cycles
+inline void check_refills(InstructionTest& tester, const std::string& name, int latency,
+                          const std::vector<RefillBurst>& bursts) {
+    const int line_beats = 16 / (SOC_MEM_WIDTH / 8);
+    bool passed = !bursts.empty();
+    std::string message = bursts.empty() ? "No refill recorded\n" : "";
+    for (size_t i = 0; i < bursts.size(); i++) {
+        const RefillBurst& burst = bursts[i];
+        if (burst.first_beat != latency || burst.beats != line_beats || burst.runs != 1) {
+            passed = false;
+            message += "Refill " + std::to_string(i) + ": first beat after " + std::to_string(burst.first_beat) +
+                       " cycles, " + std::to_string(burst.beats) + " beats in " + std::to_string(burst.runs) +
+                       " runs (expected " + std::to_string(latency) + " cycles and " +
+                       std::to_string(line_beats) + " consecutive beats)\n";
+        }
+    }
+    tester.results.push_back({name + ": " + std::to_string(SOC_MEM_WIDTH) + "-bit refill bursts at latency " +
+                              std::to_string(latency), passed, message, static_cast<int>(bursts.size())});
+}
+
+void test_cache_bursts(InstructionTest& tester) {
+    for (int latency : {1, 6}) {
+        tester.set_latency(latency, latency);
+#if SOC_ICACHE
+        check_refills(tester, "ICache", latency, record_refills(tester,
+            [&] { return tester.dut->soc_multicycle__DOT__gen_icache__DOT__icache_inst__DOT__refilling != 0; },
+            [&] { return tester.dut->soc_multicycle__DOT__rom_inst__DOT__ready != 0; }));
+#endif
+#if SOC_DCACHE
+        check_refills(tester, "DCache", latency, record_refills(tester,
+            [&] { return tester.dut->soc_multicycle__DOT__gen_dcache__DOT__dcache_inst__DOT__state == 2; }, // REFILL
+            [&] { return tester.dut->soc_multicycle__DOT__ram_inst__DOT__ready != 0; }));
+#endif
+    }
+    tester.set_latency(0, 0);
+}
+#endif
+
+void test_checkpoint_fork(InstructionTest& tester) {
+    // Warm up the Fibonacci program until its 4 setup instructions retired (x10 = 10),
+    // checkpoint, then fork two experiments from the checkpoint on fresh models:
+    //   1. continue unchanged      -> same result as test_fibo
+    //   2. set x10 = 5 (5 loops)   -> x1 = 5, x2 = 8, x3 = 13
+    TempFile file("fibo_warm.ckpt");
+    const std::string& checkpoint = file.path;
+    tester.load_instructions(FIBO_PROGRAM);
+    tester.reset();
+    int warm_cycles = tester.run_instructions(4, 100);
+
+    if (checkpoint.empty() || !tester.save_checkpoint(checkpoint)) {
+        tester.results.push_back({"Checkpoint: save", false, "Cannot write the checkpoint " + checkpoint + "\n", warm_cycles});
+        return;
+    }
+
+    InstructionTest unchanged;
+    unchanged.restore_checkpoint(checkpoint);
+    int cycles_run = unchanged.run_cycles(1000);
+    unchanged.check_results(
+        "Checkpoint: Fibonacci resumed from warm checkpoint",
+        { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
+        { {0, 0x00000059}, {1, 0x00000090} },
+        1000, warm_cycles + cycles_run
+    );
+
+    InstructionTest fewer_loops;
+    fewer_loops.restore_checkpoint(checkpoint);
+    fewer_loops.write_register(10, 5);
+    cycles_run = fewer_loops.run_cycles(1000);
+    fewer_loops.check_results(
+        "Checkpoint: forked Fibonacci with x10 = 5",
+        { {1, 5}, {2, 8}, {3, 13}, {10, 0} },
+        { {0, 0x00000008}, {1, 0x0000000D} },
+        1000, warm_cycles + cycles_run
+    );
+
+    tester.results.insert(tester.results.end(), unchanged.results.begin(), unchanged.results.end());
+    tester.results.insert(tester.results.end(), fewer_loops.results.begin(), fewer_loops.results.end());
+}
+
+void test_iss_fast_forward(InstructionTest& tester) {
+    // Fibonacci program: the ISS runs the setup and the first two loop iterations (20 instructions),
+    // the RTL takes over in the middle of the loop and must end in the same state as test_fibo.
+    Rv32iIss iss;
+    tester.load_instructions(FIBO_PROGRAM);
+    int cycles_run = tester.run_fast_forward(20, 1000, iss);
+    tester.check_results(
+        "ISS fast-forward: Fibonacci handed to RTL after 20 instructions",
+        { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
+        { {0, 0x00000059}, {1, 0x00000090} },
+        1000, cycles_run
+    );
+}
+
+void test_iss_lockstep(InstructionTest& tester) {
+    // Fibonacci program with the ISS checking PC and registers at every RTL retirement
+    Rv32iIss iss;
+    std::string mismatch;
+    tester.load_instructions(FIBO_PROGRAM);
+    int cycles_run = tester.run_lockstep(1000, iss, mismatch);
+    tester.check_results(
+        "ISS lockstep: Fibonacci matches the ISS at every retirement",
+        { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
+        { {0, 0x00000059}, {1, 0x00000090} },
+        1000, cycles_run, mismatch
+    );
+}
+
+void test_commit_log(InstructionTest& tester) {
+    // Log Fibonacci's retirements, read the log back and replay it on the ISS: every record
+    // must match the ISS's PC, instruction and destination value, and the log must end with
+    // the ECALL.
+    TempFile file("fibo.commits");
+    const std::string& log_file = file.path;
+    if (log_file.empty() || !tester.commit_log.open(log_file)) {
+        tester.results.push_back({"Commit log: Fibonacci retirements replay on the ISS", false,
+                                  "Cannot create the commit log " + log_file + "\n", 0});
+        return;
+    }
+    tester.load_instructions(FIBO_PROGRAM);
+    int cycles = tester.run_simulation(5000);
+    tester.commit_log.close();
+
+    Rv32iIss iss;
+    tester.init_iss(iss);
+    CommitLogReader reader;
+    std::string message, store_line;
+    if (!reader.open(log_file)) message = "Cannot read " + log_file + "\n";
+    CommitRecord r;
+    uint64_t last_cycle = 0;
+    while (message.empty() && reader.next(r)) {
+        const uint32_t pc = iss.pc;
+        const uint32_t instr = iss.rom[pc / 4];
+        iss.step();
+        if (r.pc != pc || r.instr != instr || (r.rd && r.rd_value != iss.regs[r.rd]) || r.cycle < last_cycle) {
+            message = "Expected PC 0x" + tester.to_hex(pc) + " (0x" + tester.to_hex(instr) + "), got\n" +
+                      spike_commit_line(r, true) + "\n";
+        }
+        if (r.pc == 4) store_line = spike_commit_line(r);
+        last_cycle = r.cycle;
+    }
+    if (message.empty() && !iss.halted) message = "Log ends before the ECALL at PC 0x" + tester.to_hex(iss.pc) + "\n";
+    if (message.empty() && store_line != "core   0: 3 0x00000004 (0x00102023) mem 0x00000000 0x00000001") {
+        message = "Unexpected line for sw x1, 0(x0): " + store_line + "\n";
+    }
+    tester.results.push_back({"Commit log: Fibonacci retirements replay on the ISS", message.empty(), message, cycles});
+}
+
+void test_latency_sweep(InstructionTest& tester) {
+    // Fibonacci at ROM and RAM latencies 1-8, set at runtime on the same model. Every point
+    // has to give the right result and latency 8 has to cost more cycles than latency 1.
+    std::string message;
+    int slowest = 0;
+    for (int region = LAT_IMEM; region <= LAT_DMEM; region++) {
+        const char* name = region == LAT_IMEM ? "IMEM" : "DMEM";
+        int first = 0;
+        for (int latency = 1; latency <= 8; latency++) {
+            tester.set_latency(region == LAT_IMEM ? latency : 1, region == LAT_DMEM ? latency : 1);
+            tester.load_instructions(FIBO_PROGRAM);
+            int cycles = tester.run_simulation(5000);
+            tester.flush_dcache();
+            if (!tester.dut->halted || tester.read_memory(1) != 0x90) {
+                message += std::string(name) + " latency " + std::to_string(latency) + ": wrong result\n";
+            }
+            if (latency == 1) first = cycles;
+            if (latency == 8 && cycles <= first) {
+                message += std::string(name) + " latency 8 took " + std::to_string(cycles) +
+                           " cycles, latency 1 " + std::to_string(first) + "\n";
+            }
+            slowest = std::max(slowest, cycles);
+        }
+    }
+    tester.set_latency(0, 0);
+    tester.results.push_back({"Latency sweep: Fibonacci at IMEM/DMEM latency 1-8 without rebuilding",
+                              message.empty(), message, slowest});
+}
+
+void test_profiler(InstructionTest& tester) {
+    // Profile Fibonacci behind an 8-cycle RAM. Every simulated cycle must be charged exactly
+    // once, and the two loads (0x10, 0x14) must show their MEMORY_WAIT cycles.
+    tester.set_latency(1, 8);
+    tester.profiling = true;
+    tester.load_instructions(FIBO_PROGRAM);
+    int cycles = tester.run_simulation(5000);
+    tester.profiling = false;
+    tester.set_latency(0, 0);
+
+    std::stringstream folded, summary;
+    tester.write_profile(folded, summary);
+
+    std::string message;
+    if (!tester.dut->halted) message += "Did not halt\n";
+    if (tester.profile.total_cycles() != (uint64_t)cycles) {
+        message += "Profiled " + std::to_string(tester.profile.total_cycles()) + " of " +
+                   std::to_string(cycles) + " cycles\n";
+    }
+    uint64_t folded_cycles = 0;
+    for (std::string line; std::getline(folded, line);) {
+        folded_cycles += std::stoull(line.substr(line.rfind(' ') + 1));
+    }
+    if (folded_cycles != (uint64_t)cycles) {
+        message += "Folded stacks add up to " + std::to_string(folded_cycles) + " cycles\n";
+    }
+    for (uint32_t pc : {0x10u, 0x14u}) {
+        auto it = tester.profile.by_pc().find(pc);
+        if (it == tester.profile.by_pc().end() || it->second.retired != 10 ||
+            tester.profile.state_cycles(pc, "MEMORY_WAIT") == 0) {
+            message += "Load at 0x" + tester.to_hex(pc) + " has no MEMORY_WAIT cycles or not 10 retirements\n";
+        }
+    }
+    if (folded.str().find("LOAD;0x00000010;MEMORY_WAIT") == std::string::npos) {
+        message += "Load class or state missing from the folded stacks\n";
+    }
+    if (!message.empty()) message += summary.str();
+    tester.results.push_back({"Profiler: every cycle attributed, loads wait on RAM", message.empty(), message, cycles});
+}
+
+void test_latency_jitter(InstructionTest& tester) {
+    // Random extra cycles on every ROM, RAM and UART request. The programs must still give
+    // the right results, and the same seed must replay the same cycle count.
+    auto configure = [](InstructionTest& t, uint64_t seed) {
+        t.latency.reseed(seed);
+        t.set_jitter(LAT_IMEM, JitterDistribution::uniform(3));
+        t.set_jitter(LAT_DMEM, JitterDistribution::geometric(0.5, 16));
+        t.set_jitter(LAT_UART, JitterDistribution::bimodal(0.25, 20));
+    };
+
+    configure(tester, 1);
+    tester.run_test(
+        "Latency jitter: Fibonacci with random ROM/RAM latency",
+        FIBO_PROGRAM,
+        { {1, 55}, {2, 89}, {3, 144}, {10, 0} },
+        { {0, 0x00000059}, {1, 0x00000090} },
+        5000
+    );
+    int cycles = tester.results.back().cycles;
+
+    // Same UART loopback program as test_uart_loopback
+    tester.run_test(
+        "Latency jitter: UART loopback with random UART latency",
+        { 0x05A00093,   // addi x1, x0, 0x5A
+          0x10000137,   // lui  x2, 0x10000
+          0x00810193,   // addi x3, x2, 0x8
+          0x00200213,   // addi x4, x0, 0x2
+          0x01400513,   // addi x10, x0, 20
+          0x00a10623,   // sb   x10, 12(x2)
+          0x00110023,   // sb   x1, 0(x2)
+          0x00018283,   // lb   x5, 0(x3)
+          0x0042f2b3,   // and  x5, x5, x4
+          0xfe028ce3,   // beq  x5, x0, -8
+          0x00410303 }, // lb   x6, 4(x2)
+        { {5, 0x2}, {6, 0x5A} },
+        {},
+        5000
+    );
+
+    InstructionTest replay;
+    configure(replay, 1);
+    replay.load_instructions(FIBO_PROGRAM);
+    int replay_cycles = replay.run_simulation(5000);
+
+    bool drawn = tester.latency.requests[LAT_IMEM] > 0 && tester.latency.requests[LAT_DMEM] > 0 &&
+                 tester.latency.requests[LAT_UART] > 0;
+    bool passed = drawn && replay_cycles == cycles;
+    tester.results.push_back({"Latency jitter: same seed, same cycles", passed,
+                              passed ? "" : "Draws IMEM/DMEM/UART " + std::to_string(tester.latency.requests[LAT_IMEM]) +
+                                            "/" + std::to_string(tester.latency.requests[LAT_DMEM]) + "/" +
+                                            std::to_string(tester.latency.requests[LAT_UART]) + ", cycles " +
+                                            std::to_string(cycles) + " then " + std::to_string(replay_cycles) + "\n",
+                              replay_cycles});
+}
+
+void test_trace_control(InstructionTest& tester) {
+    // Firmware turns waveforms on and off through TRACE_CTRL, which must not end the program
+    // like the rest of the TOHOST range. Traced builds also check the cycle window and the
+    // PC trigger on Fibonacci.
+    // ASM:
+    //   lui  x1, 0x10001
+    //   addi x2, x0, 1
+    //   sw   x2, 0x80(x1)    # TRACE_CTRL = 1
+    //   addi x3, x0, 3
+    //   sw   x0, 0x80(x1)    # TRACE_CTRL = 0
+    //   addi x5, x0, 5
+    TempFile file("trace_control.fst");
+    tester.trace_file = file.path;
+    tester.run_test(
+        "Trace control: TRACE_CTRL writes do not end the program",
+        { 0x100010b7,   // lui  x1, 0x10001
+          0x00100113,   // addi x2, x0, 1
+          0x0820a023,   // sw   x2, 0x80(x1)
+          0x00300193,   // addi x3, x0, 3
+          0x0800a023,   // sw   x0, 0x80(x1)
+          0x00500293 }, // addi x5, x0, 5
+        { {3, 3}, {5, 5} },
+        {}
+    );
+
+#if SOC_TRACE
+    std::string message;
+    const int program_cycles = tester.results.back().cycles;
+    if (tester.traced_cycles == 0 || tester.traced_cycles >= (uint64_t)program_cycles) {
+        message += "TRACE_CTRL recorded " + std::to_string(tester.traced_cycles) + " of " +
+                   std::to_string(program_cycles) + " cycles\n";
+    }
+
+    // Cycles 10-19, then 4 cycles from the first time the PC reaches the loop's branch
+    tester.load_instructions(FIBO_PROGRAM);
+    const std::pair<TraceTriggers, uint64_t> cases[] = {
+        {{10, 20, false, 0, 0}, 10},
+        {{0, 0, true, 0x2c, 4}, 4},
+    };
+    for (const auto& [triggers, expected] : cases) {
+        tester.trace_triggers = triggers;
+        tester.traced_cycles = 0;
+        tester.run_simulation(5000);
+        if (tester.traced_cycles != expected) {
+            message += "Trigger recorded " + std::to_string(tester.traced_cycles) + " cycles, expected " +
+                       std::to_string(expected) + "\n";
+        }
+    }
+    tester.trace_triggers = TraceTriggers();
+    tester.results.push_back({"Trace control: FST recorded only inside the TRACE_CTRL, cycle and PC windows",
+                              message.empty(), message, program_cycles});
+#endif
+}
+
 void test_uart_tx(InstructionTest& tester) {
     // ASM:
     //   addi x1, x0, 0x41   # x1 = ASCII 'A'
     //   lui  x2, 0x10000      # x2 = 0x1000_0000 (UART base address)
     //   sb   x1, 0(x2)      # UART_TX = 0x1000, write 'A' to UART
 
-    // tester.vcd_enabled = true;
+    // tester.trace_enabled = true;
     tester.run_test(
         "UART TX: write 'A' to UART",
         { 0x04100093,
@@ -783,7 +2448,7 @@ void test_uart_tx(InstructionTest& tester) {
           {},
           200
     );
-    // tester.vcd_enabled = false;
+    // tester.trace_enabled = false;
 }
 
 void test_uart_tx2(InstructionTest& tester) {
@@ -807,7 +2472,7 @@ void test_uart_tx2(InstructionTest& tester) {
     // sub x10, x10, x11
     // bne x10, x0, loop
 
-    // tester.vcd_enabled = true;
+    // tester.trace_enabled = true;
     tester.run_test(
         "UART TX loop: write 'A', 'B', 'C' to UART with status check (Check on VCD)",
         { 0x04100093,
@@ -827,7 +2492,7 @@ void test_uart_tx2(InstructionTest& tester) {
         {},
         1000
     );
-    //  tester.vcd_enabled = false;
+    //  tester.trace_enabled = false;
 }
 
 void test_uart_loopback(InstructionTest& tester) {
@@ -849,7 +2514,7 @@ void test_uart_loopback(InstructionTest& tester) {
 
     // lb x6, 4(x2)       # Read from UART_RX (0x1000_0004) into x6
 
-    tester.vcd_enabled = true;
+    tester.trace_enabled = true;
     tester.run_test(
         "UART Loopback: write 'Z' to UART and read it back",
         { 0x05A00093,
@@ -867,5 +2532,605 @@ void test_uart_loopback(InstructionTest& tester) {
           {},
           1000
     );
-    tester.vcd_enabled = false;
+    tester.trace_enabled = false;
+}
+
+void test_uart_fifo(InstructionTest& tester) {
+    // Four bytes written back to back go into the TX FIFO without polling, come back through
+    // the loopback into the RX FIFO and are read out once the RX level reaches 4.
+    // ASM:
+    // lui  x2, 0x10000     # x2 = 0x1000_0000 (UART base)
+    // addi x1, x0, 0x61    # 'a'
+    // sb   x1, 0(x2)       # 'a', 'b', 'c', 'd' to UART_TX
+    // addi x1, x1, 1
+    // sb   x1, 0(x2)
+    // addi x1, x1, 1
+    // sb   x1, 0(x2)
+    // addi x1, x1, 1
+    // sb   x1, 0(x2)
+    // addi x5, x0, 4
+    // wait_rx:
+    // lw   x4, 16(x2)      # UART_LEVEL
+    // srli x4, x4, 16      # RX level
+    // bne  x4, x5, wait_rx
+    // lbu  x6, 4(x2)       # 'a'
+    // lbu  x7, 4(x2)       # 'b'
+    // lbu  x8, 4(x2)       # 'c'
+    // lbu  x9, 4(x2)       # 'd'
+    // lw   x11, 8(x2)      # status: TX ready, TX idle, TX below threshold = 0x0D
+    tester.run_test(
+        "UART FIFO: burst of 4 bytes looped back through the TX and RX FIFOs",
+        { 0x10000137,
+          0x06100093,
+          0x00110023,
+          0x00108093,
+          0x00110023,
+          0x00108093,
+          0x00110023,
+          0x00108093,
+          0x00110023,
+          0x00400293,
+          0x01012203,
+          0x01025213,
+          0xfe521ce3,
+          0x00414303,
+          0x00414383,
+          0x00414403,
+          0x00414483,
+          0x00812583 },
+          { {4, 4}, {6, 0x61}, {7, 0x62}, {8, 0x63}, {9, 0x64}, {11, 0x0D} },
+          {},
+          3000
+    );
+}
+
+void test_dma(InstructionTest& tester) {
+    // The DMA fills 8 words at 0x100 from its registers, then follows the chain to a copy of
+    // them to 0x300 and to a descriptor sending "Hi" to the UART. The CPU sums 1..10 while the
+    // transfers run, then polls the DMA status and reads the bytes back from the loopback.
+    // ASM:
+    //   lui  x1, 0x10000
+    //   addi x1, x1, 0x100           # x1 = DMA base
+    //   addi x2, x0, 0x100           # descriptor @0x200: copy 0x100 -> 0x300, 32 bytes
+    //   sw   x2, 0x200(x0)
+    //   addi x3, x0, 0x300
+    //   sw   x3, 0x204(x0)
+    //   addi x4, x0, 32
+    //   sw   x4, 0x208(x0)
+    //   addi x5, x0, 0x220
+    //   sw   x5, 0x20C(x0)           # NEXT = 0x220
+    //   sw   x0, 0x210(x0)           # CTRL = copy
+    //   addi x6, x0, 0x240           # descriptor @0x220: 2 bytes from 0x240 to the UART
+    //   sw   x6, 0x220(x0)
+    //   sw   x0, 0x224(x0)
+    //   addi x7, x0, 2
+    //   sw   x7, 0x228(x0)
+    //   sw   x0, 0x22C(x0)           # NEXT = 0 (last)
+    //   sw   x7, 0x230(x0)           # CTRL = UART
+    //   lui  x9, 0x7
+    //   addi x9, x9, 0x948
+    //   sw   x9, 0x240(x0)           # "Hi"
+    //   lui  x10, 0x12345
+    //   addi x10, x10, 0x678
+    //   sw   x10, 0(x1)              # SRC = fill pattern
+    //   sw   x2, 4(x1)               # DST = 0x100
+    //   sw   x4, 8(x1)               # LEN = 32
+    //   addi x11, x0, 0x200
+    //   sw   x11, 12(x1)             # NEXT = 0x200
+    //   lui  x12, 0x80000
+    //   addi x12, x12, 1
+    //   sw   x12, 16(x1)             # CTRL = start | fill
+    //   addi x13, x0, 0
+    //   addi x14, x0, 10
+    // loop:
+    //   add  x13, x13, x14
+    //   addi x14, x14, -1
+    //   bne  x14, x0, loop
+    // wait_dma:
+    //   lw   x15, 20(x1)
+    //   andi x15, x15, 1
+    //   bne  x15, x0, wait_dma
+    //   lw   x15, 20(x1)             # x15 = done
+    //   lw   x16, 0x31C(x0)          # last copied word
+    //   lui  x17, 0x10000
+    // wait_rx:
+    //   lw   x18, 16(x17)
+    //   srli x18, x18, 16
+    //   bne  x18, x7, wait_rx        # RX level = 2
+    //   lbu  x19, 4(x17)
+    //   lbu  x20, 4(x17)
+    tester.run_test(
+        "DMA: fill, chained copy and RAM to UART",
+        { 0x100000b7,   // lui x1, 0x10000
+          0x10008093,   // addi x1, x1, 0x100
+          0x10000113,   // addi x2, x0, 0x100
+          0x20202023,   // sw x2, 0x200(x0)
+          0x30000193,   // addi x3, x0, 0x300
+          0x20302223,   // sw x3, 0x204(x0)
+          0x02000213,   // addi x4, x0, 32
+          0x20402423,   // sw x4, 0x208(x0)
+          0x22000293,   // addi x5, x0, 0x220
+          0x20502623,   // sw x5, 0x20C(x0)
+          0x20002823,   // sw x0, 0x210(x0)
+          0x24000313,   // addi x6, x0, 0x240
+          0x22602023,   // sw x6, 0x220(x0)
+          0x22002223,   // sw x0, 0x224(x0)
+          0x00200393,   // addi x7, x0, 2
+          0x22702423,   // sw x7, 0x228(x0)
+          0x22002623,   // sw x0, 0x22C(x0)
+          0x22702823,   // sw x7, 0x230(x0)
+          0x000074b7,   // lui x9, 0x7
+          0x94848493,   // addi x9, x9, 0x948
+          0x24902023,   // sw x9, 0x240(x0)
+          0x12345537,   // lui x10, 0x12345
+          0x67850513,   // addi x10, x10, 0x678
+          0x00a0a023,   // sw x10, 0(x1)
+          0x0020a223,   // sw x2, 4(x1)
+          0x0040a423,   // sw x4, 8(x1)
+          0x20000593,   // addi x11, x0, 0x200
+          0x00b0a623,   // sw x11, 12(x1)
+          0x80000637,   // lui x12, 0x80000
+          0x00160613,   // addi x12, x12, 1
+          0x00c0a823,   // sw x12, 16(x1)
+          0x00000693,   // addi x13, x0, 0
+          0x00a00713,   // addi x14, x0, 10
+          0x00e686b3,   // add x13, x13, x14
+          0xfff70713,   // addi x14, x14, -1
+          0xfe071ce3,   // bne x14, x0, loop
+          0x0140a783,   // lw x15, 20(x1)
+          0x0017f793,   // andi x15, x15, 1
+          0xfe079ce3,   // bne x15, x0, wait_dma
+          0x0140a783,   // lw x15, 20(x1)
+          0x31c02803,   // lw x16, 0x31C(x0)
+          0x100008b7,   // lui x17, 0x10000
+          0x0108a903,   // lw x18, 16(x17)
+          0x01095913,   // srli x18, x18, 16
+          0xfe791ce3,   // bne x18, x7, wait_rx
+          0x0048c983,   // lbu x19, 4(x17)
+          0x0048ca03 }, // lbu x20, 4(x17)
+        { {13, 55}, {15, 0x2}, {16, 0x12345678}, {19, 0x48}, {20, 0x69} },
+        { {64, 0x12345678}, {71, 0x12345678}, {192, 0x12345678}, {199, 0x12345678}, {136, 0x240}, {144, 0x6948} },
+        3000
+    );
+
+    // A misaligned copy is rejected with the error bit
+    // ASM:
+    //   lui  x1, 0x10000
+    //   addi x1, x1, 0x100
+    //   addi x2, x0, 1
+    //   sw   x2, 0(x1)               # SRC = 1
+    //   addi x3, x0, 4
+    //   sw   x3, 8(x1)               # LEN = 4
+    //   lui  x4, 0x80000
+    //   sw   x4, 16(x1)              # CTRL = start | copy
+    // wait:
+    //   lw   x5, 20(x1)
+    //   andi x6, x5, 1
+    //   bne  x6, x0, wait
+    tester.run_test(
+        "DMA: misaligned copy sets the error bit",
+        { 0x100000b7,   // lui x1, 0x10000
+          0x10008093,   // addi x1, x1, 0x100
+          0x00100113,   // addi x2, x0, 1
+          0x0020a023,   // sw x2, 0(x1)
+          0x00400193,   // addi x3, x0, 4
+          0x0030a423,   // sw x3, 8(x1)
+          0x80000237,   // lui x4, 0x80000
+          0x0040a823,   // sw x4, 16(x1)
+          0x0140a283,   // lw x5, 20(x1)
+          0x0012f313,   // andi x6, x5, 1
+          0xfe031ce3 }, // bne x6, x0, wait
+        { {5, 0x4} },
+        {},
+        200
+    );
+
+    // Copy and fill move whole words, a LEN that is not one is rejected rather than rounded
+    // ASM:
+    //   lui  x1, 0x10000
+    //   addi x1, x1, 0x100
+    //   addi x2, x0, 0x100
+    //   sw   x2, 4(x1)               # DST = 0x100
+    //   addi x3, x0, 6
+    //   sw   x3, 8(x1)               # LEN = 6
+    //   lui  x4, 0x80000
+    //   sw   x4, 16(x1)              # CTRL = start | copy
+    // wait:
+    //   lw   x5, 20(x1)
+    //   andi x6, x5, 1
+    //   bne  x6, x0, wait
+    tester.run_test(
+        "DMA: copy length not a multiple of 4 sets the error bit",
+        { 0x100000b7,   // lui x1, 0x10000
+          0x10008093,   // addi x1, x1, 0x100
+          0x10000113,   // addi x2, x0, 0x100
+          0x0020a223,   // sw x2, 4(x1)
+          0x00600193,   // addi x3, x0, 6
+          0x0030a423,   // sw x3, 8(x1)
+          0x80000237,   // lui x4, 0x80000
+          0x0040a823,   // sw x4, 16(x1)
+          0x0140a283,   // lw x5, 20(x1)
+          0x0012f313,   // andi x6, x5, 1
+          0xfe031ce3 }, // bne x6, x0, wait
+        { {5, 0x4} },
+        {},
+        200
+    );
+
+    // A fill whose NEXT points into the middle of a word: the fill completes, then the link
+    // is rejected with the error bit instead of fetching the (valid, empty) descriptor at 0x200
+    // ASM:
+    //   lui  x1, 0x10000
+    //   addi x1, x1, 0x100
+    //   lui  x2, 0x12345
+    //   addi x2, x2, 0x678
+    //   sw   x2, 0(x1)               # SRC = fill pattern
+    //   addi x3, x0, 0x100
+    //   sw   x3, 4(x1)               # DST = 0x100
+    //   addi x4, x0, 16
+    //   sw   x4, 8(x1)               # LEN = 16
+    //   addi x5, x0, 0x202
+    //   sw   x5, 12(x1)              # NEXT = 0x202
+    //   lui  x6, 0x80000
+    //   addi x6, x6, 1
+    //   sw   x6, 16(x1)              # CTRL = start | fill
+    // wait:
+    //   lw   x7, 20(x1)
+    //   andi x8, x7, 1
+    //   bne  x8, x0, wait
+    tester.run_test(
+        "DMA: misaligned NEXT stops the chain with the error bit",
+        { 0x100000b7,   // lui x1, 0x10000
+          0x10008093,   // addi x1, x1, 0x100
+          0x12345137,   // lui x2, 0x12345
+          0x67810113,   // addi x2, x2, 0x678
+          0x0020a023,   // sw x2, 0(x1)
+          0x10000193,   // addi x3, x0, 0x100
+          0x0030a223,   // sw x3, 4(x1)
+          0x01000213,   // addi x4, x0, 16
+          0x0040a423,   // sw x4, 8(x1)
+          0x20200293,   // addi x5, x0, 0x202
+          0x0050a623,   // sw x5, 12(x1)
+          0x80000337,   // lui x6, 0x80000
+          0x00130313,   // addi x6, x6, 1
+          0x0060a823,   // sw x6, 16(x1)
+          0x0140a383,   // lw x7, 20(x1)
+          0x0013f413,   // andi x8, x7, 1
+          0xfe041ce3 }, // bne x8, x0, wait
+        { {7, 0x4} },
+        { {64, 0x12345678}, {67, 0x12345678} },
+        300
+    );
+
+    // A 64-word copy while the CPU counts in registers: the copy has to finish within a read
+    // and a write per word plus two cycles per burst of 4 and a few to start (behind the data
+    // cache also a write-back and a refill per line), and the CPU has to keep retiring while
+    // it runs.
+    // ASM:
+    //   lui  x1, 0x10000
+    //   addi x1, x1, 0x100
+    //   lui  x2, 0x12345
+    //   addi x2, x2, 0x678
+    //   sw   x2, 0xFC(x0)            # last source word
+    //   sw   x0, 0(x1)               # SRC = 0
+    //   addi x3, x0, 0x400
+    //   sw   x3, 4(x1)               # DST = 0x400
+    //   addi x4, x0, 256
+    //   sw   x4, 8(x1)               # LEN = 256
+    //   sw   x0, 12(x1)              # NEXT = 0
+    //   lui  x5, 0x80000
+    //   sw   x5, 16(x1)              # CTRL = start | copy
+    //   addi x6, x0, 100
+    // loop:
+    //   addi x7, x7, 1
+    //   addi x6, x6, -1
+    //   bne  x6, x0, loop
+    const std::string name = "DMA: 64-word copy overlaps the CPU";
+    if (!tester.load_test_program(name, { 0x100000b7,     // lui x1, 0x10000
+                                          0x10008093,     // addi x1, x1, 0x100
+                                          0x12345137,     // lui x2, 0x12345
+                                          0x67810113,     // addi x2, x2, 0x678
+                                          0x0e202e23,     // sw x2, 0xFC(x0)
+                                          0x0000a023,     // sw x0, 0(x1)
+                                          0x40000193,     // addi x3, x0, 0x400
+                                          0x0030a223,     // sw x3, 4(x1)
+                                          0x10000213,     // addi x4, x0, 256
+                                          0x0040a423,     // sw x4, 8(x1)
+                                          0x0000a623,     // sw x0, 12(x1)
+                                          0x800002b7,     // lui x5, 0x80000
+                                          0x0050a823,     // sw x5, 16(x1)
+                                          0x06400313,     // addi x6, x0, 100
+                                          0x00138393,     // addi x7, x7, 1
+                                          0xfff30313,     // addi x6, x6, -1
+                                          0xfe031ce3 })) // bne x6, x0, loop
+        return;
+
+    const int words = 64;
+    int bound = 2 * words + 2 * (words / 4) + 16;
+#if SOC_DCACHE
+    bound += (2 * words / 4) * 2 * (16 / (SOC_MEM_WIDTH / 8) + 2);
+#endif
+    tester.reset();
+    int cycles = 0, dma_cycles = 0, retired_during_dma = 0;
+    while (cycles < 3000 && !tester.dut->halted) {
+        const bool dma_busy = tester.dut->soc_multicycle__DOT__dma_inst__DOT__state != 0;
+        const bool retired = tester.tick();
+        cycles++;
+        if (dma_busy) {
+            dma_cycles++;
+            if (retired) retired_during_dma++;
+        }
+    }
+
+    std::string message;
+    if (dma_cycles == 0 || dma_cycles > bound) {
+        message += "Copy took " + std::to_string(dma_cycles) + " cycles, expected 1-" + std::to_string(bound) + "\n";
+    }
+    if (retired_during_dma < dma_cycles / 8 || retired_during_dma == 0) {
+        message += "CPU retired " + std::to_string(retired_during_dma) + " instructions in the " +
+                   std::to_string(dma_cycles) + " cycles of the copy\n";
+    }
+    tester.check_results(name, { {7, 100} }, { {63, 0x12345678}, {319, 0x12345678} }, 3000, cycles, message);
+}
+
+void test_interrupts(InstructionTest& tester) {
+    // Three bytes go out through the UART loopback while the CPU spins on a counter. Each
+    // received byte raises the RX interrupt; the handler reads it, sums it into x6 and counts
+    // it in x7. MRET restores mstatus.MIE (mstatus = MPP M | MPIE | MIE = 0x1888).
+    // ASM:
+    //   lui  x2, 0x10000             # UART base
+    //   addi x1, x0, 0x50
+    //   csrw mtvec, x1               # handler
+    //   addi x3, x0, 1
+    //   sw   x3, 24(x2)              # UART_IRQ_ENABLE = RX
+    //   lui  x3, 1
+    //   srli x3, x3, 1
+    //   csrw mie, x3                 # MEIE
+    //   csrsi mstatus, 8             # MIE
+    //   addi x4, x0, 0x61            # 'a', 'b', 'c' to UART_TX
+    //   sb   x4, 0(x2)
+    //   addi x4, x4, 1
+    //   sb   x4, 0(x2)
+    //   addi x4, x4, 1
+    //   sb   x4, 0(x2)
+    //   addi x12, x0, 3
+    // loop:
+    //   addi x5, x5, 1
+    //   bne  x7, x12, loop
+    //   csrr x11, mstatus
+    //   ecall
+    // handler:                       # 0x50
+    //   lbu  x8, 4(x2)
+    //   add  x6, x6, x8
+    //   addi x7, x7, 1
+    //   csrr x9, mcause
+    //   mret
+    tester.run_test(
+        "Interrupts: UART RX interrupt handler",
+        { 0x10000137,   // lui x2, 0x10000
+          0x05000093,   // addi x1, x0, 0x50
+          0x30509073,   // csrw mtvec, x1
+          0x00100193,   // addi x3, x0, 1
+          0x00312c23,   // sw x3, 24(x2)
+          0x000011b7,   // lui x3, 1
+          0x0011d193,   // srli x3, x3, 1
+          0x30419073,   // csrw mie, x3
+          0x30046073,   // csrsi mstatus, 8
+          0x06100213,   // addi x4, x0, 0x61
+          0x00410023,   // sb x4, 0(x2)
+          0x00120213,   // addi x4, x4, 1
+          0x00410023,   // sb x4, 0(x2)
+          0x00120213,   // addi x4, x4, 1
+          0x00410023,   // sb x4, 0(x2)
+          0x00300613,   // addi x12, x0, 3
+          0x00128293,   // addi x5, x5, 1
+          0xfec39ee3,   // bne x7, x12, loop
+          0x300025f3,   // csrr x11, mstatus
+          0x00000073,   // ecall
+          0x00414403,   // lbu x8, 4(x2)
+          0x00830333,   // add x6, x6, x8
+          0x00138393,   // addi x7, x7, 1
+          0x342024f3,   // csrr x9, mcause
+          0x30200073 }, // mret
+        { {6, 0x61 + 0x62 + 0x63}, {7, 3}, {9, 0x8000000B}, {11, 0x1888} },
+        {},
+        3000
+    );
+
+    // The TX interrupt is raised while the TX FIFO is empty; the handler disables it.
+    // ASM:
+    //   lui  x2, 0x10000
+    //   addi x1, x0, 0x30
+    //   csrw mtvec, x1
+    //   lui  x3, 1
+    //   srli x3, x3, 1
+    //   csrw mie, x3
+    //   csrsi mstatus, 8
+    //   addi x3, x0, 2
+    //   sw   x3, 24(x2)              # UART_IRQ_ENABLE = TX empty
+    //   addi x12, x0, 1
+    // loop:
+    //   bne  x7, x12, loop
+    //   ecall
+    // handler:                       # 0x30
+    //   sw   x0, 24(x2)              # UART_IRQ_ENABLE = 0
+    //   addi x7, x7, 1
+    //   csrr x9, mcause
+    //   mret
+    tester.run_test(
+        "Interrupts: UART TX empty interrupt",
+        { 0x10000137,   // lui x2, 0x10000
+          0x03000093,   // addi x1, x0, 0x30
+          0x30509073,   // csrw mtvec, x1
+          0x000011b7,   // lui x3, 1
+          0x0011d193,   // srli x3, x3, 1
+          0x30419073,   // csrw mie, x3
+          0x30046073,   // csrsi mstatus, 8
+          0x00200193,   // addi x3, x0, 2
+          0x00312c23,   // sw x3, 24(x2)
+          0x00100613,   // addi x12, x0, 1
+          0x00c39063,   // bne x7, x12, loop
+          0x00000073,   // ecall
+          0x00012c23,   // sw x0, 24(x2)
+          0x00138393,   // addi x7, x7, 1
+          0x342024f3,   // csrr x9, mcause
+          0x30200073 }, // mret
+        { {7, 1}, {9, 0x8000000B} },
+        {},
+        200
+    );
+}
+
+void test_wfi(InstructionTest& tester) {
+    // A byte goes out through the UART loopback at a slow baud rate while the CPU sleeps in
+    // WFI. The RX interrupt is enabled in mie but not in mstatus, so it only ends the sleep
+    // and execution continues after the WFI. The harness skips most of the sleep.
+    // ASM:
+    //   lui  x2, 0x10000             # UART base
+    //   addi x3, x0, 255
+    //   sw   x3, 12(x2)              # UART_BAUD = 255
+    //   addi x3, x0, 1
+    //   sw   x3, 24(x2)              # UART_IRQ_ENABLE = RX
+    //   lui  x3, 1
+    //   srli x3, x3, 1
+    //   csrw mie, x3                 # MEIE
+    //   csrr x5, mcycle
+    //   addi x4, x0, 0x5A
+    //   sb   x4, 0(x2)
+    //   wfi
+    //   lbu  x6, 4(x2)
+    //   csrr x7, mcycle
+    //   sub  x7, x7, x5              # cycles asleep (plus a few)
+    uint64_t skipped_before = tester.idle_cycles_skipped;
+    tester.run_test(
+        "WFI: sleep until the UART RX interrupt",
+        { 0x10000137,   // lui x2, 0x10000
+          0x0ff00193,   // addi x3, x0, 255
+          0x00312623,   // sw x3, 12(x2)
+          0x00100193,   // addi x3, x0, 1
+          0x00312c23,   // sw x3, 24(x2)
+          0x000011b7,   // lui x3, 1
+          0x0011d193,   // srli x3, x3, 1
+          0x30419073,   // csrw mie, x3
+          0xb00022f3,   // csrr x5, mcycle
+          0x05a00213,   // addi x4, x0, 0x5A
+          0x00410023,   // sb x4, 0(x2)
+          0x10500073,   // wfi
+          0x00414303,   // lbu x6, 4(x2)
+          0xb00023f3,   // csrr x7, mcycle
+          0x405383b3 }, // sub x7, x7, x5
+        { {6, 0x5A} },
+        {},
+        4000
+    );
+
+    // Ten bit times at 255 cycles each pass on mcycle, most of them skipped by the harness
+    uint32_t asleep = tester.read_register(7);
+    uint64_t skipped = tester.idle_cycles_skipped - skipped_before;
+    bool passed = asleep > 2000 && skipped > 1000;
+    tester.results.push_back({"WFI: idle cycles fast-forwarded", passed,
+                              passed ? "" : "Expected > 2000 cycles asleep with > 1000 skipped, got " +
+                                            std::to_string(asleep) + " asleep and " +
+                                            std::to_string(skipped) + " skipped\n",
+                              static_cast<int>(asleep)});
+}
+
+void test_timer(InstructionTest& tester) {
+    // The CLINT timer interrupt fires 100 cycles after mtimecmp is set while the CPU spins on
+    // a counter; the handler pushes mtimecmp out of reach by setting its high word.
+    // ASM:
+    //   lui  x2, 0x2004              # CLINT mtimecmp
+    //   lui  x4, 0x200C              # CLINT mtime + 8
+    //   addi x1, x0, 0x3C
+    //   csrw mtvec, x1               # handler
+    //   lw   x3, -8(x4)              # mtime
+    //   addi x3, x3, 100
+    //   sw   x3, 0(x2)               # mtimecmp = mtime + 100
+    //   sw   x0, 4(x2)
+    //   addi x3, x0, 0x80
+    //   csrw mie, x3                 # MTIE
+    //   csrsi mstatus, 8             # MIE
+    //   addi x12, x0, 1
+    // loop:
+    //   addi x5, x5, 1
+    //   bne  x7, x12, loop
+    //   ecall
+    // handler:                       # 0x3C
+    //   addi x6, x0, -1
+    //   sw   x6, 4(x2)               # mtimecmp high word = all ones
+    //   addi x7, x7, 1
+    //   csrr x9, mcause
+    //   mret
+    tester.run_test(
+        "Timer: mtimecmp interrupt",
+        { 0x02004137,   // lui x2, 0x2004
+          0x0200c237,   // lui x4, 0x200c
+          0x03c00093,   // addi x1, x0, 0x3c
+          0x30509073,   // csrw mtvec, x1
+          0xff822183,   // lw x3, -8(x4)
+          0x06418193,   // addi x3, x3, 100
+          0x00312023,   // sw x3, 0(x2)
+          0x00012223,   // sw x0, 4(x2)
+          0x08000193,   // addi x3, x0, 0x80
+          0x30419073,   // csrw mie, x3
+          0x30046073,   // csrsi mstatus, 8
+          0x00100613,   // addi x12, x0, 1
+          0x00128293,   // addi x5, x5, 1
+          0xfec39ee3,   // bne x7, x12, loop
+          0x00000073,   // ecall
+          0xfff00313,   // addi x6, x0, -1
+          0x00612223,   // sw x6, 4(x2)
+          0x00138393,   // addi x7, x7, 1
+          0x342024f3,   // csrr x9, mcause
+          0x30200073 }, // mret
+        { {7, 1}, {9, 0x80000007} },
+        {},
+        500
+    );
+
+    // WFI until the timer fires 4000 cycles later: MTIE is set but mstatus.MIE is not, so
+    // execution continues after the WFI. The harness skips the sleep in one jump.
+    // ASM:
+    //   lui  x2, 0x2004
+    //   lui  x4, 0x200C
+    //   lw   x5, -8(x4)              # start time
+    //   addi x3, x5, 2000
+    //   addi x3, x3, 2000
+    //   sw   x3, 0(x2)               # mtimecmp = start + 4000
+    //   sw   x0, 4(x2)
+    //   addi x3, x0, 0x80
+    //   csrw mie, x3                 # MTIE
+    //   wfi
+    //   lw   x6, -8(x4)
+    //   sub  x6, x6, x5              # elapsed
+    //   csrr x7, mip                 # MTIP
+    uint64_t skipped_before = tester.idle_cycles_skipped;
+    tester.run_test(
+        "Timer: WFI until mtimecmp",
+        { 0x02004137,   // lui x2, 0x2004
+          0x0200c237,   // lui x4, 0x200c
+          0xff822283,   // lw x5, -8(x4)
+          0x7d028193,   // addi x3, x5, 2000
+          0x7d018193,   // addi x3, x3, 2000
+          0x00312023,   // sw x3, 0(x2)
+          0x00012223,   // sw x0, 4(x2)
+          0x08000193,   // addi x3, x0, 0x80
+          0x30419073,   // csrw mie, x3
+          0x10500073,   // wfi
+          0xff822303,   // lw x6, -8(x4)
+          0x40530333,   // sub x6, x6, x5
+          0x344023f3 }, // csrr x7, mip
+        { {7, 0x80} },
+        {},
+        5000
+    );
+
+    uint32_t elapsed = tester.read_register(6);
+    uint64_t skipped = tester.idle_cycles_skipped - skipped_before;
+    bool passed = elapsed >= 4000 && elapsed < 4100 && skipped > 3000;
+    tester.results.push_back({"Timer: elapsed mtime across WFI", passed,
+                              passed ? "" : "Expected 4000..4099 cycles elapsed with > 3000 skipped, got " +
+                                            std::to_string(elapsed) + " elapsed and " +
+                                            std::to_string(skipped) + " skipped\n",
+                              static_cast<int>(elapsed)});
 }
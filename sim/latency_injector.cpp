@@ -0,0 +1,8 @@
+// DPI side of src/latency_jitter.vh: `injector` is the LatencyInjector* the harness put on the
+// SoC's latency_injector input.
+#include "Vsoc_multicycle__Dpi.h"
+#include "latency_injector.hpp"
+
+int latency_jitter(long long injector, int region) {
+    return static_cast<int>(reinterpret_cast<LatencyInjector*>(static_cast<uintptr_t>(injector))->draw(region));
+}
@@ -0,0 +1,98 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <verilated_save.h>
+
+// Regions with runtime latency, numbered like src/latency_jitter.vh
+enum LatencyRegion { LAT_IMEM = 0, LAT_DMEM = 1, LAT_UART = 2, LAT_REGIONS = 3 };
+
+// Extra cycles added to one request, at most 255
+struct JitterDistribution {
+    enum Kind { NONE, UNIFORM, GEOMETRIC, BIMODAL };
+    Kind kind = NONE;
+    uint32_t cycles = 0; // UNIFORM: maximum, GEOMETRIC: cap, BIMODAL: extra cycles of a slow request
+    double p = 0.0;      // GEOMETRIC: chance of each further cycle, BIMODAL: chance of a slow request
+
+    static JitterDistribution none() { return {}; }
+    static JitterDistribution uniform(uint32_t max) { return {UNIFORM, max, 0.0}; }
+    static JitterDistribution geometric(double p, uint32_t cap = 255) { return {GEOMETRIC, cap, p}; }
+    static JitterDistribution bimodal(double p, uint32_t slow) { return {BIMODAL, slow, p}; }
+};
+
+// Seeded random latency jitter for imem_sync/dmem_sync/uart, drawn through DPI
+// (latency_injector.cpp) when the SoC's latency_injector input holds a pointer to it.
+// Every region has its own generator, so the jitter one region sees does not depend on the
+// traffic of the others and a seed replays exactly.
+class LatencyInjector {
+public:
+    JitterDistribution jitter[LAT_REGIONS];
+    uint64_t requests[LAT_REGIONS] = {};     // draws so far
+    uint64_t extra_cycles[LAT_REGIONS] = {}; // sum of the draws
+
+    explicit LatencyInjector(uint64_t seed = 1) { reseed(seed); }
+
+    void reseed(uint64_t seed) {
+        for (int r = 0; r < LAT_REGIONS; r++) {
+            uint64_t x = seed + 0x9E3779B97F4A7C15ull * (r + 1);
+            state[r] = splitmix64(x) | 1; // xorshift needs a non-zero state
+        }
+    }
+
+    bool active() const {
+        return std::any_of(jitter, jitter + LAT_REGIONS,
+                           [](const JitterDistribution& d) { return d.kind != JitterDistribution::NONE; });
+    }
+
+    uint32_t draw(int region) {
+        const JitterDistribution& d = jitter[region];
+        uint32_t cycles = 0;
+        switch (d.kind) {
+            case JitterDistribution::UNIFORM:
+                cycles = next(region) % (uint64_t(d.cycles) + 1);
+                break;
+            case JitterDistribution::GEOMETRIC:
+                while (cycles < d.cycles && unit(region) < d.p) cycles++;
+                break;
+            case JitterDistribution::BIMODAL:
+                cycles = unit(region) < d.p ? d.cycles : 0;
+                break;
+            default:
+                break;
+        }
+        cycles = std::min<uint32_t>(cycles, 255);
+        requests[region]++;
+        extra_cycles[region] += cycles;
+        return cycles;
+    }
+
+    // Checkpoint support: generator states, so a restored run draws the same jitter
+    void save(VerilatedSerialize& os) const {
+        for (int r = 0; r < LAT_REGIONS; r++) os << state[r];
+    }
+
+    void restore(VerilatedDeserialize& os) {
+        for (int r = 0; r < LAT_REGIONS; r++) os >> state[r];
+    }
+
+private:
+    uint64_t state[LAT_REGIONS];
+
+    static uint64_t splitmix64(uint64_t x) {
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // xorshift64*
+    uint64_t next(int region) {
+        uint64_t& x = state[region];
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        return x * 0x2545F4914F6CDD1Dull;
+    }
+
+    double unit(int region) {
+        return (next(region) >> 11) * (1.0 / 9007199254740992.0); // [0, 1)
+    }
+};
@@ -0,0 +1,66 @@
+#pragma once
+
+// Mirrors src/defines.vh, shared by the testbench and the instruction-set simulator
+
+// Memory sizes in bytes, set by the Makefile (soc_multicycle ROM_SIZE/RAM_SIZE)
+#ifndef SOC_ROM_SIZE
+#define SOC_ROM_SIZE 4096
+#endif
+#ifndef SOC_RAM_SIZE
+#define SOC_RAM_SIZE 4096
+#endif
+// 1 = ROM/RAM live in the harness's SparseMemory stores instead of Verilated arrays
+#ifndef SOC_SPARSE_MEM
+#define SOC_SPARSE_MEM 0
+#endif
+
+// Sizes in 32-bit words
+# define ROM_SIZE (SOC_ROM_SIZE / 4)
+# define RAM_SIZE (SOC_RAM_SIZE / 4)
+
+// Memory map
+// RAM: SOC_RAM_SIZE bytes from 0x0000_0000
+#define RAM_BASE 0x00000000
+#define RAM_TOP  (RAM_BASE + SOC_RAM_SIZE - 1)
+// UART: 0x1000_0000 - 0x1000_00FF
+#define UART_BASE 0x10000000
+#define UART_TOP  0x100000FF
+// DMA: 0x1000_0100 - 0x1000_01FF
+#define DMA_BASE 0x10000100
+#define DMA_TOP  0x100001FF
+// CLINT timer: 0x0200_0000 - 0x0200_FFFF
+#define CLINT_BASE 0x02000000
+#define CLINT_TOP  0x0200FFFF
+// TOHOST: 0x1000_1000 - 0x1000_10FF
+#define TOHOST_BASE 0x10001000
+#define TOHOST_TOP  0x100010FF
+// TRACE_CTRL: bit 0 turns waveform recording on (traced builds), does not end the simulation
+#define TRACE_CTRL_ADDR (TOHOST_BASE + 0x80)
+
+// UART register offsets
+#define UART_TX_REG     0x0
+#define UART_RX_REG     0x4
+#define UART_STATUS_REG 0x8
+#define UART_BAUD_REG   0xC
+#define UART_LEVEL_REG  0x10 // [15:0] TX FIFO level, [31:16] RX FIFO level
+#define UART_THRESH_REG 0x14 // [15:0] TX threshold, [31:16] RX threshold
+#define UART_IRQ_EN_REG 0x18 // bit 0 RX interrupt, bit 1 TX empty interrupt
+
+// DMA register offsets (a descriptor in RAM holds SRC, DST, LEN, NEXT, CTRL in this order)
+#define DMA_SRC_REG    0x0  // source address, fill pattern for DMA_MODE_FILL
+#define DMA_DST_REG    0x4
+#define DMA_LEN_REG    0x8  // bytes
+#define DMA_NEXT_REG   0xC  // RAM address of the next descriptor, 0 = last
+#define DMA_CTRL_REG   0x10 // [1:0] mode, bit 31 starts the transfer
+#define DMA_STATUS_REG 0x14 // bit 0 busy, bit 1 done, bit 2 error
+
+#define DMA_MODE_COPY 0
+#define DMA_MODE_FILL 1
+#define DMA_MODE_UART 2
+#define DMA_START     0x80000000u
+
+// CLINT register offsets (64-bit registers as low/high words)
+#define CLINT_MTIMECMP_REG  0x4000
+#define CLINT_MTIMECMPH_REG 0x4004
+#define CLINT_MTIME_REG     0xBFF8
+#define CLINT_MTIMEH_REG    0xBFFC
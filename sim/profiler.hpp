@@ -0,0 +1,206 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Opcode classes of the profile, decoded from the instruction word
+enum OpClass { OPC_ALU, OPC_MULDIV, OPC_LOAD, OPC_STORE, OPC_BRANCH, OPC_JUMP, OPC_SYSTEM, OPC_OTHER, OPC_CLASSES };
+
+inline const char* op_class_name(int op_class) {
+    static const char* names[OPC_CLASSES] = {"ALU", "MULDIV", "LOAD", "STORE", "BRANCH", "JUMP", "SYSTEM", "OTHER"};
+    return names[op_class];
+}
+
+inline OpClass op_class(uint32_t instr) {
+    switch (instr & 0x7F) {
+        case 0x33: return (instr >> 25) == 0x01 ? OPC_MULDIV : OPC_ALU;
+        case 0x13: case 0x37: case 0x17: return OPC_ALU;
+        case 0x03: return OPC_LOAD;
+        case 0x23: return OPC_STORE;
+        case 0x63: return OPC_BRANCH;
+        case 0x6F: case 0x67: return OPC_JUMP;
+        case 0x73: return OPC_SYSTEM;
+        default: return OPC_OTHER;
+    }
+}
+
+// Cycle attribution collected by the harness while InstructionTest::profiling is set: every
+// simulated cycle is charged to one PC, one core state (the multicycle controller state) and
+// whether the bus controller was waiting on a peripheral in that cycle. Consecutive samples
+// mostly hit the same PC, so the common case is one compare and two increments.
+class CycleProfiler {
+public:
+    static const unsigned MAX_STATES = 16;
+
+    struct PcProfile {
+        uint64_t cycles[MAX_STATES][2] = {}; // [state][bus wait]
+        uint64_t retired = 0;
+
+        uint64_t total() const {
+            uint64_t sum = 0;
+            for (const auto& state : cycles) sum += state[0] + state[1];
+            return sum;
+        }
+    };
+
+    explicit CycleProfiler(std::vector<std::string> state_names) : state_names(std::move(state_names)) {}
+
+    void clear() {
+        pcs.clear();
+        last = nullptr;
+    }
+
+    void add(uint32_t pc, unsigned state, bool bus_wait, uint64_t cycles = 1) {
+        entry(pc).cycles[state % MAX_STATES][bus_wait] += cycles;
+    }
+
+    void retire(uint32_t pc) { entry(pc).retired++; }
+
+    const std::unordered_map<uint32_t, PcProfile>& by_pc() const { return pcs; }
+
+    uint64_t total_cycles() const {
+        uint64_t sum = 0;
+        for (const auto& entry : pcs) sum += entry.second.total();
+        return sum;
+    }
+
+    // Cycles spent in a state, by all PCs or by one
+    uint64_t state_cycles(const std::string& state) const {
+        uint64_t sum = 0;
+        for (const auto& entry : pcs) sum += state_cycles(entry.second, state);
+        return sum;
+    }
+
+    uint64_t state_cycles(uint32_t pc, const std::string& state) const {
+        auto it = pcs.find(pc);
+        return it == pcs.end() ? 0 : state_cycles(it->second, state);
+    }
+
+    uint64_t bus_wait_cycles() const {
+        uint64_t sum = 0;
+        for (const auto& entry : pcs)
+            for (const auto& state : entry.second.cycles) sum += state[1];
+        return sum;
+    }
+
+    // Folded stacks, one "CLASS;PC;STATE[;BUS_WAIT] cycles" line per combination, as read by
+    // flamegraph.pl, inferno and speedscope. `instr_at` returns the instruction word at a PC.
+    void write_folded(std::ostream& os, const std::function<uint32_t(uint32_t)>& instr_at) const {
+        for (uint32_t pc : sorted_pcs()) {
+            const PcProfile& p = pcs.at(pc);
+            const std::string frame = std::string(op_class_name(op_class(instr_at(pc)))) + ";" + hex(pc) + ";";
+            for (unsigned s = 0; s < MAX_STATES; s++) {
+                if (p.cycles[s][0]) os << frame << state_name(s) << " " << p.cycles[s][0] << "\n";
+                if (p.cycles[s][1]) os << frame << state_name(s) << ";BUS_WAIT " << p.cycles[s][1] << "\n";
+            }
+        }
+    }
+
+    // Cycles per state and per opcode class, then the `top` most expensive PCs with their CPI
+    // and the state they spend most of it in
+    void write_summary(std::ostream& os, const std::function<uint32_t(uint32_t)>& instr_at, size_t top = 20) const {
+        const uint64_t total = total_cycles();
+        uint64_t retired = 0;
+        uint64_t states[MAX_STATES] = {};
+        uint64_t classes[OPC_CLASSES] = {}, class_retired[OPC_CLASSES] = {};
+        for (const auto& entry : pcs) {
+            const OpClass c = op_class(instr_at(entry.first));
+            for (unsigned s = 0; s < MAX_STATES; s++) states[s] += entry.second.cycles[s][0] + entry.second.cycles[s][1];
+            classes[c] += entry.second.total();
+            class_retired[c] += entry.second.retired;
+            retired += entry.second.retired;
+        }
+
+        char line[160];
+        std::snprintf(line, sizeof(line), "Profile: %llu cycles, %llu instructions, CPI %.2f\n",
+                      (unsigned long long)total, (unsigned long long)retired, cpi(total, retired));
+        os << line;
+
+        os << "State             Cycles       %\n";
+        for (unsigned s = 0; s < MAX_STATES; s++) {
+            if (!states[s]) continue;
+            std::snprintf(line, sizeof(line), "%-12s %11llu  %5.1f%%\n", state_name(s).c_str(),
+                          (unsigned long long)states[s], percent(states[s], total));
+            os << line;
+        }
+        std::snprintf(line, sizeof(line), "%-12s %11llu  %5.1f%%  (overlaps the states)\n", "BUS_WAIT",
+                      (unsigned long long)bus_wait_cycles(), percent(bus_wait_cycles(), total));
+        os << line;
+
+        os << "Class             Cycles       %     Instrs    CPI\n";
+        for (int c = 0; c < OPC_CLASSES; c++) {
+            if (!classes[c]) continue;
+            std::snprintf(line, sizeof(line), "%-12s %11llu  %5.1f%% %10llu %6.2f\n", op_class_name(c),
+                          (unsigned long long)classes[c], percent(classes[c], total),
+                          (unsigned long long)class_retired[c], cpi(classes[c], class_retired[c]));
+            os << line;
+        }
+
+        std::vector<uint32_t> order = sorted_pcs();
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint32_t a, uint32_t b) { return pcs.at(a).total() > pcs.at(b).total(); });
+        if (order.size() > top) order.resize(top);
+        os << "PC         Class        Cycles       %     Instrs    CPI  Top state\n";
+        for (uint32_t pc : order) {
+            const PcProfile& p = pcs.at(pc);
+            unsigned top_state = 0;
+            for (unsigned s = 1; s < MAX_STATES; s++) {
+                if (p.cycles[s][0] + p.cycles[s][1] > p.cycles[top_state][0] + p.cycles[top_state][1]) top_state = s;
+            }
+            const uint64_t pc_total = p.total();
+            std::snprintf(line, sizeof(line), "%s %-8s %10llu  %5.1f%% %10llu %6.2f  %s %.0f%%\n", hex(pc).c_str(),
+                          op_class_name(op_class(instr_at(pc))), (unsigned long long)pc_total,
+                          percent(pc_total, total), (unsigned long long)p.retired, cpi(pc_total, p.retired),
+                          state_name(top_state).c_str(),
+                          percent(p.cycles[top_state][0] + p.cycles[top_state][1], pc_total));
+            os << line;
+        }
+    }
+
+private:
+    std::vector<std::string> state_names;
+    std::unordered_map<uint32_t, PcProfile> pcs;
+    uint32_t last_pc = 0;
+    PcProfile* last = nullptr; // element pointers stay valid when the map rehashes
+
+    PcProfile& entry(uint32_t pc) {
+        if (!last || pc != last_pc) {
+            last = &pcs[pc];
+            last_pc = pc;
+        }
+        return *last;
+    }
+
+    uint64_t state_cycles(const PcProfile& p, const std::string& state) const {
+        uint64_t sum = 0;
+        for (unsigned s = 0; s < state_names.size(); s++) {
+            if (state_names[s] == state) sum += p.cycles[s][0] + p.cycles[s][1];
+        }
+        return sum;
+    }
+
+    std::string state_name(unsigned state) const {
+        return state < state_names.size() ? state_names[state] : "STATE" + std::to_string(state);
+    }
+
+    std::vector<uint32_t> sorted_pcs() const {
+        std::vector<uint32_t> order;
+        for (const auto& entry : pcs) order.push_back(entry.first);
+        std::sort(order.begin(), order.end());
+        return order;
+    }
+
+    static std::string hex(uint32_t value) {
+        char buf[16];
+        std::snprintf(buf, sizeof(buf), "0x%08x", value);
+        return buf;
+    }
+
+    static double percent(uint64_t part, uint64_t total) { return total ? 100.0 * part / total : 0.0; }
+    static double cpi(uint64_t cycles, uint64_t instructions) { return instructions ? (double)cycles / instructions : 0.0; }
+};
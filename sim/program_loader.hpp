@@ -0,0 +1,186 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "memory_map.hpp"
+
+// A contiguous block of 32-bit words starting at a byte address
+struct MemorySegment {
+    uint32_t address;
+    std::vector<uint32_t> words;
+};
+
+// Program image split by destination memory (the SoC is Harvard: ROM and RAM both start at 0x0)
+struct ProgramImage {
+    std::vector<MemorySegment> rom;
+    std::vector<MemorySegment> ram;
+};
+
+// ELF32 definitions (only what the loader needs)
+namespace elf {
+    const uint8_t  ELFCLASS32  = 1;
+    const uint8_t  ELFDATA2LSB = 1;
+    const uint16_t EM_RISCV    = 243;
+    const uint32_t PT_LOAD     = 1;
+    const uint32_t PF_X        = 1;
+
+    struct Ehdr {
+        uint8_t  e_ident[16];
+        uint16_t e_type;
+        uint16_t e_machine;
+        uint32_t e_version;
+        uint32_t e_entry;
+        uint32_t e_phoff;
+        uint32_t e_shoff;
+        uint32_t e_flags;
+        uint16_t e_ehsize;
+        uint16_t e_phentsize;
+        uint16_t e_phnum;
+        uint16_t e_shentsize;
+        uint16_t e_shnum;
+        uint16_t e_shstrndx;
+    };
+
+    struct Phdr {
+        uint32_t p_type;
+        uint32_t p_offset;
+        uint32_t p_vaddr;
+        uint32_t p_paddr;
+        uint32_t p_filesz;
+        uint32_t p_memsz;
+        uint32_t p_flags;
+        uint32_t p_align;
+    };
+}
+
+// Load every PT_LOAD segment of a little-endian RV32 ELF file.
+// Executable segments go to ROM, everything else to RAM (by physical address).
+// Zero-filled (.bss) tails are included in the segment.
+inline bool load_elf_file(const std::string& path, ProgramImage& image, std::string& error) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    elf::Ehdr ehdr;
+    if (data.size() < sizeof(ehdr)) {
+        error = path + ": file too small for an ELF header";
+        return false;
+    }
+    std::memcpy(&ehdr, data.data(), sizeof(ehdr));
+
+    if (std::memcmp(ehdr.e_ident, "\x7f" "ELF", 4) != 0) {
+        error = path + ": not an ELF file";
+        return false;
+    }
+    if (ehdr.e_ident[4] != elf::ELFCLASS32 || ehdr.e_ident[5] != elf::ELFDATA2LSB ||
+        ehdr.e_machine != elf::EM_RISCV) {
+        error = path + ": not a little-endian RV32 ELF file";
+        return false;
+    }
+    if (ehdr.e_phentsize != sizeof(elf::Phdr) ||
+        ehdr.e_phoff + (uint64_t)ehdr.e_phnum * sizeof(elf::Phdr) > data.size()) {
+        error = path + ": corrupt program header table";
+        return false;
+    }
+
+    for (int i = 0; i < ehdr.e_phnum; i++) {
+        elf::Phdr phdr;
+        std::memcpy(&phdr, data.data() + ehdr.e_phoff + i * sizeof(elf::Phdr), sizeof(phdr));
+
+        if (phdr.p_type != elf::PT_LOAD || phdr.p_memsz == 0) continue;
+
+        if (phdr.p_paddr % 4 != 0) {
+            error = path + ": segment at address " + std::to_string(phdr.p_paddr) + " is not word aligned";
+            return false;
+        }
+        if ((uint64_t)phdr.p_offset + phdr.p_filesz > data.size() || phdr.p_filesz > phdr.p_memsz) {
+            error = path + ": segment data out of bounds";
+            return false;
+        }
+        // Larger than both memories, it cannot fit anywhere: fail before allocating the buffer
+        if (phdr.p_memsz > (uint32_t)std::max(SOC_ROM_SIZE, SOC_RAM_SIZE)) {
+            error = path + ": segment at address " + std::to_string(phdr.p_paddr) + " too large (" +
+                    std::to_string(phdr.p_memsz) + " bytes)";
+            return false;
+        }
+
+        MemorySegment segment;
+        segment.address = phdr.p_paddr;
+        segment.words.assign((phdr.p_memsz + 3) / 4, 0);
+        std::memcpy(segment.words.data(), data.data() + phdr.p_offset, phdr.p_filesz);
+
+        if (phdr.p_flags & elf::PF_X) {
+            image.rom.push_back(std::move(segment));
+        } else {
+            image.ram.push_back(std::move(segment));
+        }
+    }
+
+    if (image.rom.empty()) {
+        error = path + ": no executable segment";
+        return false;
+    }
+    return true;
+}
+
+// Load a $readmemh-style file into ROM: whitespace separated 32-bit hex words,
+// "@<word address>" to move the load address and "//" comments.
+inline bool load_hex_file(const std::string& path, ProgramImage& image, std::string& error) {
+    std::ifstream file(path);
+    if (!file) {
+        error = "cannot open " + path;
+        return false;
+    }
+
+    MemorySegment segment = {0, {}};
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        line = line.substr(0, line.find("//"));
+
+        std::istringstream tokens(line);
+        std::string token;
+        while (tokens >> token) {
+            std::string digits;
+            for (char ch : token.substr(token[0] == '@' ? 1 : 0)) {
+                if (ch != '_') digits += ch;
+            }
+
+            char* end = nullptr;
+            unsigned long value = std::strtoul(digits.c_str(), &end, 16);
+            if (digits.empty() || *end != '\0') {
+                error = path + ":" + std::to_string(line_number) + ": bad token '" + token + "'";
+                return false;
+            }
+            // Word addresses and words must fit in 32 bits (byte address 0xFFFFFFFC at most)
+            if (value > (token[0] == '@' ? 0x3FFFFFFFul : 0xFFFFFFFFul)) {
+                error = path + ":" + std::to_string(line_number) + ": value out of range '" + token + "'";
+                return false;
+            }
+
+            if (token[0] == '@') {
+                if (!segment.words.empty()) image.rom.push_back(std::move(segment));
+                segment = {static_cast<uint32_t>(value * 4), {}};
+            } else {
+                segment.words.push_back(static_cast<uint32_t>(value));
+            }
+        }
+    }
+    if (!segment.words.empty()) image.rom.push_back(std::move(segment));
+
+    if (image.rom.empty()) {
+        error = path + ": no data";
+        return false;
+    }
+    return true;
+}
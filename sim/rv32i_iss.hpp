@@ -0,0 +1,441 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <vector>
+#include "memory_map.hpp"
+
+// Functional RV32IM (+ Zicsr) instruction-set simulator using the SoC memory map:
+// ROM is fetched by PC (Harvard), RAM at RAM_BASE, UART at UART_BASE, DMA at DMA_BASE,
+// the CLINT timer at CLINT_BASE and TOHOST at TOHOST_BASE.
+// Used to fast-forward programs at host speed before handing the state to the RTL,
+// and as a reference model that is stepped once per RTL retirement (lockstep).
+class Rv32iIss {
+public:
+    uint32_t regs[32] = {};
+    uint32_t pc = 0;
+    std::vector<uint32_t> rom;
+    std::vector<uint32_t> ram;
+
+    bool halted = false;        // ECALL/EBREAK or TOHOST write
+    bool illegal = false;       // stopped on an instruction the core does not implement
+    uint32_t tohost = 0;
+    uint64_t instret = 0;
+
+    // UART model: TX is always ready, bytes looped back to RX when uart_loopback is set
+    bool uart_loopback = true;
+    uint8_t uart_baud = 10;
+    uint32_t uart_threshold = (1u << 16) | 8; // RX 1, TX 8 (half of the RTL FIFO)
+    std::string uart_output;
+    std::deque<uint8_t> uart_rx_fifo;
+    uint32_t uart_irq_enable = 0; // bit 0 RX at threshold, bit 1 TX empty (always, TX is instant)
+
+    // DMA model: a started chain completes at once. Registers SRC, DST, LEN, NEXT, CTRL.
+    uint32_t dma_regs[5] = {};
+    uint32_t dma_status = 0;
+
+    // CLINT model: mtime advances by one per instruction (the RTL counts cycles)
+    uint64_t mtime = 0;
+    uint64_t mtimecmp = ~0ull;
+
+    uint32_t mscratch = 0;
+
+    // Machine-mode trap CSRs (interrupts only, direct mode, MEIP driven by the UART model,
+    // MTIP by the CLINT model)
+    bool mstatus_mie = false;
+    bool mstatus_mpie = false;
+    uint32_t mie = 0;
+    uint32_t mtvec = 0;
+    uint32_t mepc = 0;
+    uint32_t mcause = 0;
+
+    // Destination register of the last instruction whose result depends on timing the ISS
+    // does not model (MMIO loads, cycle/instret/stall counter reads), 0 if none.
+    // In lockstep mode the harness overwrites it with the RTL value.
+    int last_sync_rd = 0;
+
+    Rv32iIss() : rom(ROM_SIZE, 0), ram(RAM_SIZE, 0) {}
+
+    // Run up to n instructions, returns how many were executed
+    uint64_t run(uint64_t n) {
+        uint64_t i = 0;
+        while (i < n && step()) i++;
+        return i;
+    }
+
+    // Execute one instruction. Returns false (without executing) once stopped.
+    bool step() {
+        if (halted || illegal) return false;
+
+        last_sync_rd = 0;
+        mtime++;
+
+        // Pending interrupt: enter the handler and execute its first instruction
+        if (mstatus_mie && (mie & mip())) {
+            mepc = pc;
+            mcause = 0x80000000u | ((mie & mip() & (1u << 11)) ? 11 : 7); // external first
+            mstatus_mpie = mstatus_mie;
+            mstatus_mie = false;
+            pc = mtvec;
+        }
+
+        uint32_t instr = rom[(pc >> 2) % rom.size()];
+        uint32_t opcode = instr & 0x7F;
+        int rd = (instr >> 7) & 0x1F;
+        uint32_t funct3 = (instr >> 12) & 0x7;
+        uint32_t funct7 = instr >> 25;
+        uint32_t a = regs[(instr >> 15) & 0x1F];
+        uint32_t b = regs[(instr >> 20) & 0x1F];
+
+        int32_t imm_i = (int32_t)instr >> 20;
+        int32_t imm_s = ((int32_t)(instr & 0xFE000000) >> 20) | ((instr >> 7) & 0x1F);
+        int32_t imm_b = ((int32_t)(instr & 0x80000000) >> 19) | ((instr & 0x80) << 4) |
+                        ((instr >> 20) & 0x7E0) | ((instr >> 7) & 0x1E);
+        uint32_t imm_u = instr & 0xFFFFF000;
+        int32_t imm_j = ((int32_t)(instr & 0x80000000) >> 11) | (instr & 0xFF000) |
+                        ((instr >> 9) & 0x800) | ((instr >> 20) & 0x7FE);
+
+        uint32_t next_pc = pc + 4;
+        uint32_t result = 0;
+        bool write_rd = true;
+
+        switch (opcode) {
+            case 0x37: result = imm_u; break;          // LUI
+            case 0x17: result = pc + imm_u; break;     // AUIPC
+            case 0x6F:                                 // JAL
+                result = pc + 4;
+                next_pc = pc + imm_j;
+                break;
+            case 0x67:                                 // JALR
+                result = pc + 4;
+                next_pc = (a + imm_i) & ~1u;
+                break;
+            case 0x63: {                               // BRANCH
+                bool taken;
+                switch (funct3) {
+                    case 0: taken = a == b; break;
+                    case 1: taken = a != b; break;
+                    case 4: taken = (int32_t)a < (int32_t)b; break;
+                    case 5: taken = (int32_t)a >= (int32_t)b; break;
+                    case 6: taken = a < b; break;
+                    case 7: taken = a >= b; break;
+                    default: return stop_illegal();
+                }
+                if (taken) next_pc = pc + imm_b;
+                write_rd = false;
+                break;
+            }
+            case 0x03:                                 // LOAD
+                if (!load(a + imm_i, funct3, result)) return stop_illegal();
+                if (is_mmio(a + imm_i)) last_sync_rd = rd;
+                break;
+            case 0x23:                                 // STORE
+                if (!store(a + imm_s, funct3, b)) return stop_illegal();
+                write_rd = false;
+                break;
+            case 0x13: {                               // OP-IMM
+                uint32_t shamt = (instr >> 20) & 0x1F;
+                switch (funct3) {
+                    case 0: result = a + imm_i; break;
+                    case 2: result = (int32_t)a < imm_i; break;
+                    case 3: result = a < (uint32_t)imm_i; break;
+                    case 4: result = a ^ imm_i; break;
+                    case 6: result = a | imm_i; break;
+                    case 7: result = a & imm_i; break;
+                    case 1:
+                        if (funct7 != 0x00) return stop_illegal();
+                        result = a << shamt;
+                        break;
+                    case 5:
+                        if (funct7 == 0x00) result = a >> shamt;
+                        else if (funct7 == 0x20) result = (int32_t)a >> shamt;
+                        else return stop_illegal();
+                        break;
+                }
+                break;
+            }
+            case 0x33:                                 // OP
+                switch ((funct7 << 3) | funct3) {
+                    case 0x000: result = a + b; break;
+                    case 0x100: result = a - b; break;
+                    case 0x001: result = a << (b & 0x1F); break;
+                    case 0x002: result = (int32_t)a < (int32_t)b; break;
+                    case 0x003: result = a < b; break;
+                    case 0x004: result = a ^ b; break;
+                    case 0x005: result = a >> (b & 0x1F); break;
+                    case 0x105: result = (int32_t)a >> (b & 0x1F); break;
+                    case 0x006: result = a | b; break;
+                    case 0x007: result = a & b; break;
+                    case 0x008: result = a * b; break;                                          // MUL
+                    case 0x009: result = (uint32_t)(((int64_t)(int32_t)a * (int32_t)b) >> 32); break; // MULH
+                    case 0x00A: result = (uint32_t)(((int64_t)(int32_t)a * (int64_t)b) >> 32); break; // MULHSU
+                    case 0x00B: result = (uint32_t)(((uint64_t)a * b) >> 32); break;            // MULHU
+                    case 0x00C:                                                                 // DIV
+                        result = (b == 0) ? 0xFFFFFFFFu :
+                                 (a == 0x80000000u && b == 0xFFFFFFFFu) ? a : (uint32_t)((int32_t)a / (int32_t)b);
+                        break;
+                    case 0x00D: result = (b == 0) ? 0xFFFFFFFFu : a / b; break;                 // DIVU
+                    case 0x00E:                                                                 // REM
+                        result = (b == 0) ? a :
+                                 (a == 0x80000000u && b == 0xFFFFFFFFu) ? 0 : (uint32_t)((int32_t)a % (int32_t)b);
+                        break;
+                    case 0x00F: result = (b == 0) ? a : a % b; break;                           // REMU
+                    default: return stop_illegal();
+                }
+                break;
+            case 0x73: {                               // SYSTEM
+                if (funct3 == 0 && funct7 == 0x18) {   // MRET
+                    mstatus_mie = mstatus_mpie;
+                    mstatus_mpie = true;
+                    pc = mepc;
+                    instret++;
+                    return true;
+                }
+                if (funct3 == 0 && funct7 == 0x08) {   // WFI: sleep only changes timing
+                    pc += 4;
+                    instret++;
+                    return true;
+                }
+                if (funct3 == 0) {                     // ECALL/EBREAK
+                    halted = true;
+                    instret++;
+                    return true;
+                }
+                if (funct3 == 4) return stop_illegal();
+
+                uint32_t csr = instr >> 20;
+                uint32_t src = (funct3 & 4) ? ((instr >> 15) & 0x1F) : a;
+                bool csr_write = (funct3 & 3) == 1 || ((instr >> 15) & 0x1F) != 0;
+                result = read_csr(csr, rd);
+                if (csr_write) {
+                    switch (funct3 & 3) {
+                        case 1: write_csr(csr, src); break;
+                        case 2: write_csr(csr, result | src); break;
+                        case 3: write_csr(csr, result & ~src); break;
+                    }
+                }
+                break;
+            }
+            default:
+                return stop_illegal();
+        }
+
+        if (write_rd && rd != 0) regs[rd] = result;
+        pc = next_pc;
+        instret++;
+        return true;
+    }
+
+    uint32_t mip() const {
+        bool rx = (uart_irq_enable & 1) && uart_rx_fifo.size() >= (uart_threshold >> 16);
+        bool tx = (uart_irq_enable & 2) != 0;
+        return ((rx || tx) ? (1u << 11) : 0) | (mtime >= mtimecmp ? (1u << 7) : 0);
+    }
+
+private:
+    // Counters are read back from the RTL in lockstep mode (see last_sync_rd)
+    static bool is_counter(uint32_t csr) {
+        return (csr >= 0xB00 && csr <= 0xB1F) || (csr >= 0xB80 && csr <= 0xB9F) ||
+               (csr >= 0xC00 && csr <= 0xC1F) || (csr >= 0xC80 && csr <= 0xC9F);
+    }
+
+    uint32_t read_csr(uint32_t csr, int rd) {
+        if (is_counter(csr)) last_sync_rd = rd;
+
+        switch (csr) {
+            case 0x301: return 0x40001100;  // misa: RV32IM
+            case 0x340: return mscratch;
+            case 0x300: return 0x1800 | (mstatus_mpie << 7) | (mstatus_mie << 3); // MPP = M
+            case 0x304: return mie;
+            case 0x305: return mtvec;
+            case 0x341: return mepc;
+            case 0x342: return mcause;
+            case 0x344: last_sync_rd = rd; return mip();
+            case 0xB02:
+            case 0xC02: return (uint32_t)instret;
+            case 0xB82:
+            case 0xC82: return (uint32_t)(instret >> 32);
+            default:    return 0;           // mhartid, other counters and unimplemented CSRs
+        }
+    }
+
+    void write_csr(uint32_t csr, uint32_t value) {
+        switch (csr) {
+            case 0x340: mscratch = value; break;
+            case 0x300:
+                mstatus_mie = (value >> 3) & 1;
+                mstatus_mpie = (value >> 7) & 1;
+                break;
+            case 0x304: mie = value & ((1u << 11) | (1u << 7)); break;
+            case 0x305: mtvec = value & ~3u; break;
+            case 0x341: mepc = value & ~3u; break;
+            case 0x342: mcause = value; break;
+        }
+    }
+
+    bool stop_illegal() {
+        illegal = true;
+        return false;
+    }
+
+    static bool is_mmio(uint32_t addr) {
+        return addr > RAM_TOP;
+    }
+
+    // Unmapped addresses fall back to RAM word 0, like bus_controller
+    uint32_t& ram_word(uint32_t addr) {
+        return (addr <= RAM_TOP) ? ram[((addr - RAM_BASE) >> 2) % ram.size()] : ram[0];
+    }
+
+    bool load(uint32_t addr, uint32_t funct3, uint32_t& value) {
+        if (addr >= UART_BASE && addr <= UART_TOP) {
+            // Peripherals return the raw register, the load mode is not applied
+            switch (addr - UART_BASE) {
+                case UART_RX_REG:
+                    value = uart_rx_fifo.empty() ? 0 : uart_rx_fifo.front();
+                    if (!uart_rx_fifo.empty()) uart_rx_fifo.pop_front();
+                    break;
+                case UART_STATUS_REG:
+                    // TX ready, idle and below its threshold; RX ready and threshold from the FIFO
+                    value = 0xD | (uart_rx_fifo.empty() ? 0 : 0x2) |
+                            (uart_rx_fifo.size() >= (uart_threshold >> 16) ? 0x10 : 0);
+                    break;
+                case UART_LEVEL_REG:
+                    value = (uint32_t)uart_rx_fifo.size() << 16;
+                    break;
+                case UART_THRESH_REG:
+                    value = uart_threshold;
+                    break;
+                case UART_IRQ_EN_REG:
+                    value = uart_irq_enable;
+                    break;
+                default:
+                    value = 0;
+                    break;
+            }
+            return true;
+        }
+        if (addr >= DMA_BASE && addr <= DMA_TOP) {
+            uint32_t offset = addr - DMA_BASE;
+            if (offset == DMA_STATUS_REG) value = dma_status;
+            else if (offset == DMA_CTRL_REG) value = dma_regs[4] & 3;
+            else value = (offset < DMA_CTRL_REG && (offset & 3) == 0) ? dma_regs[offset >> 2] : 0;
+            return true;
+        }
+        if (addr >= CLINT_BASE && addr <= CLINT_TOP) {
+            switch (addr - CLINT_BASE) {
+                case CLINT_MTIMECMP_REG:  value = (uint32_t)mtimecmp; break;
+                case CLINT_MTIMECMPH_REG: value = (uint32_t)(mtimecmp >> 32); break;
+                case CLINT_MTIME_REG:     value = (uint32_t)mtime; break;
+                case CLINT_MTIMEH_REG:    value = (uint32_t)(mtime >> 32); break;
+                default:                  value = 0; break;
+            }
+            return true;
+        }
+        if (addr >= TOHOST_BASE && addr <= TOHOST_TOP) {
+            value = tohost;
+            return true;
+        }
+
+        uint32_t word = ram_word(addr);
+        uint32_t offset = (addr <= RAM_TOP) ? (addr & 3) : 0;
+        switch (funct3) {
+            case 0: value = (int32_t)(int8_t)(word >> (offset * 8)); break;       // LB
+            case 1: value = (int32_t)(int16_t)(word >> (offset & 2) * 8); break;  // LH
+            case 2: value = word; break;                                          // LW
+            case 4: value = (word >> (offset * 8)) & 0xFF; break;                 // LBU
+            case 5: value = (word >> (offset & 2) * 8) & 0xFFFF; break;           // LHU
+            default: return false;
+        }
+        return true;
+    }
+
+    // Run the descriptor chain starting with the registers, same checks as src/dma.v
+    void dma_run() {
+        const uint64_t ram_end = (uint64_t)RAM_TOP + 1;
+        dma_status = 0x2;
+        for (int n = 0; n < 4096; n++) {
+            uint32_t src = dma_regs[0], dst = dma_regs[1], len = dma_regs[2], next = dma_regs[3];
+            uint32_t mode = dma_regs[4] & 3;
+            bool src_ok = (uint64_t)src + len <= ram_end;
+            bool dst_ok = (uint64_t)dst + len <= ram_end;
+            bool ok = (mode == DMA_MODE_COPY && src_ok && dst_ok && !(src & 3) && !(dst & 3) && !(len & 3)) ||
+                      (mode == DMA_MODE_FILL && dst_ok && !(dst & 3) && !(len & 3)) ||
+                      (mode == DMA_MODE_UART && src_ok);
+            if (!ok) { dma_status = 0x4; return; }
+
+            if (mode == DMA_MODE_UART) {
+                uint32_t byte = 0;
+                for (uint32_t i = 0; i < len; i++) {
+                    load(src + i, 4, byte);
+                    store(UART_BASE + UART_TX_REG, 0, byte);
+                }
+            } else {
+                for (uint32_t i = 0; i < len / 4; i++)
+                    ram_word(dst + 4 * i) = (mode == DMA_MODE_FILL) ? src : ram_word(src + 4 * i);
+            }
+
+            if (next == 0) return;
+            if ((uint64_t)next + 20 > ram_end || (next & 3)) { dma_status = 0x4; return; }
+            for (int i = 0; i < 5; i++) dma_regs[i] = ram_word(next + 4 * i);
+        }
+    }
+
+    bool store(uint32_t addr, uint32_t funct3, uint32_t value) {
+        if (funct3 > 2) return false;
+
+        if (addr >= UART_BASE && addr <= UART_TOP) {
+            if (addr - UART_BASE == UART_TX_REG) {
+                uart_output += (char)(value & 0xFF);
+                if (uart_loopback) uart_rx_fifo.push_back(value & 0xFF);
+            } else if (addr - UART_BASE == UART_BAUD_REG) {
+                uart_baud = value & 0xFF;
+            } else if (addr - UART_BASE == UART_THRESH_REG) {
+                uart_threshold = value;
+            } else if (addr - UART_BASE == UART_IRQ_EN_REG) {
+                uart_irq_enable = value & 3;
+            }
+            return true;
+        }
+        if (addr >= DMA_BASE && addr <= DMA_TOP) {
+            uint32_t offset = addr - DMA_BASE;
+            if (offset <= DMA_CTRL_REG && (offset & 3) == 0) {
+                dma_regs[offset >> 2] = value;
+                if (offset == DMA_CTRL_REG && (value & DMA_START)) dma_run();
+            }
+            return true;
+        }
+        if (addr >= CLINT_BASE && addr <= CLINT_TOP) {
+            switch (addr - CLINT_BASE) {
+                case CLINT_MTIMECMP_REG:  mtimecmp = (mtimecmp & ~0xFFFFFFFFull) | value; break;
+                case CLINT_MTIMECMPH_REG: mtimecmp = (mtimecmp & 0xFFFFFFFFull) | ((uint64_t)value << 32); break;
+                case CLINT_MTIME_REG:     mtime = (mtime & ~0xFFFFFFFFull) | value; break;
+                case CLINT_MTIMEH_REG:    mtime = (mtime & 0xFFFFFFFFull) | ((uint64_t)value << 32); break;
+            }
+            return true;
+        }
+        if (addr == TRACE_CTRL_ADDR) return true;
+        if (addr >= TOHOST_BASE && addr <= TOHOST_TOP) {
+            tohost = value;
+            halted = true;
+            return true;
+        }
+
+        uint32_t& word = ram_word(addr);
+        uint32_t offset = (addr <= RAM_TOP) ? (addr & 3) : 0;
+        switch (funct3) {
+            case 0: {                                                   // SB
+                uint32_t shift = offset * 8;
+                word = (word & ~(0xFFu << shift)) | ((value & 0xFF) << shift);
+                break;
+            }
+            case 1: {                                                   // SH
+                uint32_t shift = (offset & 2) * 8;
+                word = (word & ~(0xFFFFu << shift)) | ((value & 0xFFFF) << shift);
+                break;
+            }
+            case 2: word = value; break;                                // SW
+        }
+        return true;
+    }
+};
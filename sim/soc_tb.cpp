@@ -1,80 +1,440 @@
 #include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cinttypes>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 #include "Vsoc_multicycle.h"
 #include "instruction_tests.hpp"
+#include "program_loader.hpp"
+#include "test_runner.hpp"
+
+// Build configuration, set by the Makefile
+#ifndef SOC_IMEM_LATENCY
+#define SOC_IMEM_LATENCY 1
+#endif
+
+static void print_usage(const char* prog) {
+    std::cout << "Usage: " << prog << " [--elf FILE | --hex FILE]... [--max-cycles N] [--dump-regs]\n"
+              << "       [--latency I,D,U] [--jitter SPEC] [--seed N] [--sweep imem|dmem:FROM:TO]\n"
+              << "       [--profile PREFIX] [--commit-log PREFIX] [--trace PREFIX] [--trace-window FROM:TO]\n"
+              << "       [--trace-pc PC[:CYCLES]] [--bench [CYCLES]] [--workloads]\n"
+              << "  Without a program the built-in instruction tests are run.\n"
+              << "  --elf FILE      load the PT_LOAD segments of an RV32 ELF (executable -> ROM, data -> RAM)\n"
+              << "  --hex FILE      load a $readmemh-style word file into ROM\n"
+              << "  --max-cycles N  stop after N cycles if the program has not halted (default 1000000)\n"
+              << "  --dump-regs     print x0-x31 after each program\n"
+              << "  --latency I,D,U ROM, RAM and UART latency in cycles (0 = the build's parameter)\n"
+              << "  --jitter SPEC   random extra cycles per ROM/RAM request: uniform:MAX, geometric:P[:CAP]\n"
+              << "                  or bimodal:P:CYCLES\n"
+              << "  --seed N        jitter seed (default 1)\n"
+              << "  --sweep R:A:B   run every program at each ROM (imem) or RAM (dmem) latency from A to B\n"
+              << "  --profile PREFIX attribute every cycle to PC, opcode class and core state, write\n"
+              << "                  PREFIX<program>.folded (flamegraph input) and print a summary\n"
+              << "  --commit-log PREFIX write every retirement to PREFIX<program>.commits (binary,\n"
+              << "                  convert with commit_log_spike)\n"
+              << "  --trace PREFIX  waveforms to PREFIX<program>.fst (traced build, make TRACE=1): the whole\n"
+              << "                  run, or only --trace-window cycles [FROM, TO) and CYCLES cycles from the\n"
+              << "                  first time the PC reaches --trace-pc. Firmware can add windows by writing\n"
+              << "                  1/0 to TRACE_CTRL (0x10001080).\n"
+              << "  --bench [CYCLES] time CYCLES cycles (default 20000000) of a built-in load/store/ALU/mul\n"
+              << "                  loop and print the simulation speed\n"
+              << "  --workloads     run the bundled benchmark programs (memcpy, CRC32, sort, ...) and\n"
+              << "                  print cycles, instructions and CPI for each\n"
+              << "  Several programs can be given, they run in parallel on separate models.\n"
+              << "  A program passes when it halts with TOHOST = 0 or 1 (riscv-tests convention).\n";
+}
+
+struct ProgramJob {
+    std::string path;
+    bool is_elf;
+};
+
+// Runtime latency settings applied to every program run
+struct LatencyConfig {
+    int imem = 0, dmem = 0, uart = 0;
+    JitterDistribution jitter;
+    uint64_t seed = 1;
+};
+
+// "uniform:MAX", "geometric:P[:CAP]" or "bimodal:P:CYCLES"
+static bool parse_jitter(const std::string& spec, JitterDistribution& jitter) {
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    for (std::string field; std::getline(ss, field, ':');) fields.push_back(field);
+    if (fields.size() == 2 && fields[0] == "uniform") {
+        jitter = JitterDistribution::uniform(std::atoi(fields[1].c_str()));
+    } else if ((fields.size() == 2 || fields.size() == 3) && fields[0] == "geometric") {
+        jitter = JitterDistribution::geometric(std::atof(fields[1].c_str()),
+                                               fields.size() == 3 ? std::atoi(fields[2].c_str()) : 255);
+    } else if (fields.size() == 3 && fields[0] == "bimodal") {
+        jitter = JitterDistribution::bimodal(std::atof(fields[1].c_str()), std::atoi(fields[2].c_str()));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// Output options of a program run. With a prefix, every run writes <prefix><program>.folded
+// (plus the summary in its result) or <prefix><program>.commits.
+struct RunOptions {
+    int max_cycles = 1000000;
+    bool dump_regs = false;
+    std::string profile_prefix;
+    std::string commit_log_prefix;
+    std::string trace_prefix;   // waveform file prefix, traced builds
+    bool trace_whole_run = false;
+    TraceTriggers trace_triggers;
+};
+
+// Run firmware images given on the command line instead of the built-in tests
+static int run_programs(const std::vector<ProgramJob>& jobs, const RunOptions& options,
+                        const std::vector<LatencyConfig>& configs) {
+    std::vector<TestFunction> runs;
+    for (const auto& job : jobs) {
+        for (const auto& config : configs) {
+            std::string label = job.path;
+            std::string stem = job.path.substr(job.path.find_last_of('/') + 1);
+            stem = stem.substr(0, stem.find('.'));
+            if (configs.size() > 1) {
+                label += " [imem " + std::to_string(config.imem) + ", dmem " + std::to_string(config.dmem) + "]";
+                stem += "_imem" + std::to_string(config.imem) + "_dmem" + std::to_string(config.dmem);
+            }
+            runs.push_back([job, config, label, stem, options](InstructionTest& tester) {
+                const int max_cycles = options.max_cycles;
+                tester.profiling = !options.profile_prefix.empty();
+                tester.trace_file = options.trace_prefix + stem + ".fst";
+                tester.trace_enabled = options.trace_whole_run;
+                tester.trace_triggers = options.trace_triggers;
+                tester.set_latency(config.imem, config.dmem, config.uart);
+                tester.latency.reseed(config.seed);
+                tester.set_jitter(LAT_IMEM, config.jitter);
+                tester.set_jitter(LAT_DMEM, config.jitter);
+
+                ProgramImage image;
+                std::string error;
+                bool loaded = job.is_elf ? load_elf_file(job.path, image, error)
+                                         : load_hex_file(job.path, image, error);
+                if (!loaded || !tester.load_image(image, error)) {
+                    tester.results.push_back({label, false, error + "\n", 0});
+                    return;
+                }
+
+                const std::string log_file = options.commit_log_prefix + stem + ".commits";
+                if (!options.commit_log_prefix.empty() && !tester.commit_log.open(log_file)) {
+                    tester.results.push_back({label, false, "Cannot write " + log_file + "\n", 0});
+                    return;
+                }
+
+                int cycles = tester.run_simulation(max_cycles);
+                bool halted = tester.dut->halted;
+                uint32_t tohost = tester.dut->tohost;
+
+                std::string message;
+                if (!halted) {
+                    message += "Did not halt within " + std::to_string(max_cycles) + " cycles\n";
+                } else if (tohost > 1) {
+                    message += "TOHOST = 0x" + tester.to_hex(tohost) + "\n";
+                }
+                if (options.dump_regs) message += tester.dump_registers();
+                if (tester.commit_log.is_open()) {
+                    message += std::to_string(tester.commit_log.records()) + " instructions logged to " + log_file + "\n";
+                    tester.commit_log.close();
+                }
+                if (tester.profiling) {
+                    std::ofstream folded(options.profile_prefix + stem + ".folded");
+                    std::stringstream summary;
+                    tester.write_profile(folded, summary, 10);
+                    message += summary.str();
+                }
+
+                tester.results.push_back({label, halted && tohost <= 1, message, cycles});
+            });
+        }
+    }
+
+    TestRunner runner;
+    runner.run(runs);
+
+    int failed = 0;
+    for (const auto& r : runner.results) {
+        std::cout << "Program: " << r.test_name << " - " << (r.passed ? "PASSED" : "FAILED!!!!!")
+                  << " (" << r.cycles << " cycles)\n" << r.message;
+        if (!r.passed) failed++;
+    }
+    return failed;
+}
+
+// Simulator throughput: a fixed endless loop over 64 RAM words, so every build profile and
+// configuration is timed on the same instruction mix
+//   outer: addi x5, x0, 0
+//          addi x6, x0, 64
+//   inner: lw   x7, 0(x5)
+//          add  x7, x7, x6
+//          mul  x28, x7, x6
+//          xor  x7, x7, x28
+//          sw   x7, 0(x5)
+//          addi x5, x5, 4
+//          addi x6, x6, -1
+//          bne  x6, x0, inner
+//          jal  x0, outer
+static int run_bench(int cycles) {
+    InstructionTest tester;
+    tester.load_instructions({
+        0x00000293, 0x04000313, 0x0002a383, 0x006383b3, 0x02638e33, 0x01c3c3b3,
+        0x0072a023, 0x00428293, 0xfff30313, 0xfe0312e3, 0xfd9ff06f,
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    const int simulated = tester.run_simulation(cycles);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const uint64_t instructions = tester.dut->soc_multicycle__DOT__gen_cpu__DOT__cpu_inst__DOT__csr_inst__DOT__minstret;
+
+    if (tester.dut->halted || simulated != cycles) {
+        std::cerr << "Bench: workload stopped after " << simulated << " cycles\n";
+        return 1;
+    }
+    const double hz = seconds > 0 ? simulated / seconds : 0.0;
+    std::printf("Bench: %d cycles, %llu instructions in %.3f s = %.3f MHz (%.1f kHz), CPI %.2f\n", simulated,
+                (unsigned long long)instructions, seconds, hz / 1e6, hz / 1e3,
+                instructions ? (double)simulated / instructions : 0.0);
+    return 0;
+}
+
+// Bundled workloads (workloads.hpp) in parallel, with cycles, instructions and CPI per program
+static int run_workloads() {
+    std::vector<TestFunction> runs;
+    for (const Workload& workload : WORKLOADS)
+        runs.push_back([&workload](InstructionTest& tester) { tester.run_workload(workload); });
+
+    TestRunner runner;
+    runner.run(runs);
+
+    int failed = 0;
+    for (const auto& r : runner.results) {
+        std::cout << r.test_name << " - " << (r.passed ? "PASSED" : "FAILED!!!!!") << " (" << r.cycles << " cycles)\n"
+                  << r.message;
+        if (!r.passed) failed++;
+    }
+    return failed;
+}
 
 int main(int argc, char** argv) {
     Verilated::commandArgs(argc, argv);
-    Verilated::traceEverOn(true);
 
-    InstructionTest tester;
+    std::vector<ProgramJob> programs;
+    RunOptions options;
+    LatencyConfig latency;
+    std::string sweep;
+    bool trace = false, trace_window = false;
+    int bench_cycles = 0;
+    bool workloads = false;
+
+    for (int i = 1; i < argc; i++) {
+        if ((!std::strcmp(argv[i], "--elf") || !std::strcmp(argv[i], "--hex")) && i + 1 < argc) {
+            programs.push_back({argv[i + 1], argv[i][2] == 'e'});
+            i++;
+        } else if (!std::strcmp(argv[i], "--max-cycles") && i + 1 < argc) {
+            options.max_cycles = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--dump-regs")) {
+            options.dump_regs = true;
+        } else if (!std::strcmp(argv[i], "--latency") && i + 1 < argc &&
+                   std::sscanf(argv[i + 1], "%d,%d,%d", &latency.imem, &latency.dmem, &latency.uart) >= 2) {
+            i++;
+        } else if (!std::strcmp(argv[i], "--jitter") && i + 1 < argc && parse_jitter(argv[i + 1], latency.jitter)) {
+            i++;
+        } else if (!std::strcmp(argv[i], "--seed") && i + 1 < argc) {
+            latency.seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (!std::strcmp(argv[i], "--sweep") && i + 1 < argc) {
+            sweep = argv[++i];
+        } else if (!std::strcmp(argv[i], "--profile") && i + 1 < argc) {
+            options.profile_prefix = argv[++i];
+        } else if (!std::strcmp(argv[i], "--commit-log") && i + 1 < argc) {
+            options.commit_log_prefix = argv[++i];
+        } else if (!std::strcmp(argv[i], "--trace") && i + 1 < argc) {
+            options.trace_prefix = argv[++i];
+            trace = true;
+        } else if (!std::strcmp(argv[i], "--trace-window") && i + 1 < argc &&
+                   std::sscanf(argv[i + 1], "%" SCNu64 ":%" SCNu64, &options.trace_triggers.from_cycle,
+                               &options.trace_triggers.to_cycle) == 2) {
+            i++;
+            trace_window = true;
+        } else if (!std::strcmp(argv[i], "--trace-pc") && i + 1 < argc &&
+                   std::sscanf(argv[i + 1], "%" SCNx32 ":%" SCNu64, &options.trace_triggers.pc,
+                               &options.trace_triggers.pc_cycles) >= 1) {
+            i++;
+            options.trace_triggers.on_pc = true;
+            trace_window = true;
+        } else if (!std::strcmp(argv[i], "--bench")) {
+            bench_cycles = 20000000;
+            if (i + 1 < argc && std::isdigit((unsigned char)argv[i + 1][0])) bench_cycles = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--workloads")) {
+            workloads = true;
+        } else if (!std::strcmp(argv[i], "--help")) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (argv[i][0] != '+') { // +args belong to Verilator
+            print_usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (trace && !SOC_TRACE) {
+        std::cerr << "--trace needs the traced simulator (make TRACE=1)\n";
+        return 2;
+    }
+    options.trace_whole_run = trace && !trace_window;
+
+    if (bench_cycles > 0) return run_bench(bench_cycles);
+    if (workloads) {
+        if (SOC_RAM_SIZE < 4096) {
+            std::cerr << "--workloads needs at least 4KB of RAM (RAM_SIZE=4096)\n";
+            return 2;
+        }
+        return run_workloads();
+    }
+
+    if (!programs.empty()) {
+        // One run per sweep point, all on the same binary
+        std::vector<LatencyConfig> configs;
+        char region[8] = {};
+        int from = 0, to = 0;
+        if (sweep.empty()) {
+            configs.push_back(latency);
+        } else if (std::sscanf(sweep.c_str(), "%7[a-z]:%d:%d", region, &from, &to) == 3 &&
+                   (!std::strcmp(region, "imem") || !std::strcmp(region, "dmem")) && 1 <= from && from <= to && to <= 255) {
+            for (int l = from; l <= to; l++) {
+                LatencyConfig config = latency;
+                (region[0] == 'i' ? config.imem : config.dmem) = l;
+                configs.push_back(config);
+            }
+        } else {
+            print_usage(argv[0]);
+            return 2;
+        }
+        return run_programs(programs, options, configs);
+    }
+
+    // Every test gets its own model, so they can all run in parallel
+    std::vector<TestFunction> tests = {
+        test_lui,
+        test_auipc,
+
+        test_addi,
+        test_slti,
+        test_sltiu,
+        test_xori,
+        test_ori,
+        test_andi,
+        test_slli,
+        test_srli,
+        test_srai,
+
+        test_add,
+        test_sub,
+        test_sll,
+        test_slt,
+        test_sltu,
+        test_xor,
+        test_srl,
+        test_sra,
+        test_or,
+        test_and,
+
+        test_mul,
+        test_mulh,
+        test_mulhsu,
+        test_mulhu,
+        test_div,
+        test_divu,
+        test_rem,
+        test_remu,
+        test_muldiv_speedup,
+
+        test_lb,
+        test_lh,
+        test_lw,
+        test_lbu,
+        test_lhu,
+
+        test_sb,
+        test_sh,
+        test_sw,
+
+        test_jal,
+        test_jalr,
+
+        test_beq,
+        test_bne,
+        test_blt,
+        test_bge,
+        test_bltu,
+        test_bgeu,
+
+        test_csr,
+        test_counters,
+
+        test_hazards,
+        test_store_buffer,
+        test_memory_size,
+// The throughput tests count cycles with 1-cycle, uncached instruction fetch
+#if !SOC_ICACHE && SOC_IMEM_LATENCY == 1
+#if CORE_PIPELINED
+        test_pipeline_throughput,
+#else
+        test_overlapped_fetch,
+#endif
+#endif
+#if SOC_ICACHE
+        test_icache,
+#endif
+#if SOC_DCACHE
+        test_dcache,
+#endif
+#if SOC_ICACHE || SOC_DCACHE
+        test_cache_bursts,
+#endif
+
+        test_fibo,
+        test_checkpoint_fork,
+        test_iss_fast_forward,
+        test_iss_lockstep,
+        test_commit_log,
+        test_latency_sweep,
+        test_latency_jitter,
+        test_profiler,
+        test_trace_control,
+        // test_uart_tx,
+        // test_uart_tx2,
 
-    VerilatedVcdC* tfp = new VerilatedVcdC;
-    tester.dut->trace(tfp, 99);
-    tfp->open("soc_tb.vcd");
-    tester.tfp = tfp;
+        test_uart_loopback,
+        test_uart_fifo,
+        test_dma,
+#if !CORE_PIPELINED
+        test_interrupts, // traps are only implemented in the multicycle core
+        test_wfi,
+        test_timer,
+#endif
+    };
+    // The workloads use 4KB of RAM
+    if (SOC_RAM_SIZE >= 4096) {
+        for (const Workload& workload : WORKLOADS)
+            tests.push_back([&workload](InstructionTest& tester) { tester.run_workload(workload); });
+    }
 
     std::cout << "=== RV32I Instruction Tests ===\n\n";
 
-    test_lui(tester);
-    test_auipc(tester);
-
-    test_addi(tester);
-    test_slti(tester);
-    test_sltiu(tester);
-    test_xori(tester);
-    test_ori(tester);
-    test_andi(tester);
-    test_slli(tester);
-    test_srli(tester);
-    test_srai(tester);
-
-    test_add(tester);
-    test_sub(tester);
-    test_sll(tester);
-    test_slt(tester);
-    test_sltu(tester);
-    test_xor(tester);
-    test_srl(tester);
-    test_sra(tester);
-    test_or(tester);
-    test_and(tester);
-
-    test_lb(tester);
-    test_lh(tester);
-    test_lw(tester);
-    test_lbu(tester);
-    test_lhu(tester);
-
-    test_sb(tester);
-    test_sh(tester);
-    test_sw(tester);
-
-    test_jal(tester);
-    test_jalr(tester);
-
-    test_beq(tester);
-    test_bne(tester);
-    test_blt(tester);
-    test_bge(tester);
-    test_bltu(tester);
-    test_bgeu(tester);
-
-    test_fibo(tester);
-    // test_uart_tx(tester);
-    // test_uart_tx2(tester);
-
-    test_uart_loopback(tester);
-
-    tester.print_results();
-
-    tfp->close();
-    delete tfp;
+    TestRunner runner;
+    runner.run(tests);
+    runner.print_results();
 
     // Return non-zero if any test failed
     int failed = 0;
-    for (const auto& r : tester.results)
+    for (const auto& r : runner.results)
         if (!r.passed) failed++;
     return failed;
-}
\ No newline at end of file
+}
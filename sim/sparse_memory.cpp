@@ -0,0 +1,17 @@
+// DPI side of src/sparse_mem.vh: `store` is the SparseMemory* the harness put on the SoC's
+// rom_store/ram_store ports, so every model reaches its own memory without a scope lookup.
+#include "Vsoc_multicycle__Dpi.h"
+#include "sparse_memory.hpp"
+
+static SparseMemory* sparse_store(long long store) {
+    return reinterpret_cast<SparseMemory*>(static_cast<uintptr_t>(store));
+}
+
+int sparse_mem_read(long long store, int word_index) {
+    return static_cast<int>(sparse_store(store)->read(static_cast<uint32_t>(word_index)));
+}
+
+void sparse_mem_write(long long store, int word_index, int data, int byte_mask) {
+    sparse_store(store)->write(static_cast<uint32_t>(word_index), static_cast<uint32_t>(data),
+                               static_cast<uint32_t>(byte_mask));
+}
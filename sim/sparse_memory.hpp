@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <verilated_save.h>
+
+// Word-addressed memory that allocates 4KB pages on the first write. Untouched words read as
+// the background value, so a multi-MB ROM/RAM costs only the pages a program uses and clearing
+// it between loads just drops them. Backs imem_sync/dmem_sync through DPI when the SoC is built
+// with SPARSE_MEM (see src/sparse_mem.vh and sparse_memory.cpp).
+class SparseMemory {
+public:
+    static const uint32_t PAGE_WORDS = 1024;
+
+    explicit SparseMemory(size_t words, uint32_t background = 0)
+        : words(words), background(background) {}
+
+    size_t size() const { return words; }
+    size_t pages() const { return page_map.size(); }
+
+    uint32_t read(uint32_t index) const {
+        index %= words;
+        auto it = page_map.find(index / PAGE_WORDS);
+        return it == page_map.end() ? background : it->second[index % PAGE_WORDS];
+    }
+
+    // Write the bytes selected by `byte_mask` (bit n = bits 8n+7:8n)
+    void write(uint32_t index, uint32_t data, uint32_t byte_mask = 0xF) {
+        index %= words;
+        uint32_t& word = page(index / PAGE_WORDS)[index % PAGE_WORDS];
+        uint32_t mask = 0;
+        for (int b = 0; b < 4; b++)
+            if (byte_mask & (1u << b)) mask |= 0xFFu << (8 * b);
+        word = (word & ~mask) | (data & mask);
+    }
+
+    void write(uint32_t index, const uint32_t* data, size_t count) {
+        for (size_t i = 0; i < count; i++) write(index + i, data[i]);
+    }
+
+    // Reset words [begin, end) to the background value, dropping the pages they cover
+    void clear(size_t begin, size_t end) {
+        for (size_t i = begin; i < end;) {
+            size_t page_end = (i / PAGE_WORDS + 1) * PAGE_WORDS;
+            auto it = page_map.find(i / PAGE_WORDS);
+            if (it != page_map.end()) {
+                if (i % PAGE_WORDS == 0 && page_end <= end)
+                    page_map.erase(it);
+                else
+                    std::fill(it->second.get() + i % PAGE_WORDS,
+                              it->second.get() + (std::min(page_end, end) - 1) % PAGE_WORDS + 1, background);
+            }
+            i = page_end;
+        }
+    }
+
+    // Flat copies, e.g. to and from the ISS. copy_from skips background words on pages that
+    // were never written so an empty image allocates nothing.
+    void copy_to(uint32_t* dst, size_t count) const {
+        std::fill(dst, dst + count, background);
+        for (const auto& entry : page_map) {
+            size_t base = (size_t)entry.first * PAGE_WORDS;
+            if (base >= count) continue;
+            std::copy(entry.second.get(), entry.second.get() + std::min<size_t>(PAGE_WORDS, count - base), dst + base);
+        }
+    }
+
+    void copy_from(const uint32_t* src, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            if (src[i] != background || page_map.count(i / PAGE_WORDS)) write(i, src[i]);
+        }
+    }
+
+    // Checkpoint support, alongside the Verilated model state
+    void save(VerilatedSerialize& os) const {
+        uint64_t n = page_map.size();
+        os << n;
+        for (const auto& entry : page_map) {
+            uint32_t number = entry.first;
+            os << number;
+            os.write(entry.second.get(), PAGE_WORDS * sizeof(uint32_t));
+        }
+    }
+
+    void restore(VerilatedDeserialize& os) {
+        page_map.clear();
+        uint64_t n;
+        os >> n;
+        for (uint64_t i = 0; i < n; i++) {
+            uint32_t number;
+            os >> number;
+            os.read(page(number), PAGE_WORDS * sizeof(uint32_t));
+        }
+    }
+
+private:
+    size_t words;
+    uint32_t background;
+    std::unordered_map<uint32_t, std::unique_ptr<uint32_t[]>> page_map;
+
+    uint32_t* page(uint32_t number) {
+        auto& p = page_map[number];
+        if (!p) {
+            p.reset(new uint32_t[PAGE_WORDS]);
+            std::fill(p.get(), p.get() + PAGE_WORDS, background);
+        }
+        return p.get();
+    }
+};
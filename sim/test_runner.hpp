@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "instruction_tests.hpp"
+
+typedef std::function<void(InstructionTest&)> TestFunction;
+
+// Runs every test on a fresh InstructionTest (own VerilatedContext + Vsoc_multicycle)
+// spread over a small work-stealing pool. Each worker pops tests from the back of its
+// own queue and steals from the front of the other queues once it runs dry.
+// Results are stored per test slot, so they come out in the original order.
+class TestRunner {
+public:
+    std::vector<TestResult> results;
+
+    explicit TestRunner(unsigned num_workers = std::thread::hardware_concurrency())
+        : num_workers(num_workers ? num_workers : 1) {}
+
+    void run(const std::vector<TestFunction>& tests) {
+        const unsigned workers = std::max(1u, std::min<unsigned>(num_workers, tests.size()));
+        std::vector<WorkQueue> queues(workers);
+        std::vector<std::vector<TestResult>> slots(tests.size());
+
+        // Deal tests round-robin so every worker starts with a share of the list
+        for (size_t i = 0; i < tests.size(); i++) {
+            queues[i % workers].tasks.push_back(i);
+        }
+
+        std::vector<std::thread> threads;
+        for (unsigned id = 0; id < workers; id++) {
+            threads.emplace_back([&, id]() {
+                size_t index;
+                while (next_task(queues, id, index)) {
+                    InstructionTest tester;
+                    tests[index](tester);
+                    slots[index] = std::move(tester.results);
+                }
+            });
+        }
+        for (auto& t : threads) t.join();
+
+        for (auto& slot : slots) {
+            results.insert(results.end(), slot.begin(), slot.end());
+        }
+    }
+
+    void print_results() {
+        ::print_results(results);
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<size_t> tasks;
+    };
+
+    unsigned num_workers;
+
+    // No tasks are added once the pool starts, so finding every queue empty means we are done
+    static bool next_task(std::vector<WorkQueue>& queues, unsigned id, size_t& index) {
+        {
+            std::lock_guard<std::mutex> lock(queues[id].mutex);
+            if (!queues[id].tasks.empty()) {
+                index = queues[id].tasks.back();
+                queues[id].tasks.pop_back();
+                return true;
+            }
+        }
+
+        for (size_t n = 1; n < queues.size(); n++) {
+            WorkQueue& victim = queues[(id + n) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                index = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+};
@@ -0,0 +1,430 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Bundled benchmark workloads: self-checking programs, pre-assembled like the tests in
+// instruction_tests.hpp, for comparing the core's cycles and CPI across configurations
+// (soc_tb --workloads). Inputs are generated in RAM by an LCG (x = x * 1664525 + 1013904223,
+// seed 0x12345678), results are folded into an FNV-1a hash of the output words
+// (h = (h ^ w) * 0x01000193). Every program ends the same way: the result goes to the last
+// word of the default RAM (0xFFC, WORKLOAD_RESULT_WORD) and TOHOST gets 1 when it equals the
+// value assembled into the program, 3 otherwise.
+
+# define WORKLOAD_RESULT_WORD 1023
+
+struct Workload {
+    const char* name;
+    const char* description; // for the result line, after the name
+    const std::vector<uint32_t>& program;
+    uint32_t expected;  // result word
+    int max_cycles;
+};
+
+// memcpy: 256 words from 0x000 to 0x400, four words per iteration. Hash of the copy, plus
+// the OR of copy ^ source (0 when the copy is exact).
+const std::vector<uint32_t> MEMCPY_PROGRAM = {
+    0x123452b7,   // lui  x5, 0x12345
+    0x67828293,   // addi x5, x5, 1656   # x5 = 0x12345678
+    0x00196337,   // lui  x6, 0x196
+    0x60d30313,   // addi x6, x6, 1549   # x6 = 0x0019660d
+    0x3c6ef3b7,   // lui  x7, 0x3c6ef
+    0x35f38393,   // addi x7, x7, 863   # x7 = 0x3c6ef35f
+    0x00000413,   // addi x8, x0, 0
+    0x40000493,   // addi x9, x0, 1024
+    // fill:
+    0x026282b3,   // mul  x5, x5, x6
+    0x007282b3,   // add  x5, x5, x7
+    0x00542023,   // sw   x5, 0(x8)
+    0x00440413,   // addi x8, x8, 4
+    0xfe9418e3,   // bne  x8, x9, fill
+    0x00000413,   // addi x8, x0, 0
+    0x40000713,   // addi x14, x0, 1024
+    // copy:
+    0x00042783,   // lw   x15, 0(x8)
+    0x00442803,   // lw   x16, 4(x8)
+    0x00842883,   // lw   x17, 8(x8)
+    0x00c42903,   // lw   x18, 12(x8)
+    0x00f72023,   // sw   x15, 0(x14)
+    0x01072223,   // sw   x16, 4(x14)
+    0x01172423,   // sw   x17, 8(x14)
+    0x01272623,   // sw   x18, 12(x14)
+    0x01040413,   // addi x8, x8, 16
+    0x01070713,   // addi x14, x14, 16
+    0xfc941ce3,   // bne  x8, x9, copy
+    0x01000337,   // lui  x6, 0x1000
+    0x19330313,   // addi x6, x6, 403   # x6 = 0x01000193
+    0x811ca537,   // lui  x10, 0x811ca
+    0xdc550513,   // addi x10, x10, -571   # x10 = 0x811c9dc5
+    0x40000713,   // addi x14, x0, 1024
+    0x7ff00493,   // addi x9, x0, 2047
+    0x00148493,   // addi x9, x9, 1
+    // sum:
+    0xc0072783,   // lw   x15, -1024(x14)
+    0x00072803,   // lw   x16, 0(x14)
+    0x01054533,   // xor  x10, x10, x16
+    0x02650533,   // mul  x10, x10, x6
+    0x00f84833,   // xor  x16, x16, x15
+    0x0109e9b3,   // or   x19, x19, x16
+    0x00470713,   // addi x14, x14, 4
+    0xfe9712e3,   // bne  x14, x9, sum
+    0x01350533,   // add  x10, x10, x19
+    0xaf9885b7,   // lui  x11, 0xaf988
+    0x9c558593,   // addi x11, x11, -1595   # x11 = 0xaf9879c5
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+// memset: 0xA5 into the 1019 bytes at 0x103: one byte to reach alignment, words, then two
+// bytes. Hash of the words from 0x100 to 0x503, so bytes next to the range must stay 0.
+const std::vector<uint32_t> MEMSET_PROGRAM = {
+    0x10300413,   // addi x8, x0, 0x103
+    0x4fe00493,   // addi x9, x0, 0x4fe
+    0x0a500293,   // addi x5, x0, 0xa5
+    0x00829313,   // slli x6, x5, 8
+    0x0062e2b3,   // or   x5, x5, x6
+    0x01029313,   // slli x6, x5, 16
+    0x0062e2b3,   // or   x5, x5, x6
+    // head:
+    0x00347313,   // andi x6, x8, 3
+    0x00030863,   // beq  x6, x0, words
+    0x00540023,   // sb   x5, 0(x8)
+    0x00140413,   // addi x8, x8, 1
+    0xff1ff06f,   // j    head
+    // words:
+    0xffc4f393,   // andi x7, x9, -4
+    // wloop:
+    0x00747863,   // bgeu x8, x7, tail
+    0x00542023,   // sw   x5, 0(x8)
+    0x00440413,   // addi x8, x8, 4
+    0xff5ff06f,   // j    wloop
+    // tail:
+    0x00940863,   // beq  x8, x9, check
+    0x00540023,   // sb   x5, 0(x8)
+    0x00140413,   // addi x8, x8, 1
+    0xff5ff06f,   // j    tail
+    // check:
+    0x01000337,   // lui  x6, 0x1000
+    0x19330313,   // addi x6, x6, 403   # x6 = 0x01000193
+    0x811ca537,   // lui  x10, 0x811ca
+    0xdc550513,   // addi x10, x10, -571   # x10 = 0x811c9dc5
+    0x10000713,   // addi x14, x0, 0x100
+    0x50400493,   // addi x9, x0, 0x504
+    // sum:
+    0x00072783,   // lw   x15, 0(x14)
+    0x00f54533,   // xor  x10, x10, x15
+    0x02650533,   // mul  x10, x10, x6
+    0x00470713,   // addi x14, x14, 4
+    0xfe9718e3,   // bne  x14, x9, sum
+    0x5485f5b7,   // lui  x11, 0x5485f
+    0x42058593,   // addi x11, x11, 1056   # x11 = 0x5485f420
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+// CRC-32 (reflected, polynomial 0xEDB88320, as zlib) of 256 bytes, one bit per iteration
+const std::vector<uint32_t> CRC32_PROGRAM = {
+    0x123452b7,   // lui  x5, 0x12345
+    0x67828293,   // addi x5, x5, 1656   # x5 = 0x12345678
+    0x00196337,   // lui  x6, 0x196
+    0x60d30313,   // addi x6, x6, 1549   # x6 = 0x0019660d
+    0x3c6ef3b7,   // lui  x7, 0x3c6ef
+    0x35f38393,   // addi x7, x7, 863   # x7 = 0x3c6ef35f
+    0x00000413,   // addi x8, x0, 0
+    0x10000493,   // addi x9, x0, 256
+    // fill:
+    0x026282b3,   // mul  x5, x5, x6
+    0x007282b3,   // add  x5, x5, x7
+    0x00542023,   // sw   x5, 0(x8)
+    0x00440413,   // addi x8, x8, 4
+    0xfe9418e3,   // bne  x8, x9, fill
+    0xfff00513,   // addi x10, x0, -1
+    0xedb88337,   // lui  x6, 0xedb88
+    0x32030313,   // addi x6, x6, 800   # x6 = 0xedb88320
+    0x00000413,   // addi x8, x0, 0
+    // byte:
+    0x00044783,   // lbu  x15, 0(x8)
+    0x00f54533,   // xor  x10, x10, x15
+    0x00800813,   // addi x16, x0, 8
+    // bit:
+    0x00157893,   // andi x17, x10, 1
+    0x00155513,   // srli x10, x10, 1
+    0x00088463,   // beq  x17, x0, next
+    0x00654533,   // xor  x10, x10, x6
+    // next:
+    0xfff80813,   // addi x16, x16, -1
+    0xfe0816e3,   // bne  x16, x0, bit
+    0x00140413,   // addi x8, x8, 1
+    0xfc941ce3,   // bne  x8, x9, byte
+    0xfff54513,   // xori x10, x10, -1
+    0xb79775b7,   // lui  x11, 0xb7977
+    0x4b658593,   // addi x11, x11, 1206   # x11 = 0xb79774b6
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+// Insertion sort of 128 signed words. Hash of the sorted array, plus the count of adjacent
+// pairs out of order (0 when sorted).
+const std::vector<uint32_t> SORT_PROGRAM = {
+    0x123452b7,   // lui  x5, 0x12345
+    0x67828293,   // addi x5, x5, 1656   # x5 = 0x12345678
+    0x00196337,   // lui  x6, 0x196
+    0x60d30313,   // addi x6, x6, 1549   # x6 = 0x0019660d
+    0x3c6ef3b7,   // lui  x7, 0x3c6ef
+    0x35f38393,   // addi x7, x7, 863   # x7 = 0x3c6ef35f
+    0x00000413,   // addi x8, x0, 0
+    0x20000493,   // addi x9, x0, 512
+    // fill:
+    0x026282b3,   // mul  x5, x5, x6
+    0x007282b3,   // add  x5, x5, x7
+    0x00542023,   // sw   x5, 0(x8)
+    0x00440413,   // addi x8, x8, 4
+    0xfe9418e3,   // bne  x8, x9, fill
+    0x00400413,   // addi x8, x0, 4
+    // outer:
+    0x00042783,   // lw   x15, 0(x8)
+    0xffc40713,   // addi x14, x8, -4
+    // inner:
+    0x00074c63,   // blt  x14, x0, place
+    0x00072803,   // lw   x16, 0(x14)
+    0x0107d863,   // bge  x15, x16, place
+    0x01072223,   // sw   x16, 4(x14)
+    0xffc70713,   // addi x14, x14, -4
+    0xfedff06f,   // j    inner
+    // place:
+    0x00f72223,   // sw   x15, 4(x14)
+    0x00440413,   // addi x8, x8, 4
+    0xfc941ce3,   // bne  x8, x9, outer
+    0x01000337,   // lui  x6, 0x1000
+    0x19330313,   // addi x6, x6, 403   # x6 = 0x01000193
+    0x811ca537,   // lui  x10, 0x811ca
+    0xdc550513,   // addi x10, x10, -571   # x10 = 0x811c9dc5
+    0x00000713,   // addi x14, x0, 0
+    0x1fc00493,   // addi x9, x0, 508
+    0x00002783,   // lw   x15, 0(x0)
+    // sum:
+    0x00472803,   // lw   x16, 4(x14)
+    0x00f54533,   // xor  x10, x10, x15
+    0x02650533,   // mul  x10, x10, x6
+    0x00f828b3,   // slt  x17, x16, x15
+    0x0119e9b3,   // or   x19, x19, x17
+    0x00080793,   // mv   x15, x16
+    0x00470713,   // addi x14, x14, 4
+    0xfe9712e3,   // bne  x14, x9, sum
+    0x00f54533,   // xor  x10, x10, x15
+    0x02650533,   // mul  x10, x10, x6
+    0x01350533,   // add  x10, x10, x19
+    0x453275b7,   // lui  x11, 0x45327
+    0x09b58593,   // addi x11, x11, 155   # x11 = 0x4532709b
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+// 8x8 matrix multiply C = A * B with elements in [-128, 127]: A at 0x000, B at 0x100,
+// C at 0x200, row-major. Hash of C.
+const std::vector<uint32_t> MATMUL_PROGRAM = {
+    0x123452b7,   // lui  x5, 0x12345
+    0x67828293,   // addi x5, x5, 1656   # x5 = 0x12345678
+    0x00196337,   // lui  x6, 0x196
+    0x60d30313,   // addi x6, x6, 1549   # x6 = 0x0019660d
+    0x3c6ef3b7,   // lui  x7, 0x3c6ef
+    0x35f38393,   // addi x7, x7, 863   # x7 = 0x3c6ef35f
+    0x00000413,   // addi x8, x0, 0
+    0x20000493,   // addi x9, x0, 512
+    // fill:
+    0x026282b3,   // mul  x5, x5, x6
+    0x007282b3,   // add  x5, x5, x7
+    0x4182d793,   // srai x15, x5, 24
+    0x00f42023,   // sw   x15, 0(x8)
+    0x00440413,   // addi x8, x8, 4
+    0xfe9416e3,   // bne  x8, x9, fill
+    0x02000d93,   // addi x27, x0, 32
+    0x10000e13,   // addi x28, x0, 256
+    0x00000a13,   // addi x20, x0, 0
+    0x20000a93,   // addi x21, x0, 0x200
+    // iloop:
+    0x00000b13,   // addi x22, x0, 0
+    // jloop:
+    0x00000b93,   // addi x23, x0, 0
+    0x000a0c13,   // mv   x24, x20
+    0x100b0c93,   // addi x25, x22, 0x100
+    0x00800d13,   // addi x26, x0, 8
+    // kloop:
+    0x000c2783,   // lw   x15, 0(x24)
+    0x000ca803,   // lw   x16, 0(x25)
+    0x030788b3,   // mul  x17, x15, x16
+    0x011b8bb3,   // add  x23, x23, x17
+    0x004c0c13,   // addi x24, x24, 4
+    0x020c8c93,   // addi x25, x25, 32
+    0xfffd0d13,   // addi x26, x26, -1
+    0xfe0d12e3,   // bne  x26, x0, kloop
+    0x017aa023,   // sw   x23, 0(x21)
+    0x004a8a93,   // addi x21, x21, 4
+    0x004b0b13,   // addi x22, x22, 4
+    0xfdbb12e3,   // bne  x22, x27, jloop
+    0x020a0a13,   // addi x20, x20, 32
+    0xfbca1ce3,   // bne  x20, x28, iloop
+    0x01000337,   // lui  x6, 0x1000
+    0x19330313,   // addi x6, x6, 403   # x6 = 0x01000193
+    0x811ca537,   // lui  x10, 0x811ca
+    0xdc550513,   // addi x10, x10, -571   # x10 = 0x811c9dc5
+    0x20000713,   // addi x14, x0, 0x200
+    0x30000493,   // addi x9, x0, 0x300
+    // sum:
+    0x00072783,   // lw   x15, 0(x14)
+    0x00f54533,   // xor  x10, x10, x15
+    0x02650533,   // mul  x10, x10, x6
+    0x00470713,   // addi x14, x14, 4
+    0xfe9718e3,   // bne  x14, x9, sum
+    0xe62705b7,   // lui  x11, 0xe6270
+    0x4d058593,   // addi x11, x11, 1232   # x11 = 0xe62704d0
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+// Naive search for "aba" in 1024 bytes of text over 'a'-'d' (pattern at 0x400).
+// Result: match count << 16 ^ sum of the match positions.
+const std::vector<uint32_t> STRSEARCH_PROGRAM = {
+    0x123452b7,   // lui  x5, 0x12345
+    0x67828293,   // addi x5, x5, 1656   # x5 = 0x12345678
+    0x00196337,   // lui  x6, 0x196
+    0x60d30313,   // addi x6, x6, 1549   # x6 = 0x0019660d
+    0x3c6ef3b7,   // lui  x7, 0x3c6ef
+    0x35f38393,   // addi x7, x7, 863   # x7 = 0x3c6ef35f
+    0x03030a37,   // lui  x20, 0x3030
+    0x303a0a13,   // addi x20, x20, 771   # x20 = 0x03030303
+    0x61616ab7,   // lui  x21, 0x61616
+    0x161a8a93,   // addi x21, x21, 353   # x21 = 0x61616161
+    0x00000413,   // addi x8, x0, 0
+    0x40000493,   // addi x9, x0, 1024
+    // fill:
+    0x026282b3,   // mul  x5, x5, x6
+    0x007282b3,   // add  x5, x5, x7
+    0x0142f7b3,   // and  x15, x5, x20
+    0x015787b3,   // add  x15, x15, x21
+    0x00f42023,   // sw   x15, 0(x8)
+    0x00440413,   // addi x8, x8, 4
+    0xfe9414e3,   // bne  x8, x9, fill
+    0x006167b7,   // lui  x15, 0x616
+    0x26178793,   // addi x15, x15, 609   # x15 = 0x00616261
+    0x00f4a023,   // sw   x15, 0(x9)
+    0x00000413,   // addi x8, x0, 0
+    0x3fe00493,   // addi x9, x0, 1022
+    0x00300913,   // addi x18, x0, 3
+    0x00000513,   // addi x10, x0, 0
+    0x00000993,   // addi x19, x0, 0
+    // search:
+    0x00000713,   // addi x14, x0, 0
+    // compare:
+    0x00e407b3,   // add  x15, x8, x14
+    0x0007c803,   // lbu  x16, 0(x15)
+    0x40074883,   // lbu  x17, 1024(x14)
+    0x01181a63,   // bne  x16, x17, next
+    0x00170713,   // addi x14, x14, 1
+    0xff2716e3,   // bne  x14, x18, compare
+    0x00150513,   // addi x10, x10, 1
+    0x008989b3,   // add  x19, x19, x8
+    // next:
+    0x00140413,   // addi x8, x8, 1
+    0xfc941ce3,   // bne  x8, x9, search
+    0x01051513,   // slli x10, x10, 16
+    0x01354533,   // xor  x10, x10, x19
+    0x000f25b7,   // lui  x11, 0xf2
+    0xe0e58593,   // addi x11, x11, -498   # x11 = 0x000f1e0e
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+// UART echo: 32 bytes sent one at a time, each read back once it has come around the
+// harness loopback (default baud setting). Hash of the received bytes.
+const std::vector<uint32_t> UART_ECHO_PROGRAM = {
+    0x123452b7,   // lui  x5, 0x12345
+    0x67828293,   // addi x5, x5, 1656   # x5 = 0x12345678
+    0x00196ab7,   // lui  x21, 0x196
+    0x60da8a93,   // addi x21, x21, 1549   # x21 = 0x0019660d
+    0x3c6efb37,   // lui  x22, 0x3c6ef
+    0x35fb0b13,   // addi x22, x22, 863   # x22 = 0x3c6ef35f
+    0x01000337,   // lui  x6, 0x1000
+    0x19330313,   // addi x6, x6, 403   # x6 = 0x01000193
+    0x811ca537,   // lui  x10, 0x811ca
+    0xdc550513,   // addi x10, x10, -571   # x10 = 0x811c9dc5
+    0x10000a37,   // lui  x20, 0x10000
+    0x00000413,   // addi x8, x0, 0
+    0x02000493,   // addi x9, x0, 32
+    // send:
+    0x035282b3,   // mul  x5, x5, x21
+    0x016282b3,   // add  x5, x5, x22
+    0x0182d793,   // srli x15, x5, 24
+    0x00fa0023,   // sb   x15, 0(x20)
+    // wait:
+    0x008a2803,   // lw   x16, 8(x20)
+    0x00287813,   // andi x16, x16, 2
+    0xfe080ce3,   // beq  x16, x0, wait
+    0x004a4883,   // lbu  x17, 4(x20)
+    0x01154533,   // xor  x10, x10, x17
+    0x02650533,   // mul  x10, x10, x6
+    0x00140413,   // addi x8, x8, 1
+    0xfc941ae3,   // bne  x8, x9, send
+    0x4c71f5b7,   // lui  x11, 0x4c71f
+    0x88e58593,   // addi x11, x11, -1906   # x11 = 0x4c71e88e
+    // finish:
+    0x00001637,   // lui  x12, 1
+    0xfea62e23,   // sw   x10, -4(x12)
+    0x10001637,   // lui  x12, 0x10001
+    0x00100693,   // addi x13, x0, 1
+    0x00b50463,   // beq  x10, x11, pass
+    0x00300693,   // addi x13, x0, 3
+    // pass:
+    0x00d62023,   // sw   x13, 0(x12)
+};
+
+const std::vector<Workload> WORKLOADS = {
+    {"memcpy", "1KB, four words per iteration", MEMCPY_PROGRAM, 0xaf9879c5, 200000},
+    {"memset", "1019 unaligned bytes", MEMSET_PROGRAM, 0x5485f420, 100000},
+    {"crc32", "256 bytes, bit by bit", CRC32_PROGRAM, 0xb79774b6, 500000},
+    {"sort", "insertion sort of 128 words", SORT_PROGRAM, 0x4532709b, 1000000},
+    {"matmul", "8x8 integer matrix multiply", MATMUL_PROGRAM, 0xe62704d0, 250000},
+    {"strsearch", "naive search in 1KB of text", STRSEARCH_PROGRAM, 0x000f1e0e, 500000},
+    {"uart_echo", "32 bytes through the loopback", UART_ECHO_PROGRAM, 0x4c71e88e, 100000},
+};
@@ -1,6 +1,18 @@
 `include "defines.vh"
 
-module bus_controller (
+// Pipelined bus controller. Requests are decoded combinationally and go out to the
+// peripheral in the cycle the CPU makes them, a new transaction can start in the cycle the
+// previous one completes. Stores are posted into a store buffer (ready in the request
+// cycle) and drain in order; loads bypass buffered stores to other words, take their data
+// from the youngest buffered store that covers them, and wait for the buffer to drain when a
+// buffered store only partly overlaps. UART/TOHOST/DMA/CLINT loads wait until all stores
+// have drained.
+// The DMA engine is a second master: a round-robin arbiter shares the peripheral port between
+// it and the CPU side (loads and store buffer) whenever both want to start a transaction.
+module bus_controller #(
+    parameter STORE_BUFFER_DEPTH = 4, // power of two
+    parameter RAM_SIZE = 4096         // bytes of RAM from RAM_BASE
+) (
     input wire clk,
     input wire rst,
 
@@ -16,90 +28,340 @@ module bus_controller (
     // Memory Interface
     output reg [31:0] mem_address,
     output reg [31:0] mem_write_data,
-    input wire [31:0] mem_read_data [1:0], // 0: dmem data, 1: uart data
+    input wire [31:0] mem_read_data [3:0], // 0: dmem data, 1: uart data, 2: dma data, 3: clint data
     output reg mem_we,
     output reg [2:0] mem_mode,
-    output reg [1:0] mem_req, // 01: dmem, 10: uart
-    input wire [1:0] mem_ready // 01: dmem ready, 10: uart ready
-);
+    output reg [3:0] mem_req, // 0001: dmem, 0010: uart, 0100: dma, 1000: clint
+    input wire [3:0] mem_ready, // 0001: dmem ready, 0010: uart ready, 0100: dma ready, 1000: clint ready
 
-    localparam IDLE = 1'b0, WAIT = 1'b1;
-    localparam RAM_REQ = 2'b01, UART_REQ = 2'b10;
+    // DMA master: a request is taken in the cycle dma_grant is high, load data comes back
+    // in order with dma_rvalid (RAM and UART only)
+    input wire [31:0] dma_address,
+    input wire [31:0] dma_write_data,
+    input wire dma_we,
+    input wire [2:0] dma_mode,
+    input wire dma_req,
+    output wire dma_grant,
+    output wire [31:0] dma_read_data,
+    output wire dma_rvalid,
 
-    reg state;
-    reg [31:0] decoded_address;
-    reg [1:0] current_peripheral_select;
+    // TOHOST register (written by firmware to end the simulation)
+    output reg [31:0] tohost_data,
+    output reg tohost_valid,
+    // TRACE_CTRL bit 0 (firmware-controlled waveform window)
+    output reg trace_on,
 
-    always @(*) begin
-        if (cpu_address <= `RAM_TOP) begin
+    // High while a transaction is in flight (including buffered stores)
+    output wire busy,
+
+    // High while waiting for the selected peripheral to respond (performance counter event)
+    output wire stall
+);
+
+    localparam RAM_REQ = 4'b0001, UART_REQ = 4'b0010, DMA_REQ = 4'b0100, CLINT_REQ = 4'b1000,
+               TOHOST_REQ = 4'b0000;
+    localparam PTR_BITS = $clog2(STORE_BUFFER_DEPTH);
+    localparam [PTR_BITS:0] SB_FULL = STORE_BUFFER_DEPTH;
+
+    // Address decode: {peripheral select, address relative to the peripheral}
+    function [35:0] decode(input [31:0] address);
+        if (address < `RAM_BASE + RAM_SIZE) begin
             // DMEM address range
-            decoded_address = cpu_address - `RAM_BASE;
-            current_peripheral_select = RAM_REQ;
-        end else if (cpu_address >= `UART_BASE && cpu_address <= `UART_TOP) begin
+            decode = {RAM_REQ, address - `RAM_BASE};
+        end else if (address >= `UART_BASE && address <= `UART_TOP) begin
             // UART address range
-            decoded_address = cpu_address - `UART_BASE;
-            current_peripheral_select = UART_REQ;
+            decode = {UART_REQ, address - `UART_BASE};
+        end else if (address >= `DMA_BASE && address <= `DMA_TOP) begin
+            // DMA register range
+            decode = {DMA_REQ, address - `DMA_BASE};
+        end else if (address >= `CLINT_BASE && address <= `CLINT_TOP) begin
+            // Timer range
+            decode = {CLINT_REQ, address - `CLINT_BASE};
+        end else if (address >= `TOHOST_BASE && address <= `TOHOST_TOP) begin
+            // TOHOST address range, no memory request is issued
+            decode = {TOHOST_REQ, address - `TOHOST_BASE};
         end else begin
             // Default to DMEM for unmapped addresses
-            decoded_address = 32'b0;
-            current_peripheral_select = RAM_REQ;
+            decode = {RAM_REQ, 32'b0};
+        end
+    endfunction
+
+    reg [31:0] decoded_address;
+    reg [3:0] current_peripheral_select; // 0000: TOHOST (handled inside the bus controller)
+    reg [31:0] dma_decoded_address;
+    reg [3:0] dma_select;
+
+    always @(*) begin
+        {current_peripheral_select, decoded_address} = decode(cpu_address);
+        {dma_select, dma_decoded_address} = decode(dma_address);
+    end
+
+    // Load data for the DM_* mode from the word holding it
+    function [31:0] load_extract(input [31:0] word, input [1:0] offset, input [2:0] mode);
+        case (mode)
+            `DM_LB:  load_extract = {{24{word[{offset, 3'b111}]}}, word[{offset, 3'b000} +: 8]};
+            `DM_LBU: load_extract = {24'b0, word[{offset, 3'b000} +: 8]};
+            `DM_LH:  load_extract = {{16{word[{offset[1], 4'b1111}]}}, word[{offset[1], 4'b0000} +: 16]};
+            `DM_LHU: load_extract = {16'b0, word[{offset[1], 4'b0000} +: 16]};
+            default: load_extract = word;
+        endcase
+    endfunction
+
+    //--------------------------------------------------------------------------
+    // Store buffer (FIFO, decoded addresses)
+    reg [31:0] sb_address [0:STORE_BUFFER_DEPTH-1];
+    reg [31:0] sb_data    [0:STORE_BUFFER_DEPTH-1];
+    reg [2:0]  sb_mode    [0:STORE_BUFFER_DEPTH-1];
+    reg [3:0]  sb_select  [0:STORE_BUFFER_DEPTH-1];
+    reg [PTR_BITS-1:0] sb_head;
+    reg [PTR_BITS-1:0] sb_tail;
+    reg [PTR_BITS:0]   sb_count;
+
+    wire w_sb_empty = (sb_count == '0);
+    wire w_sb_full  = (sb_count == SB_FULL);
+
+    // Youngest buffered store to the word of the CPU request
+    reg w_fwd_match;
+    reg w_fwd_cover;
+    reg [31:0] w_fwd_word;
+    reg [PTR_BITS-1:0] w_fwd_index;
+    always @(*) begin
+        integer i;
+        w_fwd_match = 1'b0;
+        w_fwd_cover = 1'b0;
+        w_fwd_word  = 32'b0;
+        for (i = 0; i < STORE_BUFFER_DEPTH; i = i + 1) begin
+            w_fwd_index = sb_head + i[PTR_BITS-1:0];
+            if (i < sb_count && sb_select[w_fwd_index] == RAM_REQ &&
+                sb_address[w_fwd_index][31:2] == decoded_address[31:2]) begin
+                w_fwd_match = 1'b1;
+                case (sb_mode[w_fwd_index])
+                    `DM_SB: begin
+                        w_fwd_cover = (cpu_mode == `DM_LB || cpu_mode == `DM_LBU) &&
+                                      sb_address[w_fwd_index][1:0] == decoded_address[1:0];
+                        w_fwd_word  = {4{sb_data[w_fwd_index][7:0]}};
+                    end
+                    `DM_SH: begin
+                        w_fwd_cover = (cpu_mode != `DM_LW) &&
+                                      sb_address[w_fwd_index][1] == decoded_address[1];
+                        w_fwd_word  = {2{sb_data[w_fwd_index][15:0]}};
+                    end
+                    default: begin
+                        w_fwd_cover = 1'b1;
+                        w_fwd_word  = sb_data[w_fwd_index];
+                    end
+                endcase
+            end
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // Peripheral port: one transaction at a time, held until the peripheral is ready
+    reg port_busy;
+    reg port_load;
+    reg [31:0] port_address;
+    reg [31:0] port_write_data;
+    reg port_we;
+    reg [2:0] port_mode;
+    reg [3:0] port_select;
+    reg port_dma; // transaction belongs to the DMA master
+
+    wire w_port_done = port_busy && |(port_select & mem_ready);
+    wire w_port_free = !port_busy || w_port_done;
+
+    // Load waiting for the port or for the store buffer to drain (the CPU may drop its request)
+    reg ld_pending;
+    reg ld_wait_drain;
+    reg [31:0] ld_address;
+    reg [2:0] ld_mode;
+    reg [3:0] ld_select;
+
+    // Load answered without the port (store forwarding or TOHOST)
+    reg local_ready;
+    reg [31:0] local_data;
+
+    wire w_load_busy = ld_pending || (port_busy && port_load && !port_dma) || local_ready;
+
+    wire w_new_load  = cpu_req && !cpu_we && !w_load_busy;
+    wire w_new_store = cpu_req && cpu_we && !w_sb_full;
+
+    // A new RAM load forwarded from the buffer, or one that must wait for it to drain
+    wire w_new_fwd  = w_new_load && current_peripheral_select == RAM_REQ && w_fwd_match && w_fwd_cover;
+    wire w_new_wait = w_new_load && (current_peripheral_select == RAM_REQ ? (w_fwd_match && !w_fwd_cover) : 1'b1);
+
+    // Loads go to the port ahead of buffered stores
+    wire w_new_issue = w_new_load && !w_new_fwd && !(w_new_wait && !w_sb_empty) &&
+                       !ld_pending && current_peripheral_select != TOHOST_REQ;
+    wire w_ld_issue  = ld_pending && !(ld_wait_drain && !w_sb_empty) && ld_select != TOHOST_REQ;
+    wire w_ld_local  = ld_pending && w_sb_empty && ld_select == TOHOST_REQ;
+    wire w_new_local = w_new_load && w_sb_empty && current_peripheral_select == TOHOST_REQ;
+
+    wire w_sb_tohost = !w_sb_empty && sb_select[sb_head] == TOHOST_REQ;
+    wire w_sb_issue  = !w_sb_empty && !w_sb_tohost && !w_new_issue && !w_ld_issue;
+
+    // Round-robin arbiter: when both masters want the port, the one not served last wins
+    reg last_dma;
+    wire w_cpu_want = w_new_issue || w_ld_issue || w_sb_issue;
+    wire w_dma_start = w_port_free && dma_req && !(w_cpu_want && last_dma);
+
+    // Port start this cycle: DMA, load from the CPU, pending load or the oldest buffered store
+    wire w_cpu_start = w_port_free && w_cpu_want && !w_dma_start;
+    wire w_start = w_cpu_start || w_dma_start;
+
+    always @(*) begin
+        if (port_busy && !w_port_done) begin
+            mem_address    = port_address;
+            mem_write_data = port_write_data;
+            mem_we         = port_we;
+            mem_mode       = port_mode;
+            mem_req        = port_select;
+        end else if (w_dma_start) begin
+            mem_address    = dma_decoded_address;
+            mem_write_data = dma_write_data;
+            mem_we         = dma_we;
+            mem_mode       = dma_mode;
+            mem_req        = dma_select;
+        end else if (w_cpu_start && w_new_issue) begin
+            mem_address    = decoded_address;
+            mem_write_data = 32'b0;
+            mem_we         = 1'b0;
+            mem_mode       = cpu_mode;
+            mem_req        = current_peripheral_select;
+        end else if (w_cpu_start && w_ld_issue) begin
+            mem_address    = ld_address;
+            mem_write_data = 32'b0;
+            mem_we         = 1'b0;
+            mem_mode       = ld_mode;
+            mem_req        = ld_select;
+        end else if (w_cpu_start && w_sb_issue) begin
+            mem_address    = sb_address[sb_head];
+            mem_write_data = sb_data[sb_head];
+            mem_we         = 1'b1;
+            mem_mode       = sb_mode[sb_head];
+            mem_req        = sb_select[sb_head];
+        end else begin
+            mem_address    = port_address;
+            mem_write_data = port_write_data;
+            mem_we         = 1'b0;
+            mem_mode       = port_mode;
+            mem_req        = 4'b0000;
         end
     end
 
+    wire [31:0] w_port_data = port_select[3] ? mem_read_data[3] :
+                              port_select[2] ? mem_read_data[2] :
+                              port_select[1] ? mem_read_data[1] : mem_read_data[0];
+
+    // Stores are acknowledged as soon as they enter the buffer, loads when their data is back
+    always @(*) begin
+        cpu_ready     = w_new_store || local_ready || (w_port_done && port_load && !port_dma);
+        cpu_read_data = local_ready ? local_data : w_port_data;
+    end
+
+    assign dma_grant     = w_dma_start;
+    assign dma_read_data = w_port_data;
+    assign dma_rvalid    = w_port_done && port_load && port_dma;
+
     always @(posedge clk) begin
         if (rst) begin
-            state <= IDLE;
+            sb_head  <= '0;
+            sb_tail  <= '0;
+            sb_count <= '0;
+
+            port_busy       <= 1'b0;
+            port_load       <= 1'b0;
+            port_address    <= 32'b0;
+            port_write_data <= 32'b0;
+            port_we         <= 1'b0;
+            port_mode       <= 3'b0;
+            port_select     <= 4'b0000;
+            port_dma        <= 1'b0;
+            last_dma        <= 1'b0;
 
-            cpu_read_data <= 32'b0;
-            cpu_ready <= 1'b0;
+            ld_pending    <= 1'b0;
+            ld_wait_drain <= 1'b0;
+            ld_address    <= 32'b0;
+            ld_mode       <= 3'b0;
+            ld_select     <= 4'b0000;
 
-            mem_address <= 32'b0;
-            mem_write_data <= 32'b0;
-            mem_we <= 1'b0;
-            mem_mode <= 3'b0;
-            mem_req <= 2'b00;
+            local_ready <= 1'b0;
+            local_data  <= 32'b0;
+
+            tohost_data <= 32'b0;
+            tohost_valid <= 1'b0;
+            trace_on <= 1'b0;
         end else begin
-            case (state)
-                IDLE: begin
-                    cpu_ready <= 1'b0;
-
-                    if (cpu_req) begin
-                        state <= WAIT;
-
-                        // Forward CPU request to memory
-                        mem_address <= decoded_address;
-                        mem_write_data <= cpu_write_data;
-                        mem_we <= cpu_we;
-                        mem_mode <= cpu_mode;
-                        mem_req <= current_peripheral_select;
-
-                        if (cpu_we) begin
-                            // For writes, immediately set ready to allow next instruction
-                            cpu_ready <= 1'b1;
-                        end
-                    end
-                end
-                WAIT: begin
-                    cpu_ready <= 1'b0;
-
-                    if ((mem_req[0] && mem_ready[0]) || (mem_req[1] && mem_ready[1])) begin
-                        state <= IDLE;
-                        // Capture memory response
-                        cpu_read_data <= mem_req[0] ? mem_read_data[0] : 
-                                         (mem_req[1] ? mem_read_data[1] : 32'b0);
-                        
-                        if (!mem_we) begin
-                            // For reads, set ready after data is captured
-                            cpu_ready <= 1'b1;
-                        end
-                        
-                        mem_req <= 2'b0;
-                        mem_we <= 1'b0;
-                    end
+            local_ready <= 1'b0;
+
+            // Port
+            if (w_start) begin
+                port_busy       <= 1'b1;
+                port_address    <= mem_address;
+                port_write_data <= mem_write_data;
+                port_we         <= mem_we;
+                port_mode       <= mem_mode;
+                port_select     <= mem_req;
+                port_load       <= !mem_we;
+                port_dma        <= w_dma_start;
+                last_dma        <= w_dma_start;
+            end else if (w_port_done) begin
+                port_busy <= 1'b0;
+                port_load <= 1'b0;
+                port_dma  <= 1'b0;
+            end
+
+            // Loads
+            if (w_new_fwd) begin
+                local_ready <= 1'b1;
+                local_data  <= load_extract(w_fwd_word, decoded_address[1:0], cpu_mode);
+            end else if (w_new_local) begin
+                local_ready <= 1'b1;
+                local_data  <= tohost_data;
+            end else if (w_new_load && !(w_new_issue && w_cpu_start)) begin
+                ld_pending    <= 1'b1;
+                ld_wait_drain <= w_new_wait;
+                ld_address    <= decoded_address;
+                ld_mode       <= cpu_mode;
+                ld_select     <= current_peripheral_select;
+            end
+
+            if (w_ld_local) begin
+                ld_pending  <= 1'b0;
+                local_ready <= 1'b1;
+                local_data  <= tohost_data;
+            end else if (w_ld_issue && w_cpu_start) begin
+                ld_pending <= 1'b0;
+            end
+
+            // Store buffer: push posted stores, pop into the port or the TOHOST register
+            if (w_new_store) begin
+                sb_address[sb_tail] <= decoded_address;
+                sb_data[sb_tail]    <= cpu_write_data;
+                sb_mode[sb_tail]    <= cpu_mode;
+                sb_select[sb_tail]  <= current_peripheral_select;
+                sb_tail <= sb_tail + 1;
+            end
+
+            if (w_sb_tohost) begin
+                if (sb_address[sb_head][7:0] == `TRACE_CTRL_OFFSET) begin
+                    trace_on <= sb_data[sb_head][0];
+                end else begin
+                    tohost_data  <= sb_data[sb_head];
+                    tohost_valid <= 1'b1;
                 end
-                default: state <= IDLE;
-            endcase
+            end
+
+            if (w_sb_tohost || (w_sb_issue && w_cpu_start)) begin
+                sb_head <= sb_head + 1;
+                if (!w_new_store)
+                    sb_count <= sb_count - 1;
+            end else if (w_new_store) begin
+                sb_count <= sb_count + 1;
+            end
         end
     end
 
-endmodule
\ No newline at end of file
+    assign busy = port_busy || ld_pending || local_ready || !w_sb_empty;
+    assign stall = port_busy && !w_port_done;
+
+endmodule
@@ -0,0 +1,66 @@
+`include "defines.vh"
+
+// Core-local timer (CLINT layout, one hart, no software interrupt). mtime counts clock
+// cycles; the timer interrupt is pending while mtime >= mtimecmp. Both are 64 bits wide and
+// accessed as two words, mtimecmp resets to all ones so nothing fires before it is set.
+module clint (
+    input wire clk,
+    input wire rst,
+
+    // Register interface (decoded address)
+    input wire [31:0] address,
+    input wire [31:0] write_data,
+    output reg [31:0] read_data,
+    input wire we,
+    input wire [2:0] mode,
+    input wire req,
+    output reg ready,
+
+    output wire irq // MTIP
+);
+    localparam MTIMECMP_REG_ADDR = 32'h0000_4000;
+    localparam MTIMECMPH_REG_ADDR = 32'h0000_4004;
+    localparam MTIME_REG_ADDR = 32'h0000_BFF8;
+    localparam MTIMEH_REG_ADDR = 32'h0000_BFFC;
+
+    reg [63:0] mtime;
+    reg [63:0] mtimecmp;
+
+    assign irq = (mtime >= mtimecmp);
+
+    always @(posedge clk) begin
+        if (rst) begin
+            ready <= 1'b0;
+            read_data <= 32'b0;
+            mtime <= 64'b0;
+            mtimecmp <= {64{1'b1}};
+        end else begin
+            ready <= 1'b0;
+            mtime <= mtime + 64'd1;
+
+            // Register interface, word accesses only
+            if (req) begin
+                ready <= 1'b1;
+
+                if (we) begin
+                    case (address)
+                        MTIMECMP_REG_ADDR:  mtimecmp[31:0] <= write_data;
+                        MTIMECMPH_REG_ADDR: mtimecmp[63:32] <= write_data;
+                        MTIME_REG_ADDR:     mtime[31:0] <= write_data; // wins over the increment
+                        MTIMEH_REG_ADDR:    mtime[63:32] <= write_data;
+                        default: ;
+                    endcase
+                end else begin
+                    case (address)
+                        MTIMECMP_REG_ADDR:  read_data <= mtimecmp[31:0];
+                        MTIMECMPH_REG_ADDR: read_data <= mtimecmp[63:32];
+                        MTIME_REG_ADDR:     read_data <= mtime[31:0];
+                        MTIMEH_REG_ADDR:    read_data <= mtime[63:32];
+                        default:            read_data <= 32'b0;
+                    endcase
+                end
+            end
+        end
+    end
+
+endmodule
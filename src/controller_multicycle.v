@@ -8,14 +8,21 @@ module controller_multicycle (
     input  wire [6:0]  i_opcode,
     input  wire [2:0]  i_funct3,
     input  wire [6:0]  i_funct7,
+    input  wire [4:0]  i_rs1,      // rs1 field (CSR write is skipped for CSRRS/CSRRC with x0)
 
-    // ALU status flags (from ALU compare)
-    input  wire        i_zero,
-    input  wire        i_neg,
-    input  wire        i_carry,
+    // Branch comparator result (rs1/rs2 straight from the register file, valid in DECODE)
+    input  wire        i_branch_taken,
+
+    // Enabled interrupt pending (taken in DECODE, before the instruction executes)
+    input  wire        i_irq_pending,
+    // Interrupt pending and enabled in mie, regardless of mstatus.MIE (ends WFI)
+    input  wire        i_irq_wake,
+
+    // Multiply/divide unit result ready (same cycle as the start with a single-cycle unit)
+    input  wire        i_muldiv_done,
 
     // Mux select signals (outputs)
-    output reg  [1:0]  o_pc_sel,
+    output reg  [1:0]  o_pc_sel,     // 00 = PC+4, 01 = PC+imm, 10 = JALR target, 11 = trap vector/mepc
     output reg  [1:0]  o_result_sel, // 00 = ALU, 01 = MEM, 10 = PC+4, 11 = LUI
     output reg         o_alu_a_sel,
     output reg         o_alu_b_sel,
@@ -24,11 +31,21 @@ module controller_multicycle (
     output reg  [3:0]  o_alu_ctrl,
     output reg  [2:0]  o_imm_ctrl,
 
+    // Multiply/divide unit: start (EXECUTE of an RV32M instruction), result instead of the ALU
+    output reg         o_muldiv_start,
+    output reg         o_muldiv_sel,
+
     // Register File control signals
     output reg         o_reg_we,
 
     // MDR control signals (capture memory read)
     output reg         o_mdr_we,
+    output reg         o_mdr_src,    // 0 = RAM read data, 1 = CSR read data
+
+    // CSR file control signals
+    output reg         o_csr_we,
+    output reg         o_trap,       // enter the trap handler (mepc = PC of the instruction in IR)
+    output reg         o_mret,       // return to mepc
 
     // RAM control signals
     output reg         o_ram_we,
@@ -37,7 +54,7 @@ module controller_multicycle (
     // IR control signals
     output reg         o_ir_we,
 
-    // PC write enable
+    // PC write enable (the ROM request for the new PC starts in the same cycle)
     output reg         o_pc_we,
 
     // Decode latch control signal
@@ -52,7 +69,22 @@ module controller_multicycle (
 
     // RAM interface signals
     output wire o_ram_req,
-    input wire i_ram_ready
+    input wire i_ram_ready,
+
+    // Halt status (ECALL/EBREAK reached)
+    output wire o_halted,
+
+    // Sleeping in WFI with the next instruction already fetched, nothing changes until an
+    // interrupt wakes the core
+    output wire o_idle,
+
+    // Instruction completes at the end of this cycle
+    output reg  o_retire,
+
+    // Stall events for the performance counters
+    output wire o_fetch_stall,
+    output wire o_mem_stall,
+    output wire o_muldiv_stall
 );
 
     // Opcode definitions
@@ -65,28 +97,46 @@ module controller_multicycle (
     localparam OP_JALR     = 7'b1100111;  // JALR
     localparam OP_LUI      = 7'b0110111;  // LUI
     localparam OP_AUIPC    = 7'b0010111;  // AUIPC
+    localparam OP_SYSTEM   = 7'b1110011;  // ECALL/EBREAK, MRET, CSR instructions
 
-    // Multicycle states
-    localparam FETCH    = 3'b000;
-    localparam FETCH_WAIT  = 3'b101; // for synchronous IMEM
-    localparam DECODE   = 3'b001;
-    localparam EXECUTE  = 3'b010;
-    localparam MEMORY   = 3'b011;
-    localparam MEMORY_WAIT  = 3'b110; // for synchronous DMEM (needed for loads)
-    localparam WRITEBACK= 3'b100;
-
-    reg [2:0] state, next_state;
+    localparam F7_MRET     = 7'b0011000;  // funct7 of MRET (SYSTEM, funct3 000)
+    localparam F7_WFI      = 7'b0001000;  // funct7 of WFI (SYSTEM, funct3 000)
+    localparam F7_MULDIV   = 7'b0000001;  // funct7 of the M extension (R-type)
 
-    reg branch_taken;
-    reg [2:0] debug_branch;
+    // Multicycle states
+    localparam FETCH    = 4'b0000; // first fetch after reset
+    localparam FETCH_WAIT  = 4'b0101; // waiting for the next instruction from IMEM
+    localparam DECODE   = 4'b0001;
+    localparam EXECUTE  = 4'b0010;
+    localparam MEMORY   = 4'b0011;
+    localparam MEMORY_WAIT  = 4'b0110; // for synchronous DMEM (needed for loads)
+    localparam WRITEBACK= 4'b0100;
+    localparam HALT     = 4'b0111; // end of program, stays here until reset
+    localparam WFI      = 4'b1000; // waiting for an interrupt, the next instruction is prefetched
+    localparam MULDIV   = 4'b1001; // waiting for the multiply/divide unit
+
+    reg [3:0] state, next_state;
+
+    // Overlapped fetch: the PC moves to the next instruction in DECODE (JALR: EXECUTE) and the
+    // ROM request starts right away. The response is loaded into IR when the current
+    // instruction finishes, or remembered in fetch_ready if it arrives earlier (IMEM holds
+    // read_data until the next request).
+    reg fetch_ready;
+    reg prefetching; // a request for the next instruction is outstanding in this state
+    wire next_instr_ready = fetch_ready || i_rom_ready;
 
     // Sequential state register
     always @(posedge clk or posedge rst) begin
         if (rst) begin
             state <= FETCH;
-        end
-        else
+            fetch_ready <= 1'b0;
+        end else begin
             state <= next_state;
+            if (o_ir_we)
+                fetch_ready <= 1'b0;
+            else if (prefetching && i_rom_ready)
+                fetch_ready <= 1'b1;
+        end
     end
 
     // Combinational next state and output logic
@@ -95,6 +145,12 @@ module controller_multicycle (
         o_ir_we    = 1'b0;
         o_reg_we   = 1'b0;
         o_mdr_we   = 1'b0;
+        o_mdr_src  = 1'b0;
+        o_csr_we   = 1'b0;
+        o_trap     = 1'b0;
+        o_mret     = 1'b0;
+        o_muldiv_start = 1'b0;
+        o_muldiv_sel   = 1'b0;
         o_ram_we   = 1'b0;
 
         o_pc_sel   = 2'b00;
@@ -109,8 +165,8 @@ module controller_multicycle (
         o_decode_we = 1'b0;
         o_execute_we= 1'b0;
 
-        branch_taken = 1'b0;
-        debug_branch = 3'b000;
+        o_retire    = 1'b0;
+        prefetching = 1'b0;
 
         o_rom_req = 1'b0;
         o_ram_req = 1'b0;
@@ -120,29 +176,24 @@ module controller_multicycle (
         case (state)
             //------------------------------------------------------------------
             FETCH: begin
-                // For synchronous IMEM we just set up for next cycle
-                o_pc_sel = 2'b00; // PC + 4
-                o_rom_req = 1'b1; // Request instruction fetch
-            
+                o_rom_req = 1'b1; // Request instruction fetch at PC
                 next_state = FETCH_WAIT;
             end
 
             FETCH_WAIT: begin
                 // Synchronous IMEM: capture instruction into IR
-                o_rom_req = 1'b1; // Keep request asserted until ready
-                if (i_rom_ready) begin
+                if (next_instr_ready) begin
                     o_ir_we = 1'b1; // Load instruction into IR
                     next_state = DECODE;
                 end else begin
-                    o_ir_we = 1'b0; // Wait until instruction is ready
+                    o_rom_req = 1'b1; // Keep request asserted until ready
                     next_state = FETCH_WAIT;
                 end
-                o_pc_sel = 2'b00; // PC + 4
             end
 
             //------------------------------------------------------------------
             DECODE: begin
-                // Latch instruction fields into decode cycle
+                // Latch register operands, immediate and PC
                 o_decode_we = 1'b1;
 
                 case (i_opcode)
@@ -158,21 +209,107 @@ module controller_multicycle (
                     default:    o_imm_ctrl = `IMM_I_TYPE;
                 endcase
 
-                next_state = EXECUTE;
+                case (i_opcode)
+                    // -------- BRANCH: resolved here by the branch comparator
+                    OP_BRANCH: begin
+                        o_pc_sel = i_branch_taken ? 2'b01 : 2'b00; // PC + imm or PC + 4
+                        o_pc_we  = 1'b1;
+                        o_rom_req = 1'b1;
+                        o_retire = 1'b1;
+
+                        next_state = FETCH_WAIT;
+                    end
+
+                    // -------- JAL: rd = PC + 4, PC = PC + imm
+                    OP_JAL: begin
+                        o_result_sel = 2'b10; // PC + 4
+                        o_reg_we = 1'b1;
+                        o_pc_sel = 2'b01;     // PC + imm
+                        o_pc_we  = 1'b1;
+                        o_rom_req = 1'b1;
+                        o_retire = 1'b1;
+
+                        next_state = FETCH_WAIT;
+                    end
+
+                    // -------- JALR: target needs the ALU, PC is updated in EXECUTE
+                    OP_JALR: begin
+                        next_state = EXECUTE;
+                    end
+
+                    // -------- ECALL/EBREAK end the program (PC is left on the instruction),
+                    // MRET jumps back to mepc, WFI sleeps until an interrupt is pending
+                    OP_SYSTEM: begin
+                        if (i_funct3 == 3'b000 && i_funct7 == F7_MRET) begin
+                            o_mret = 1'b1;
+                            o_pc_sel = 2'b11;
+                            o_pc_we  = 1'b1;
+                            o_rom_req = 1'b1;
+                            o_retire = 1'b1;
+
+                            next_state = FETCH_WAIT;
+                        end else if (i_funct3 == 3'b000 && i_funct7 == F7_WFI) begin
+                            o_pc_we = 1'b1;   // PC + 4, start fetching the next instruction
+                            o_rom_req = 1'b1;
+                            o_retire = 1'b1;
+
+                            next_state = WFI;
+                        end else if (i_funct3 == 3'b000) begin
+                            o_retire = 1'b1;
+                            next_state = HALT;
+                        end else begin
+                            o_pc_we = 1'b1;   // PC + 4, start fetching the next instruction
+                            o_rom_req = 1'b1;
+                            next_state = EXECUTE;
+                        end
+                    end
+
+                    OP_R_TYPE,
+                    OP_I_TYPE,
+                    OP_LOAD,
+                    OP_STORE,
+                    OP_LUI,
+                    OP_AUIPC: begin
+                        o_pc_we = 1'b1;   // PC + 4, start fetching the next instruction
+                        o_rom_req = 1'b1;
+                        next_state = EXECUTE;
+                    end
+
+                    default: begin
+                        // Unhandled opcode -> fetch it again
+                        next_state = FETCH;
+                    end
+                endcase
+
+                // -------- Interrupt: the instruction in IR does not execute, its PC goes to
+                // mepc and the handler is fetched from mtvec instead
+                if (i_irq_pending) begin
+                    o_reg_we  = 1'b0;
+                    o_retire  = 1'b0;
+                    o_mret    = 1'b0;
+                    o_trap    = 1'b1;
+                    o_pc_sel  = 2'b11;
+                    o_pc_we   = 1'b1;
+                    o_rom_req = 1'b1;
+
+                    next_state = FETCH_WAIT;
+                end
             end
 
             //------------------------------------------------------------------
             EXECUTE: begin
                 // Latch ALU outputs into EXECUTE stage
                 o_execute_we = 1'b1;
+                // The next instruction is being fetched, except for JALR
+                prefetching = (i_opcode != OP_JALR);
+                o_rom_req = prefetching && !next_instr_ready;
 
                 case (i_opcode)
-                    // -------- R-type: ALU operation -> then WRITEBACK
+                    // -------- R-type: ALU operation, written back directly. RV32M instructions
+                    // start the multiply/divide unit and wait in MULDIV unless it is done at once
                     OP_R_TYPE: begin
                         o_alu_b_sel = 1'b0; // rs2
                         o_alu_a_sel = 1'b0; // rs1
-                        o_pc_we = 1'b1;     // update PC
-                        o_pc_sel = 2'b00;   // PC + 4
                         
                         case ({i_funct7, i_funct3})
                             10'b0000000_000: o_alu_ctrl = `ALU_ADD;
@@ -188,15 +325,30 @@ module controller_multicycle (
                             default:         o_alu_ctrl = `ALU_ADD;
                         endcase
 
-                        next_state = WRITEBACK;
+                        if (i_funct7 == F7_MULDIV) begin
+                            o_muldiv_start = 1'b1;
+                            o_muldiv_sel = 1'b1;
+                        end
+
+                        if (i_funct7 == F7_MULDIV && !i_muldiv_done) begin
+                            next_state = MULDIV;
+                        end else begin
+                            o_result_sel = 2'b00; // ALU (or multiply/divide) result
+                            o_reg_we = 1'b1;
+                            o_retire = 1'b1;
+                            if (next_instr_ready) begin
+                                o_ir_we = 1'b1;
+                                next_state = DECODE;
+                            end else begin
+                                next_state = FETCH_WAIT;
+                            end
+                        end
                     end
 
-                    // -------- I-type ALU immediate (ADDI, ANDI, etc.)
+                    // -------- I-type ALU immediate (ADDI, ANDI, etc.), written back directly
                     OP_I_TYPE: begin
                         o_alu_b_sel = 1'b1; // immediate
                         o_alu_a_sel = 1'b0; // rs1
-                        o_pc_we = 1'b1;     // update PC
-                        o_pc_sel = 2'b00;   // PC + 4
 
                         case (i_funct3)
                             3'b000: o_alu_ctrl = `ALU_ADD; // ADDI
@@ -216,7 +368,15 @@ module controller_multicycle (
                             default: o_alu_ctrl = `ALU_ADD;
                         endcase
 
-                        next_state = WRITEBACK;
+                        o_result_sel = 2'b00; // ALU result
+                        o_reg_we = 1'b1;
+                        o_retire = 1'b1;
+                        if (next_instr_ready) begin
+                            o_ir_we = 1'b1;
+                            next_state = DECODE;
+                        end else begin
+                            next_state = FETCH_WAIT;
+                        end
                     end
 
                     // -------- LOAD: compute address (rs1 + imm) -> MEMORY -> WRITEBACK
@@ -224,123 +384,77 @@ module controller_multicycle (
                         o_alu_b_sel = 1'b1; // imm
                         o_alu_a_sel = 1'b0; // rs1
                         o_alu_ctrl  = `ALU_ADD; // address calc
-                        o_pc_we = 1'b1;     // update PC
-                        o_pc_sel = 2'b00;   // PC + 4
 
                         next_state = MEMORY;
                     end
 
-                    // -------- STORE: compute address (rs1 + imm) -> MEMORY (write) -> FETCH
+                    // -------- STORE: compute address (rs1 + imm) -> MEMORY (write)
                     OP_STORE: begin
                         o_alu_b_sel = 1'b1; // imm
                         o_alu_a_sel = 1'b0; // rs1
                         o_alu_ctrl  = `ALU_ADD; // address calc
-                        o_pc_we = 1'b1;     // update PC
-                        o_pc_sel = 2'b00;   // PC + 4
 
                         next_state = MEMORY;
                     end
 
-                    // -------- BRANCH: compare and update PC if taken (PC updated immediately)
-                    OP_BRANCH: begin
-                        o_alu_b_sel = 1'b0; // rs2
-                        o_alu_a_sel = 1'b0; // rs1
-                        o_alu_ctrl  = `ALU_SUB; // compare
-                        o_pc_we    = 1'b1; // allow PC update
-
-                        case (i_funct3)
-                            3'b000: begin // BEQ
-                                if (i_zero) begin
-                                    branch_taken = 1'b1;
-                                    debug_branch = 3'b001;
-                                end
-                            end
-                            3'b001: begin // BNE
-                                if (!i_zero) begin
-                                    branch_taken = 1'b1;
-                                    debug_branch = 3'b010;
-                                end
-                            end
-                            3'b100: begin // BLT
-                                if (i_neg) begin
-                                    branch_taken = 1'b1;
-                                    debug_branch = 3'b011;
-                                end
-                            end
-                            3'b101: begin // BGE
-                                if (!i_neg || i_zero) begin
-                                    branch_taken = 1'b1;
-                                    debug_branch = 3'b100;
-                                end
-                            end
-                            3'b110: begin // BLTU
-                                if (!i_carry) begin
-                                    branch_taken = 1'b1;
-                                    debug_branch = 3'b101;
-                                end
-                            end
-                            3'b111: begin // BGEU
-                                if (i_carry || i_zero) begin
-                                    branch_taken = 1'b1;
-                                    debug_branch = 3'b110;
-                                end
-                            end
-                            default: begin
-                                branch_taken = 1'b0;
-                                debug_branch = 3'b000;
-                            end
-                        endcase
-
-                        if (branch_taken) begin
-                            o_pc_sel = 2'b01; // branch target path
-                        end else begin
-                            o_pc_sel = 2'b00; // PC + 4
-                        end
-
-                        // After EXECUTE branch, go to FETCH
-                        next_state = FETCH;
-                    end
-
-                    // -------- JAL: set PC to target (PC+imm) and write PC+4 to rd in WB
-                    OP_JAL: begin
-                        o_pc_sel = 2'b01; // branch-like target selected (branch target path)
-                        o_pc_we  = 1'b1; // allow PC update
-
-                        next_state = WRITEBACK;
-                    end
-
-                    // -------- JALR: target = rs1 + imm, write PC+4 to rd
+                    // -------- JALR: PC = (rs1 + imm) & ~1, rd = PC + 4 (PC still on the JALR)
                     OP_JALR: begin
                         o_alu_a_sel = 1'b0; // rs1
                         o_alu_b_sel = 1'b1; // imm
                         o_alu_ctrl  = `ALU_ADD; // compute target
                         o_pc_sel    = 2'b10;    // select ALU result as PC target
-                        o_pc_we     = 1'b1;     // allow PC update
+                        o_pc_we     = 1'b1;     // update PC and fetch from the target
+                        o_rom_req   = 1'b1;
+                        o_result_sel = 2'b10;   // PC + 4
+                        o_reg_we    = 1'b1;
+                        o_retire    = 1'b1;
 
-                        next_state = WRITEBACK;
+                        next_state = FETCH_WAIT;
                     end
 
-                    // -------- LUI: write immediate << 12 to rd (handled in WB)
+                    // -------- LUI: write immediate << 12 to rd
                     OP_LUI: begin
-                        o_pc_we = 1'b1;     // update PC
-                        o_pc_sel = 2'b00;   // PC + 4
-
-                        next_state = WRITEBACK;
+                        o_result_sel = 2'b11; // LUI immediate
+                        o_reg_we = 1'b1;
+                        o_retire = 1'b1;
+                        if (next_instr_ready) begin
+                            o_ir_we = 1'b1;
+                            next_state = DECODE;
+                        end else begin
+                            next_state = FETCH_WAIT;
+                        end
                     end
 
-                    // -------- AUIPC: PC + imm (ALU) -> WB
+                    // -------- AUIPC: PC of this instruction (latched in DECODE) + imm
                     OP_AUIPC: begin
-                        o_alu_a_sel = 1'b1; // PC
+                        o_alu_a_sel = 1'b1; // old PC
                         o_alu_b_sel = 1'b1; // imm
                         o_alu_ctrl  = `ALU_ADD;
-                        o_pc_we = 1'b1;     // update PC
-                        o_pc_sel = 2'b00;   // PC + 4
+
+                        o_result_sel = 2'b00; // ALU result
+                        o_reg_we = 1'b1;
+                        o_retire = 1'b1;
+                        if (next_instr_ready) begin
+                            o_ir_we = 1'b1;
+                            next_state = DECODE;
+                        end else begin
+                            next_state = FETCH_WAIT;
+                        end
+                    end
+
+                    // -------- SYSTEM: CSR instructions read the old value into MDR and
+                    // write the new one -> WRITEBACK
+                    OP_SYSTEM: begin
+                        o_mdr_src = 1'b1;  // CSR read data
+                        o_mdr_we  = 1'b1;
+                        // CSRRS/CSRRC (and immediate forms) with x0/zero do not write
+                        o_csr_we  = (i_funct3[1:0] == 2'b01) || (i_rs1 != 5'b0);
 
                         next_state = WRITEBACK;
                     end
 
                     default: begin
-                        // Unhandled opcode -> treat as NOP
+                        // Branches, JAL and ECALL never get here
                         next_state = FETCH;
                     end
                 endcase
@@ -349,6 +463,8 @@ module controller_multicycle (
             //------------------------------------------------------------------
             MEMORY: begin
                 o_ram_req = 1'b1; // Request memory access (read or write)
+                prefetching = 1'b1;
+                o_rom_req = !next_instr_ready;
 
                 // Memory state: for loads do read (capture into MDR), for stores do write
                 if (i_opcode == OP_LOAD) begin
@@ -375,7 +491,14 @@ module controller_multicycle (
                     endcase
 
                     if (i_ram_ready) begin
-                        next_state = FETCH; // write done, move on
+                        // write done, move on
+                        o_retire = 1'b1;
+                        if (next_instr_ready) begin
+                            o_ir_we = 1'b1;
+                            next_state = DECODE;
+                        end else begin
+                            next_state = FETCH_WAIT;
+                        end
                     end else begin
                         next_state = MEMORY; // wait for memory to accept write
                     end
@@ -387,6 +510,9 @@ module controller_multicycle (
 
             MEMORY_WAIT: begin
                 // o_ram_req = 1'b1; // Keep request asserted until ready
+                prefetching = 1'b1;
+                o_rom_req = !next_instr_ready;
+
                 // Re-assert ram_mode
                 case (i_funct3)
                     3'b000: o_ram_mode = `DM_LB;
@@ -408,22 +534,63 @@ module controller_multicycle (
 
             //------------------------------------------------------------------
             WRITEBACK: begin
-                // Write result into register file (if applicable)
+                // Only loads and CSR instructions get here, both write the MDR
+                prefetching = 1'b1;
+                o_rom_req = !next_instr_ready;
+
                 o_reg_we = 1'b1;
-                
-                // Decide the o_result_sel
-                case (i_opcode)
-                    OP_R_TYPE:      o_result_sel = 2'b00; // ALU result
-                    OP_I_TYPE:      o_result_sel = 2'b00; // ALU result
-                    OP_LOAD:        o_result_sel = 2'b01; // Memory data
-                    OP_JAL,
-                    OP_JALR:        o_result_sel = 2'b10; // PC + 4
-                    OP_LUI:         o_result_sel = 2'b11; // LUI immediate
-                    OP_AUIPC:      o_result_sel = 2'b00; // ALU result
-                    default:        o_result_sel = 2'b00; // default to ALU
-                endcase
+                o_result_sel = 2'b01; // MDR (load data or CSR value)
+                o_retire = 1'b1;
 
-                next_state = FETCH;
+                if (next_instr_ready) begin
+                    o_ir_we = 1'b1;
+                    next_state = DECODE;
+                end else begin
+                    next_state = FETCH_WAIT;
+                end
+            end
+
+            //------------------------------------------------------------------
+            MULDIV: begin
+                prefetching = 1'b1;
+                o_rom_req = !next_instr_ready;
+                o_muldiv_sel = 1'b1;
+
+                if (i_muldiv_done) begin
+                    o_result_sel = 2'b00;
+                    o_reg_we = 1'b1;
+                    o_retire = 1'b1;
+                    if (next_instr_ready) begin
+                        o_ir_we = 1'b1;
+                        next_state = DECODE;
+                    end else begin
+                        next_state = FETCH_WAIT;
+                    end
+                end else begin
+                    next_state = MULDIV;
+                end
+            end
+
+            //------------------------------------------------------------------
+            WFI: begin
+                prefetching = 1'b1;
+                o_rom_req = !next_instr_ready;
+
+                // An interrupt enabled in mie ends the wait; it is taken in DECODE if
+                // mstatus.MIE is set, otherwise execution simply continues
+                if (i_irq_wake && next_instr_ready) begin
+                    o_ir_we = 1'b1;
+                    next_state = DECODE;
+                end else if (i_irq_wake) begin
+                    next_state = FETCH_WAIT;
+                end else begin
+                    next_state = WFI;
+                end
+            end
+
+            //------------------------------------------------------------------
+            HALT: begin
+                next_state = HALT;
             end
 
             //------------------------------------------------------------------
@@ -433,4 +600,10 @@ module controller_multicycle (
         endcase
     end
 
+    assign o_halted = (state == HALT);
+    assign o_idle = (state == WFI) && fetch_ready && !i_irq_wake;
+    assign o_fetch_stall = (state == FETCH_WAIT);
+    assign o_mem_stall = (state == MEMORY_WAIT);
+    assign o_muldiv_stall = (state == MULDIV);
+
 endmodule
@@ -0,0 +1,220 @@
+`include "defines.vh"
+
+// Combinational decoder for the pipelined core: turns the instruction in ID into the
+// control bundle carried down the pipeline (same encodings as controller_multicycle)
+module controller_pipelined (
+    input  wire [6:0]  i_opcode,
+    input  wire [2:0]  i_funct3,
+    input  wire [6:0]  i_funct7,
+    input  wire [4:0]  i_rs1,      // rs1 field (CSR write is skipped for CSRRS/CSRRC with x0)
+
+    // Immediate Extender control
+    output reg  [2:0]  o_imm_ctrl,
+
+    // EX stage
+    output reg  [3:0]  o_alu_ctrl,
+    output reg         o_alu_a_sel,  // 0 = rs1, 1 = PC
+    output reg         o_alu_b_sel,  // 0 = rs2, 1 = immediate
+    output reg  [1:0]  o_result_sel, // 00 = ALU, 01 = CSR, 10 = PC+4, 11 = LUI
+    output reg         o_branch,
+    output reg         o_jal,
+    output reg         o_jalr,
+    output reg         o_csr,
+    output reg         o_csr_we,
+    output reg         o_halt,       // ECALL/EBREAK
+    output reg         o_muldiv,     // RV32M: result from the multiply/divide unit
+
+    // MEM stage
+    output reg         o_mem_read,
+    output reg         o_mem_write,
+    output reg  [2:0]  o_ram_mode,
+
+    // WB stage
+    output reg         o_reg_we,
+
+    // Register operands actually read (for the load-use interlock)
+    output reg         o_uses_rs1,
+    output reg         o_uses_rs2
+);
+
+    // Opcode definitions
+    localparam OP_R_TYPE   = 7'b0110011;  // R-type
+    localparam OP_I_TYPE   = 7'b0010011;  // I-type
+    localparam OP_LOAD     = 7'b0000011;  // Load instructions
+    localparam OP_STORE    = 7'b0100011;  // Store instructions
+    localparam OP_BRANCH   = 7'b1100011;  // Branch instructions
+    localparam OP_JAL      = 7'b1101111;  // JAL
+    localparam OP_JALR     = 7'b1100111;  // JALR
+    localparam OP_LUI      = 7'b0110111;  // LUI
+    localparam OP_AUIPC    = 7'b0010111;  // AUIPC
+    localparam OP_SYSTEM   = 7'b1110011;  // ECALL/EBREAK, CSR instructions
+
+    localparam F7_MULDIV   = 7'b0000001;  // funct7 of the M extension (R-type)
+
+    always @(*) begin
+        // Defaults: NOP
+        o_imm_ctrl   = `IMM_I_TYPE;
+        o_alu_ctrl   = `ALU_ADD;
+        o_alu_a_sel  = 1'b0;
+        o_alu_b_sel  = 1'b0;
+        o_result_sel = 2'b00;
+        o_branch     = 1'b0;
+        o_jal        = 1'b0;
+        o_jalr       = 1'b0;
+        o_csr        = 1'b0;
+        o_csr_we     = 1'b0;
+        o_halt       = 1'b0;
+        o_muldiv     = 1'b0;
+        o_mem_read   = 1'b0;
+        o_mem_write  = 1'b0;
+        o_ram_mode   = `DM_LW;
+        o_reg_we     = 1'b0;
+        o_uses_rs1   = 1'b0;
+        o_uses_rs2   = 1'b0;
+
+        case (i_opcode)
+            // -------- R-type: rd = rs1 op rs2 (ALU or multiply/divide unit)
+            OP_R_TYPE: begin
+                o_imm_ctrl = `IMM_R_TYPE;
+                o_reg_we   = 1'b1;
+                o_uses_rs1 = 1'b1;
+                o_uses_rs2 = 1'b1;
+                o_muldiv   = (i_funct7 == F7_MULDIV);
+
+                case ({i_funct7, i_funct3})
+                    10'b0000000_000: o_alu_ctrl = `ALU_ADD;
+                    10'b0100000_000: o_alu_ctrl = `ALU_SUB;
+                    10'b0000000_001: o_alu_ctrl = `ALU_SLL;
+                    10'b0000000_010: o_alu_ctrl = `ALU_SLT;
+                    10'b0000000_011: o_alu_ctrl = `ALU_SLTU;
+                    10'b0000000_100: o_alu_ctrl = `ALU_XOR;
+                    10'b0000000_101: o_alu_ctrl = `ALU_SRL;
+                    10'b0100000_101: o_alu_ctrl = `ALU_SRA;
+                    10'b0000000_110: o_alu_ctrl = `ALU_OR;
+                    10'b0000000_111: o_alu_ctrl = `ALU_AND;
+                    default:         o_alu_ctrl = `ALU_ADD;
+                endcase
+            end
+
+            // -------- I-type ALU immediate (ADDI, ANDI, etc.)
+            OP_I_TYPE: begin
+                o_alu_b_sel = 1'b1; // immediate
+                o_reg_we    = 1'b1;
+                o_uses_rs1  = 1'b1;
+
+                case (i_funct3)
+                    3'b000: o_alu_ctrl = `ALU_ADD; // ADDI
+                    3'b010: o_alu_ctrl = `ALU_SLT; // SLTI
+                    3'b011: o_alu_ctrl = `ALU_SLTU;// SLTIU
+                    3'b100: o_alu_ctrl = `ALU_XOR; // XORI
+                    3'b110: o_alu_ctrl = `ALU_OR;  // ORI
+                    3'b111: o_alu_ctrl = `ALU_AND; // ANDI
+                    3'b001: o_alu_ctrl = `ALU_SLL; // SLLI
+                    3'b101: begin
+                        case (i_funct7)
+                            7'b0000000: o_alu_ctrl = `ALU_SRL; // SRLI
+                            7'b0100000: o_alu_ctrl = `ALU_SRA; // SRAI
+                            default:    o_alu_ctrl = `ALU_ADD;
+                        endcase
+                    end
+                    default: o_alu_ctrl = `ALU_ADD;
+                endcase
+            end
+
+            // -------- LOAD: address = rs1 + imm, data written back from MEM
+            OP_LOAD: begin
+                o_alu_b_sel = 1'b1;
+                o_mem_read  = 1'b1;
+                o_reg_we    = 1'b1;
+                o_uses_rs1  = 1'b1;
+
+                case (i_funct3)
+                    3'b000: o_ram_mode = `DM_LB;
+                    3'b001: o_ram_mode = `DM_LH;
+                    3'b010: o_ram_mode = `DM_LW;
+                    3'b100: o_ram_mode = `DM_LBU;
+                    3'b101: o_ram_mode = `DM_LHU;
+                    default: o_ram_mode = `DM_LW;
+                endcase
+            end
+
+            // -------- STORE: address = rs1 + imm, rs2 written in MEM
+            OP_STORE: begin
+                o_imm_ctrl  = `IMM_S_TYPE;
+                o_alu_b_sel = 1'b1;
+                o_mem_write = 1'b1;
+                o_uses_rs1  = 1'b1;
+                o_uses_rs2  = 1'b1;
+
+                case (i_funct3)
+                    3'b000: o_ram_mode = `DM_SB;
+                    3'b001: o_ram_mode = `DM_SH;
+                    3'b010: o_ram_mode = `DM_SW;
+                    default: o_ram_mode = `DM_SW;
+                endcase
+            end
+
+            // -------- BRANCH: compared and resolved in EX
+            OP_BRANCH: begin
+                o_imm_ctrl = `IMM_B_TYPE;
+                o_branch   = 1'b1;
+                o_uses_rs1 = 1'b1;
+                o_uses_rs2 = 1'b1;
+            end
+
+            // -------- JAL: PC + imm, rd = PC + 4
+            OP_JAL: begin
+                o_imm_ctrl   = `IMM_J_TYPE;
+                o_jal        = 1'b1;
+                o_result_sel = 2'b10;
+                o_reg_we     = 1'b1;
+            end
+
+            // -------- JALR: (rs1 + imm) & ~1, rd = PC + 4
+            OP_JALR: begin
+                o_alu_b_sel  = 1'b1;
+                o_jalr       = 1'b1;
+                o_result_sel = 2'b10;
+                o_reg_we     = 1'b1;
+                o_uses_rs1   = 1'b1;
+            end
+
+            // -------- LUI: rd = imm << 12
+            OP_LUI: begin
+                o_imm_ctrl   = `IMM_U_TYPE;
+                o_result_sel = 2'b11;
+                o_reg_we     = 1'b1;
+            end
+
+            // -------- AUIPC: rd = PC + (imm << 12)
+            OP_AUIPC: begin
+                o_imm_ctrl  = `IMM_U_TYPE;
+                o_alu_a_sel = 1'b1;
+                o_alu_b_sel = 1'b1;
+                o_reg_we    = 1'b1;
+            end
+
+            // -------- SYSTEM: ECALL/EBREAK halt once they reach WB, WFI is a NOP (no
+            // interrupts in this core), CSR instructions read/write the CSR file in EX
+            OP_SYSTEM: begin
+                if (i_funct3 == 3'b000 && i_funct7 == 7'b0001000) begin
+                    // WFI
+                end else if (i_funct3 == 3'b000) begin
+                    o_halt = 1'b1;
+                end else begin
+                    o_csr        = 1'b1;
+                    // CSRRS/CSRRC (and immediate forms) with x0/zero do not write
+                    o_csr_we     = (i_funct3[1:0] == 2'b01) || (i_rs1 != 5'b0);
+                    o_result_sel = 2'b01;
+                    o_reg_we     = 1'b1;
+                    o_uses_rs1   = !i_funct3[2];
+                end
+            end
+
+            default: begin
+                // Unhandled opcode -> treat as NOP
+            end
+        endcase
+    end
+
+endmodule
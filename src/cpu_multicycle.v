@@ -1,6 +1,9 @@
-module cpu_multicycle (
+module cpu_multicycle #(
+    parameter MULDIV_IMPL = 0 // 0 = single cycle, 1 = iterative, 2 = iterative with early termination
+) (
     input wire clk,
     input wire rst,
+    input wire [31:0] i_reset_vector, // PC after reset
 
     // ROM interface
     output wire [31:0] o_rom_addr,
@@ -15,7 +18,20 @@ module cpu_multicycle (
     output wire o_ram_we,
     output wire [2:0] o_ram_mode,
     output wire o_ram_req,
-    input wire i_ram_ready
+    input wire i_ram_ready,
+
+    // Bus controller waiting on a peripheral (performance counter event)
+    input wire i_bus_stall,
+
+    // Machine external and timer interrupt lines (level-sensitive)
+    input wire i_irq_external,
+    input wire i_irq_timer,
+
+    // Status
+    output wire o_halted,
+    output wire o_idle,     // sleeping in WFI
+    output wire o_retire,   // instruction completes this cycle
+    output wire [31:0] o_pc // current PC register
 );
 
     // Internal signals
@@ -35,16 +51,29 @@ module cpu_multicycle (
     wire [31:0] w_alu_a;
     wire [31:0] w_alu_b;
     wire [31:0] w_alu_result;
+    wire [31:0] w_muldiv_result;
+    wire [31:0] w_exec_result; // ALU or multiply/divide unit
     wire [3:0]  w_alu_ctrl;
     wire w_zero_flag, w_neg_flag, w_carry_flag;
 
     wire [31:0] w_mdr_out;
+    wire [31:0] w_mdr_in;
+
+    wire [31:0] w_csr_rdata;
+    wire [31:0] w_csr_wdata;
+    wire [31:0] w_trap_vector;
+    wire [31:0] w_epc;
+    wire [31:0] w_trap_target;
+    wire w_irq_pending;
+    wire w_irq_wake;
 
     wire [31:0] w_regA;
     wire [31:0] w_regB;
     wire [31:0] w_ALUOut;
     wire [31:0] w_imm_out; 
-    wire [31:0] w_pc_jump;
+    wire [31:0] w_pc_old;     // PC of the instruction (PC itself moves on in DECODE)
+    wire [31:0] w_jalr_target;
+    wire w_branch_taken;
 
     // control signals from Controller
     wire [1:0]  w_pc_sel;
@@ -56,16 +85,27 @@ module cpu_multicycle (
     wire        w_ctrl_reg_we;
     wire        w_ctrl_ir_we;
     wire        w_ctrl_mdr_we;
+    wire        w_ctrl_mdr_src;
+    wire        w_ctrl_csr_we;
+    wire        w_ctrl_trap;
+    wire        w_ctrl_mret;
+    wire        w_ctrl_muldiv_start;
+    wire        w_ctrl_muldiv_sel;
+    wire        w_muldiv_done;
+    wire        w_muldiv_stall;
     wire        w_ctrl_ram_we;
     wire [2:0]  w_ctrl_ram_mode;
     wire w_pc_we;
     wire w_decode_we;
     wire w_execute_we;
+    wire w_fetch_stall;
+    wire w_mem_stall;
 
     // PC instantiation
     program_counter pc_inst (
         .clk(clk),
         .rst(rst),
+        .reset_pc(i_reset_vector),
         .next_pc(w_next_pc),
         .pc(w_pc),
         .pc_we(w_pc_we)
@@ -107,28 +147,50 @@ module cpu_multicycle (
         .imm_src(w_ctrl_imm)
     );
 
-    // Branch Adder instantiation
+    // Branch Adder instantiation (branches and JAL resolve in DECODE)
     adder branch_adder_inst (
         .a(w_pc),
-        .b(w_imm_out),
+        .b(w_imm_ext),
         .sum(w_pc_branch)
     );
 
+    // Branch Comparator instantiation (register file outputs, valid in DECODE)
+    branch_comparator branch_cmp_inst (
+        .a(w_rs1_data),
+        .b(w_rs2_data),
+        .funct3(w_instr[14:12]),
+        .taken(w_branch_taken)
+    );
+
+    // JALR clears bit 0 of the target
+    assign w_jalr_target = {w_alu_result[31:1], 1'b0};
+
+    // Trap entry goes to mtvec, MRET back to mepc
+    assign w_trap_target = w_ctrl_mret ? w_epc : w_trap_vector;
+
     // PC Mux instantiation
     mux4 pc_mux_inst (
         .sel(w_pc_sel),
         .in0(w_pc_plus_4),
         .in1(w_pc_branch),
-        .in2(w_ALUOut),
-        .in3(32'b0),
+        .in2(w_jalr_target),
+        .in3(w_trap_target),
         .out(w_next_pc)
     );
 
+    // ROM Address Mux instantiation: fetch from the new PC in the cycle it is written
+    mux2 rom_addr_mux_inst (
+        .sel(w_pc_we),
+        .in0(w_pc),
+        .in1(w_next_pc),
+        .out(o_rom_addr)
+    );
+
     // AlU A Mux instantiation
     mux2 alu_a_mux_inst (
         .sel(w_alu_a_sel),
         .in0(w_regA),
-        .in1(w_pc),
+        .in1(w_pc_old),
         .out(w_alu_a)
     );
 
@@ -151,21 +213,78 @@ module cpu_multicycle (
         .carry(w_carry_flag)
     );
 
+    // Multiply/divide unit instantiation (operands latched in DECODE)
+    muldiv #(.IMPL(MULDIV_IMPL)) muldiv_inst (
+        .clk(clk),
+        .rst(rst),
+        .start(w_ctrl_muldiv_start),
+        .op(w_instr[14:12]),
+        .a(w_regA),
+        .b(w_regB),
+        .result(w_muldiv_result),
+        .done(w_muldiv_done),
+        .busy()
+    );
+
+    mux2 exec_result_mux_inst (
+        .sel(w_ctrl_muldiv_sel),
+        .in0(w_alu_result),
+        .in1(w_muldiv_result),
+        .out(w_exec_result)
+    );
+
+    // MDR Input Mux instantiation (RAM read data or CSR read data)
+    mux2 mdr_in_mux_inst (
+        .sel(w_ctrl_mdr_src),
+        .in0(i_ram_rdata),
+        .in1(w_csr_rdata),
+        .out(w_mdr_in)
+    );
+
     // MDR instantiation
     data_reg mdr_inst (
         .clk(clk),
         .rst(rst),
         .we(w_ctrl_mdr_we),
-        .data_in(i_ram_rdata),
+        .data_in(w_mdr_in),
         .data_out(w_mdr_out)
     );
 
+    // CSR write operand: rs1 (latched in regA) or zero-extended uimm for the immediate forms
+    assign w_csr_wdata = w_instr[14] ? {27'b0, w_instr[19:15]} : w_regA;
+
+    // CSR File instantiation
+    csr_file csr_inst (
+        .clk(clk),
+        .rst(rst),
+        .csr_addr(w_instr[31:20]),
+        .csr_op(w_instr[13:12]),
+        .csr_wdata(w_csr_wdata),
+        .csr_we(w_ctrl_csr_we),
+        .csr_rdata(w_csr_rdata),
+        .retire(o_retire),
+        .fetch_stall(w_fetch_stall),
+        .mem_stall(w_mem_stall),
+        .bus_stall(i_bus_stall),
+        .muldiv_stall(w_muldiv_stall),
+        .irq_external(i_irq_external),
+        .irq_timer(i_irq_timer),
+        .trap(w_ctrl_trap),
+        .trap_pc(w_pc),
+        .mret(w_ctrl_mret),
+        .irq_pending(w_irq_pending),
+        .irq_wake(w_irq_wake),
+        .trap_vector(w_trap_vector),
+        .epc(w_epc)
+    );
+
     // Write Back Mux instantiation
+    // ALU ops retire from EXECUTE, JAL from DECODE and JALR from EXECUTE (PC not yet moved)
     mux4 wb_mux_inst (
         .sel(w_wb_sel),
-        .in0(w_ALUOut),
+        .in0(w_exec_result),
         .in1(w_mdr_out),
-        .in2(w_pc_jump),
+        .in2(w_pc_plus_4),
         .in3(w_imm_out),
         .out(w_reg_wdata)
     );
@@ -196,20 +315,20 @@ module cpu_multicycle (
         .data_out(w_regB)
     );
 
-    reg32b reg_aluout (
+    reg32b reg_pc_old (
         .clk(clk),
         .rst(rst),
-        .we(w_execute_we),
-        .data_in(w_alu_result),
-        .data_out(w_ALUOut)
+        .we(w_decode_we),
+        .data_in(w_pc),
+        .data_out(w_pc_old)
     );
 
-    reg32b reg_pc_wb_jump (
+    reg32b reg_aluout (
         .clk(clk),
         .rst(rst),
         .we(w_execute_we),
-        .data_in(w_pc_plus_4),
-        .data_out(w_pc_jump)
+        .data_in(w_alu_result),
+        .data_out(w_ALUOut)
     );
 
     // Controller instantiation
@@ -219,9 +338,11 @@ module cpu_multicycle (
         .i_opcode(w_instr[6:0]),
         .i_funct3(w_instr[14:12]),
         .i_funct7(w_instr[31:25]),
-        .i_zero(w_zero_flag),
-        .i_neg(w_neg_flag),
-        .i_carry(w_carry_flag),
+        .i_rs1(w_instr[19:15]),
+        .i_branch_taken(w_branch_taken),
+        .i_irq_pending(w_irq_pending),
+        .i_irq_wake(w_irq_wake),
+        .i_muldiv_done(w_muldiv_done),
 
         .o_pc_sel(w_pc_sel),
         .o_result_sel(w_wb_sel),
@@ -231,9 +352,17 @@ module cpu_multicycle (
         .o_alu_ctrl(w_ctrl_alu),
         .o_imm_ctrl(w_ctrl_imm),
 
+        .o_muldiv_start(w_ctrl_muldiv_start),
+        .o_muldiv_sel(w_ctrl_muldiv_sel),
+
         .o_reg_we(w_ctrl_reg_we),
 
         .o_mdr_we(w_ctrl_mdr_we),
+        .o_mdr_src(w_ctrl_mdr_src),
+
+        .o_csr_we(w_ctrl_csr_we),
+        .o_trap(w_ctrl_trap),
+        .o_mret(w_ctrl_mret),
 
         .o_ram_we(w_ctrl_ram_we),
         .o_ram_mode(w_ctrl_ram_mode),
@@ -248,14 +377,22 @@ module cpu_multicycle (
         .i_rom_ready(i_rom_ready),
 
         .o_ram_req(o_ram_req),
-        .i_ram_ready(i_ram_ready)
+        .i_ram_ready(i_ram_ready),
+
+        .o_halted(o_halted),
+        .o_idle(o_idle),
+        .o_retire(o_retire),
+
+        .o_fetch_stall(w_fetch_stall),
+        .o_mem_stall(w_mem_stall),
+        .o_muldiv_stall(w_muldiv_stall)
     );
 
     // outputs to memory
-    assign o_rom_addr  = w_pc;
     assign o_ram_addr  = w_ALUOut;
     assign o_ram_wdata = w_regB;
     assign o_ram_we    = w_ctrl_ram_we;
     assign o_ram_mode  = w_ctrl_ram_mode;
+    assign o_pc        = w_pc;
 
 endmodule
\ No newline at end of file
@@ -0,0 +1,557 @@
+`include "defines.vh"
+
+// Five-stage pipelined RV32I core (IF, ID, EX, MEM, WB), drop-in for cpu_multicycle.
+// Full forwarding into EX, one-cycle load-use interlock, branches and jumps resolved in EX
+// (two-cycle penalty). A low i_rom_ready/i_ram_ready stalls the stages behind it.
+// CSR instructions wait in EX until MEM and WB have drained, so counter reads are exact.
+// RV32M instructions hold EX until the multiply/divide unit is done.
+module cpu_pipelined #(
+    parameter MULDIV_IMPL = 0 // 0 = single cycle, 1 = iterative, 2 = iterative with early termination
+) (
+    input wire clk,
+    input wire rst,
+    input wire [31:0] i_reset_vector, // PC after reset
+
+    // ROM interface
+    output wire [31:0] o_rom_addr,
+    input wire [31:0] i_rom_data,
+    output wire o_rom_req,
+    input wire i_rom_ready,
+
+    // RAM interface
+    output wire [31:0] o_ram_addr,
+    output wire [31:0] o_ram_wdata,
+    input wire [31:0] i_ram_rdata,
+    output wire o_ram_we,
+    output wire [2:0] o_ram_mode,
+    output wire o_ram_req,
+    input wire i_ram_ready,
+
+    // Bus controller waiting on a peripheral (performance counter event)
+    input wire i_bus_stall,
+
+    // Status
+    output wire o_halted,
+    output wire o_retire,   // instruction completes this cycle
+    output wire [31:0] o_pc // PC of the next instruction to retire
+);
+
+    //--------------------------------------------------------------------------
+    // Pipeline control
+    wire w_load_use;   // hold IF/ID, bubble into EX
+    wire w_ex_wait;    // CSR in EX waiting for MEM/WB to drain or RV32M instruction waiting
+                       // for the multiply/divide unit: hold IF..EX, bubble into MEM
+    wire w_mem_wait;   // load/store in MEM waiting for i_ram_ready: hold IF..MEM, bubble into WB
+    wire w_ex_hold  = w_mem_wait || w_ex_wait;
+    wire w_id_hold  = w_ex_hold || w_load_use;
+    wire w_ex_flush;   // taken branch/jump or ECALL leaves EX: squash IF/ID and ID
+    wire w_redirect;   // fetch continues at w_ex_target
+
+    reg  r_stop_fetch; // ECALL/EBREAK passed EX, no more fetches until reset
+    reg  r_halted;
+
+    //--------------------------------------------------------------------------
+    // IF: r_pc_f is the address on the ROM port, a ROM response always belongs to it
+    reg  [31:0] r_pc_f;
+    wire [31:0] w_pc_f_plus_4;
+    wire [31:0] w_ex_target;
+    wire        w_if_fire = i_rom_ready && o_rom_req && !w_redirect && !w_id_hold;
+
+    adder pc_f_adder_inst (
+        .a(r_pc_f),
+        .b(32'd4),
+        .sum(w_pc_f_plus_4)
+    );
+
+    // Move on to PC+4 in the same cycle the instruction is accepted, so a 1-cycle ROM
+    // delivers one instruction per cycle. A dropped response is simply fetched again.
+    assign o_rom_addr = w_redirect ? w_ex_target :
+                        w_if_fire  ? w_pc_f_plus_4 : r_pc_f;
+    assign o_rom_req  = !r_stop_fetch;
+
+    always @(posedge clk or posedge rst) begin
+        if (rst)
+            r_pc_f <= i_reset_vector;
+        else
+            r_pc_f <= o_rom_addr;
+    end
+
+    // IF/ID
+    reg        r_id_valid;
+    reg [31:0] r_id_instr;
+    reg [31:0] r_id_pc;
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            r_id_valid <= 1'b0;
+            r_id_instr <= 32'b0;
+            r_id_pc    <= 32'b0;
+        end else if (w_ex_flush) begin
+            r_id_valid <= 1'b0;
+        end else if (!w_id_hold) begin
+            r_id_valid <= w_if_fire;
+            r_id_instr <= i_rom_data;
+            r_id_pc    <= r_pc_f;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // ID
+    wire [31:0] w_rs1_data;
+    wire [31:0] w_rs2_data;
+    wire [31:0] w_id_rs1_val;
+    wire [31:0] w_id_rs2_val;
+    wire [31:0] w_imm_ext;
+
+    wire [2:0]  w_ctrl_imm;
+    wire [3:0]  w_ctrl_alu;
+    wire        w_ctrl_alu_a_sel;
+    wire        w_ctrl_alu_b_sel;
+    wire [1:0]  w_ctrl_result_sel;
+    wire        w_ctrl_branch;
+    wire        w_ctrl_jal;
+    wire        w_ctrl_jalr;
+    wire        w_ctrl_csr;
+    wire        w_ctrl_csr_we;
+    wire        w_ctrl_halt;
+    wire        w_ctrl_muldiv;
+    wire        w_ctrl_mem_read;
+    wire        w_ctrl_mem_write;
+    wire [2:0]  w_ctrl_ram_mode;
+    wire        w_ctrl_reg_we;
+    wire        w_ctrl_uses_rs1;
+    wire        w_ctrl_uses_rs2;
+
+    // WB write port (driven by MEM/WB)
+    wire [31:0] w_wb_data;
+    wire        w_wb_we;
+    wire [4:0]  w_wb_rd;
+
+    controller_pipelined ctrl_inst (
+        .i_opcode(r_id_instr[6:0]),
+        .i_funct3(r_id_instr[14:12]),
+        .i_funct7(r_id_instr[31:25]),
+        .i_rs1(r_id_instr[19:15]),
+        .o_imm_ctrl(w_ctrl_imm),
+        .o_alu_ctrl(w_ctrl_alu),
+        .o_alu_a_sel(w_ctrl_alu_a_sel),
+        .o_alu_b_sel(w_ctrl_alu_b_sel),
+        .o_result_sel(w_ctrl_result_sel),
+        .o_branch(w_ctrl_branch),
+        .o_jal(w_ctrl_jal),
+        .o_jalr(w_ctrl_jalr),
+        .o_csr(w_ctrl_csr),
+        .o_csr_we(w_ctrl_csr_we),
+        .o_halt(w_ctrl_halt),
+        .o_muldiv(w_ctrl_muldiv),
+        .o_mem_read(w_ctrl_mem_read),
+        .o_mem_write(w_ctrl_mem_write),
+        .o_ram_mode(w_ctrl_ram_mode),
+        .o_reg_we(w_ctrl_reg_we),
+        .o_uses_rs1(w_ctrl_uses_rs1),
+        .o_uses_rs2(w_ctrl_uses_rs2)
+    );
+
+    // Register File instantiation (read in ID, written in WB)
+    register_file regfile_inst (
+        .clk(clk),
+        .rst(rst),
+        .rs1_addr(r_id_instr[19:15]),
+        .rs2_addr(r_id_instr[24:20]),
+        .rd_addr(w_wb_rd),
+        .rd_data(w_wb_data),
+        .rd_we(w_wb_we),
+        .rs1_data(w_rs1_data),
+        .rs2_data(w_rs2_data)
+    );
+
+    // The register file is written at the end of WB, bypass the value being written
+    assign w_id_rs1_val = (w_wb_we && w_wb_rd != 5'b0 && w_wb_rd == r_id_instr[19:15]) ? w_wb_data : w_rs1_data;
+    assign w_id_rs2_val = (w_wb_we && w_wb_rd != 5'b0 && w_wb_rd == r_id_instr[24:20]) ? w_wb_data : w_rs2_data;
+
+    // Immediate Extender instantiation
+    extender imm_ext_inst (
+        .imm_in(r_id_instr),
+        .imm_out(w_imm_ext),
+        .imm_src(w_ctrl_imm)
+    );
+
+    // ID/EX
+    reg        r_ex_valid;
+    reg [31:0] r_ex_instr;
+    reg [31:0] r_ex_pc;
+    reg [31:0] r_ex_rs1_val;
+    reg [31:0] r_ex_rs2_val;
+    reg [31:0] r_ex_imm;
+    reg [3:0]  r_ex_alu_ctrl;
+    reg        r_ex_alu_a_sel;
+    reg        r_ex_alu_b_sel;
+    reg [1:0]  r_ex_result_sel;
+    reg        r_ex_branch;
+    reg        r_ex_jal;
+    reg        r_ex_jalr;
+    reg        r_ex_csr;
+    reg        r_ex_csr_we;
+    reg        r_ex_halt;
+    reg        r_ex_muldiv;
+    reg        r_ex_mem_read;
+    reg        r_ex_mem_write;
+    reg [2:0]  r_ex_ram_mode;
+    reg        r_ex_reg_we;
+
+    wire [31:0] w_ex_a; // forwarded rs1
+    wire [31:0] w_ex_b; // forwarded rs2
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            r_ex_valid <= 1'b0;
+            r_ex_instr <= 32'b0;
+            r_ex_pc <= 32'b0;
+            r_ex_rs1_val <= 32'b0;
+            r_ex_rs2_val <= 32'b0;
+            r_ex_imm <= 32'b0;
+            r_ex_alu_ctrl <= `ALU_ADD;
+            r_ex_alu_a_sel <= 1'b0;
+            r_ex_alu_b_sel <= 1'b0;
+            r_ex_result_sel <= 2'b00;
+            r_ex_branch <= 1'b0;
+            r_ex_jal <= 1'b0;
+            r_ex_jalr <= 1'b0;
+            r_ex_csr <= 1'b0;
+            r_ex_csr_we <= 1'b0;
+            r_ex_halt <= 1'b0;
+            r_ex_muldiv <= 1'b0;
+            r_ex_mem_read <= 1'b0;
+            r_ex_mem_write <= 1'b0;
+            r_ex_ram_mode <= `DM_LW;
+            r_ex_reg_we <= 1'b0;
+        end else if (w_ex_hold) begin
+            // Keep the forwarded operands: their producers may leave WB while EX waits
+            r_ex_rs1_val <= w_ex_a;
+            r_ex_rs2_val <= w_ex_b;
+        end else begin
+            r_ex_valid <= r_id_valid && !w_load_use && !w_ex_flush;
+            r_ex_instr <= r_id_instr;
+            r_ex_pc <= r_id_pc;
+            r_ex_rs1_val <= w_id_rs1_val;
+            r_ex_rs2_val <= w_id_rs2_val;
+            r_ex_imm <= w_imm_ext;
+            r_ex_alu_ctrl <= w_ctrl_alu;
+            r_ex_alu_a_sel <= w_ctrl_alu_a_sel;
+            r_ex_alu_b_sel <= w_ctrl_alu_b_sel;
+            r_ex_result_sel <= w_ctrl_result_sel;
+            r_ex_branch <= w_ctrl_branch;
+            r_ex_jal <= w_ctrl_jal;
+            r_ex_jalr <= w_ctrl_jalr;
+            r_ex_csr <= w_ctrl_csr;
+            r_ex_csr_we <= w_ctrl_csr_we;
+            r_ex_halt <= w_ctrl_halt;
+            r_ex_muldiv <= w_ctrl_muldiv;
+            r_ex_mem_read <= w_ctrl_mem_read;
+            r_ex_mem_write <= w_ctrl_mem_write;
+            r_ex_ram_mode <= w_ctrl_ram_mode;
+            r_ex_reg_we <= w_ctrl_reg_we;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // EX
+    reg        r_mem_valid;
+    reg [4:0]  r_mem_rd;
+    reg        r_mem_reg_we;
+    reg [31:0] r_mem_result;
+
+    reg        r_wb_valid;
+    reg [4:0]  r_wb_rd;
+    reg        r_wb_reg_we;
+
+    wire [1:0]  w_fwd_a_sel;
+    wire [1:0]  w_fwd_b_sel;
+    wire [31:0] w_alu_a;
+    wire [31:0] w_alu_b;
+    wire [31:0] w_alu_result;
+    wire w_zero_flag, w_neg_flag, w_carry_flag;
+    wire [31:0] w_ex_pc_plus_4;
+    wire [31:0] w_ex_pc_branch;
+    wire [31:0] w_ex_result;
+    wire [31:0] w_csr_rdata;
+    wire [31:0] w_csr_wdata;
+    wire [31:0] w_ex_next_pc;
+    wire        w_branch_taken;
+
+    hazard_unit hazard_inst (
+        .id_valid(r_id_valid),
+        .id_rs1(r_id_instr[19:15]),
+        .id_rs2(r_id_instr[24:20]),
+        .id_uses_rs1(w_ctrl_uses_rs1),
+        .id_uses_rs2(w_ctrl_uses_rs2),
+        .ex_valid(r_ex_valid),
+        .ex_rs1(r_ex_instr[19:15]),
+        .ex_rs2(r_ex_instr[24:20]),
+        .ex_rd(r_ex_instr[11:7]),
+        .ex_mem_read(r_ex_mem_read),
+        .mem_valid(r_mem_valid),
+        .mem_rd(r_mem_rd),
+        .mem_reg_we(r_mem_reg_we),
+        .wb_valid(r_wb_valid),
+        .wb_rd(r_wb_rd),
+        .wb_reg_we(r_wb_reg_we),
+        .fwd_a_sel(w_fwd_a_sel),
+        .fwd_b_sel(w_fwd_b_sel),
+        .load_use(w_load_use)
+    );
+
+    // Forwarding muxes
+    mux4 fwd_a_mux_inst (
+        .sel(w_fwd_a_sel),
+        .in0(r_ex_rs1_val),
+        .in1(r_mem_result),
+        .in2(w_wb_data),
+        .in3(32'b0),
+        .out(w_ex_a)
+    );
+
+    mux4 fwd_b_mux_inst (
+        .sel(w_fwd_b_sel),
+        .in0(r_ex_rs2_val),
+        .in1(r_mem_result),
+        .in2(w_wb_data),
+        .in3(32'b0),
+        .out(w_ex_b)
+    );
+
+    // ALU A Mux instantiation
+    mux2 alu_a_mux_inst (
+        .sel(r_ex_alu_a_sel),
+        .in0(w_ex_a),
+        .in1(r_ex_pc),
+        .out(w_alu_a)
+    );
+
+    // ALU B Mux instantiation
+    mux2 alu_b_mux_inst (
+        .sel(r_ex_alu_b_sel),
+        .in0(w_ex_b),
+        .in1(r_ex_imm),
+        .out(w_alu_b)
+    );
+
+    // ALU instantiation
+    alu alu_inst (
+        .a(w_alu_a),
+        .b(w_alu_b),
+        .alu_control(r_ex_alu_ctrl),
+        .alu_result(w_alu_result),
+        .zero(w_zero_flag),
+        .negative(w_neg_flag),
+        .carry(w_carry_flag)
+    );
+
+    adder ex_pc_adder_inst (
+        .a(r_ex_pc),
+        .b(32'd4),
+        .sum(w_ex_pc_plus_4)
+    );
+
+    // Branch Adder instantiation
+    adder branch_adder_inst (
+        .a(r_ex_pc),
+        .b(r_ex_imm),
+        .sum(w_ex_pc_branch)
+    );
+
+    // Branch Comparator instantiation (forwarded operands)
+    branch_comparator branch_cmp_inst (
+        .a(w_ex_a),
+        .b(w_ex_b),
+        .funct3(r_ex_instr[14:12]),
+        .taken(w_branch_taken)
+    );
+
+    // JALR clears bit 0 of the target
+    assign w_ex_target = r_ex_jalr ? {w_alu_result[31:1], 1'b0} : w_ex_pc_branch;
+    assign w_redirect  = r_ex_valid && !w_ex_hold &&
+                         (r_ex_jal || r_ex_jalr || (r_ex_branch && w_branch_taken));
+    assign w_ex_flush  = w_redirect || (r_ex_valid && !w_ex_hold && r_ex_halt);
+
+    // Architectural next PC, reported on o_pc once the instruction retires.
+    // ECALL/EBREAK leave the PC on the instruction, like the multicycle core.
+    assign w_ex_next_pc = w_redirect ? w_ex_target :
+                          r_ex_halt  ? r_ex_pc : w_ex_pc_plus_4;
+
+    // Multiply/divide unit: started once per instruction in EX. r_md_done remembers a result
+    // that arrived while EX was held by MEM, the unit keeps it until the next start.
+    wire [31:0] w_md_result;
+    wire        w_md_done;
+    wire        w_md_busy;
+    reg         r_md_done;
+    wire        w_ex_md = r_ex_valid && r_ex_muldiv;
+    wire        w_md_ready = w_md_done || r_md_done;
+
+    muldiv #(.IMPL(MULDIV_IMPL)) muldiv_inst (
+        .clk(clk),
+        .rst(rst),
+        .start(w_ex_md && !w_md_busy && !r_md_done),
+        .op(r_ex_instr[14:12]),
+        .a(w_ex_a),
+        .b(w_ex_b),
+        .result(w_md_result),
+        .done(w_md_done),
+        .busy(w_md_busy)
+    );
+
+    always @(posedge clk or posedge rst) begin
+        if (rst)
+            r_md_done <= 1'b0;
+        else if (!w_ex_hold)
+            r_md_done <= 1'b0;
+        else if (w_md_done)
+            r_md_done <= 1'b1;
+    end
+
+    // CSR instructions run alone, once everything older has retired
+    assign w_ex_wait = (r_ex_valid && r_ex_csr && (r_mem_valid || r_wb_valid)) ||
+                       (w_ex_md && !w_md_ready);
+
+    // CSR write operand: forwarded rs1 or zero-extended uimm for the immediate forms
+    assign w_csr_wdata = r_ex_instr[14] ? {27'b0, r_ex_instr[19:15]} : w_ex_a;
+
+    // CSR File instantiation
+    csr_file csr_inst (
+        .clk(clk),
+        .rst(rst),
+        .csr_addr(r_ex_instr[31:20]),
+        .csr_op(r_ex_instr[13:12]),
+        .csr_wdata(w_csr_wdata),
+        .csr_we(r_ex_valid && r_ex_csr && r_ex_csr_we && !w_ex_hold),
+        .csr_rdata(w_csr_rdata),
+        .retire(o_retire),
+        .fetch_stall(o_rom_req && !i_rom_ready),
+        .mem_stall(w_mem_wait),
+        .bus_stall(i_bus_stall),
+        .muldiv_stall(w_ex_md && !w_md_ready),
+        .irq_external(1'b0), // no trap support in the pipelined core
+        .irq_timer(1'b0),
+        .trap(1'b0),
+        .trap_pc(32'b0),
+        .mret(1'b0),
+        .irq_pending(),
+        .irq_wake(),
+        .trap_vector(),
+        .epc()
+    );
+
+    // EX result (everything except load data is known at the end of EX)
+    mux4 ex_result_mux_inst (
+        .sel(r_ex_result_sel),
+        .in0(r_ex_muldiv ? w_md_result : w_alu_result),
+        .in1(w_csr_rdata),
+        .in2(w_ex_pc_plus_4),
+        .in3(r_ex_imm),
+        .out(w_ex_result)
+    );
+
+    // EX/MEM
+    reg [31:0] r_mem_wdata;
+    reg [31:0] r_mem_next_pc;
+    reg        r_mem_mem_read;
+    reg        r_mem_mem_write;
+    reg [2:0]  r_mem_ram_mode;
+    reg        r_mem_halt;
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            r_mem_valid <= 1'b0;
+            r_mem_rd <= 5'b0;
+            r_mem_reg_we <= 1'b0;
+            r_mem_result <= 32'b0;
+            r_mem_wdata <= 32'b0;
+            r_mem_next_pc <= 32'b0;
+            r_mem_mem_read <= 1'b0;
+            r_mem_mem_write <= 1'b0;
+            r_mem_ram_mode <= `DM_LW;
+            r_mem_halt <= 1'b0;
+        end else if (!w_mem_wait) begin
+            r_mem_valid <= r_ex_valid && !w_ex_wait;
+            r_mem_rd <= r_ex_instr[11:7];
+            r_mem_reg_we <= r_ex_reg_we;
+            r_mem_result <= w_ex_result;
+            r_mem_wdata <= w_ex_b;
+            r_mem_next_pc <= w_ex_next_pc;
+            r_mem_mem_read <= r_ex_mem_read;
+            r_mem_mem_write <= r_ex_mem_write;
+            r_mem_ram_mode <= r_ex_ram_mode;
+            r_mem_halt <= r_ex_halt;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // MEM: the request is held until i_ram_ready (the bus controller accepts it once)
+    assign o_ram_req   = r_mem_valid && (r_mem_mem_read || r_mem_mem_write);
+    assign o_ram_addr  = r_mem_result;
+    assign o_ram_wdata = r_mem_wdata;
+    assign o_ram_we    = r_mem_mem_write;
+    assign o_ram_mode  = r_mem_ram_mode;
+    assign w_mem_wait  = o_ram_req && !i_ram_ready;
+
+    // MEM/WB
+    reg [31:0] r_wb_result;
+    reg [31:0] r_wb_load_data;
+    reg        r_wb_mem_read;
+    reg [31:0] r_wb_next_pc;
+    reg        r_wb_halt;
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            r_wb_valid <= 1'b0;
+            r_wb_rd <= 5'b0;
+            r_wb_reg_we <= 1'b0;
+            r_wb_result <= 32'b0;
+            r_wb_load_data <= 32'b0;
+            r_wb_mem_read <= 1'b0;
+            r_wb_next_pc <= 32'b0;
+            r_wb_halt <= 1'b0;
+        end else begin
+            r_wb_valid <= r_mem_valid && !w_mem_wait;
+            r_wb_rd <= r_mem_rd;
+            r_wb_reg_we <= r_mem_reg_we;
+            r_wb_result <= r_mem_result;
+            r_wb_load_data <= i_ram_rdata;
+            r_wb_mem_read <= r_mem_mem_read;
+            r_wb_next_pc <= r_mem_next_pc;
+            r_wb_halt <= r_mem_halt;
+        end
+    end
+
+    //--------------------------------------------------------------------------
+    // WB
+    mux2 wb_mux_inst (
+        .sel(r_wb_mem_read),
+        .in0(r_wb_result),
+        .in1(r_wb_load_data),
+        .out(w_wb_data)
+    );
+
+    assign w_wb_we = r_wb_valid && r_wb_reg_we;
+    assign w_wb_rd = r_wb_rd;
+
+    // Retired PC and halt state
+    reg [31:0] r_pc_retired;
+
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            r_pc_retired <= i_reset_vector;
+            r_stop_fetch <= 1'b0;
+            r_halted <= 1'b0;
+        end else begin
+            if (r_wb_valid) r_pc_retired <= r_wb_next_pc;
+            if (r_ex_valid && !w_ex_hold && r_ex_halt) r_stop_fetch <= 1'b1;
+            if (r_wb_valid && r_wb_halt) r_halted <= 1'b1;
+        end
+    end
+
+    assign o_halted = r_halted;
+    assign o_retire = r_wb_valid;
+    assign o_pc     = r_pc_retired;
+
+endmodule
@@ -0,0 +1,180 @@
+`include "defines.vh"
+
+module csr_file (
+    input wire clk,
+    input wire rst,
+
+    // CSR instruction interface
+    input wire [11:0] csr_addr,
+    input wire [1:0] csr_op,       // funct3[1:0]: 01 = RW, 10 = RS, 11 = RC
+    input wire [31:0] csr_wdata,   // rs1 value or zero-extended uimm
+    input wire csr_we,             // write this cycle (read is combinational)
+    output reg [31:0] csr_rdata,
+
+    // Counter events
+    input wire retire,             // instruction retired
+    input wire fetch_stall,        // cycle spent in FETCH_WAIT
+    input wire mem_stall,          // cycle spent in MEMORY_WAIT
+    input wire bus_stall,          // bus controller waiting on a peripheral
+    input wire muldiv_stall,       // waiting for the multiply/divide unit
+
+    // Machine-mode traps (interrupts only, direct mode)
+    input wire irq_external,       // MEIP: level-sensitive interrupt line (UART)
+    input wire irq_timer,          // MTIP: mtime >= mtimecmp (CLINT)
+    input wire trap,               // take the pending interrupt: mepc <= trap_pc
+    input wire [31:0] trap_pc,
+    input wire mret,               // return from the trap handler
+    output wire irq_pending,       // enabled interrupt pending and mstatus.MIE set
+    output wire irq_wake,          // enabled interrupt pending (ends WFI even with MIE clear)
+    output wire [31:0] trap_vector, // mtvec base
+    output wire [31:0] epc         // mepc
+);
+
+    // 64-bit counters
+    reg [63:0] mcycle;
+    reg [63:0] minstret;
+    reg [63:0] mhpmcounter3; // FETCH_WAIT cycles
+    reg [63:0] mhpmcounter4; // MEMORY_WAIT cycles
+    reg [63:0] mhpmcounter5; // bus stall cycles
+    reg [63:0] mhpmcounter6; // multiply/divide wait cycles
+
+    reg [31:0] mscratch;
+
+    // Trap CSRs (mstatus.MPP is hardwired to M)
+    reg mstatus_mie;
+    reg mstatus_mpie;
+    reg [31:0] mie;
+    reg [31:0] mtvec;
+    reg [31:0] mepc;
+    reg [31:0] mcause;
+
+    localparam [31:0] MIE_MASK = (32'b1 << `IRQ_MEI) | (32'b1 << `IRQ_MTI); // implemented interrupt enables
+
+    wire [31:0] mstatus = {19'b0, 2'b11, 3'b0, mstatus_mpie, 3'b0, mstatus_mie, 3'b0};
+    wire [31:0] mip = {20'b0, irq_external, 3'b0, irq_timer, 7'b0};
+    wire [31:0] mip_enabled = mip & mie;
+
+    assign irq_wake = |mip_enabled;
+    assign irq_pending = mstatus_mie && irq_wake;
+    assign trap_vector = mtvec;
+    assign epc = mepc;
+
+    reg [31:0] csr_new;
+
+    // Read mux
+    always @(*) begin
+        case (csr_addr)
+            `CSR_MISA:           csr_rdata = 32'h4000_1100; // RV32IM
+            `CSR_MHARTID:        csr_rdata = 32'b0;
+            `CSR_MSCRATCH:       csr_rdata = mscratch;
+            `CSR_MSTATUS:        csr_rdata = mstatus;
+            `CSR_MIE:            csr_rdata = mie;
+            `CSR_MTVEC:          csr_rdata = mtvec;
+            `CSR_MEPC:           csr_rdata = mepc;
+            `CSR_MCAUSE:         csr_rdata = mcause;
+            `CSR_MIP:            csr_rdata = mip;
+            `CSR_MCYCLE,
+            `CSR_CYCLE:          csr_rdata = mcycle[31:0];
+            `CSR_MCYCLEH,
+            `CSR_CYCLEH:         csr_rdata = mcycle[63:32];
+            `CSR_MINSTRET,
+            `CSR_INSTRET:        csr_rdata = minstret[31:0];
+            `CSR_MINSTRETH,
+            `CSR_INSTRETH:       csr_rdata = minstret[63:32];
+            `CSR_MHPMCOUNTER3,
+            `CSR_HPMCOUNTER3:    csr_rdata = mhpmcounter3[31:0];
+            `CSR_MHPMCOUNTER3H,
+            `CSR_HPMCOUNTER3H:   csr_rdata = mhpmcounter3[63:32];
+            `CSR_MHPMCOUNTER4,
+            `CSR_HPMCOUNTER4:    csr_rdata = mhpmcounter4[31:0];
+            `CSR_MHPMCOUNTER4H,
+            `CSR_HPMCOUNTER4H:   csr_rdata = mhpmcounter4[63:32];
+            `CSR_MHPMCOUNTER5,
+            `CSR_HPMCOUNTER5:    csr_rdata = mhpmcounter5[31:0];
+            `CSR_MHPMCOUNTER5H,
+            `CSR_HPMCOUNTER5H:   csr_rdata = mhpmcounter5[63:32];
+            `CSR_MHPMCOUNTER6,
+            `CSR_HPMCOUNTER6:    csr_rdata = mhpmcounter6[31:0];
+            `CSR_MHPMCOUNTER6H,
+            `CSR_HPMCOUNTER6H:   csr_rdata = mhpmcounter6[63:32];
+            default:             csr_rdata = 32'b0; // unimplemented CSRs read as zero
+        endcase
+    end
+
+    // Value written by CSRRW/CSRRS/CSRRC
+    always @(*) begin
+        case (csr_op)
+            2'b01:   csr_new = csr_wdata;
+            2'b10:   csr_new = csr_rdata | csr_wdata;
+            2'b11:   csr_new = csr_rdata & ~csr_wdata;
+            default: csr_new = csr_rdata;
+        endcase
+    end
+
+    // Counters: a CSR write wins over the increment in the same cycle.
+    // The user-level shadows (cycle, instret, hpmcounterN) are read-only.
+    always @(posedge clk or posedge rst) begin
+        if (rst) begin
+            mcycle <= 64'b0;
+            minstret <= 64'b0;
+            mhpmcounter3 <= 64'b0;
+            mhpmcounter4 <= 64'b0;
+            mhpmcounter5 <= 64'b0;
+            mhpmcounter6 <= 64'b0;
+            mscratch <= 32'b0;
+            mstatus_mie <= 1'b0;
+            mstatus_mpie <= 1'b0;
+            mie <= 32'b0;
+            mtvec <= 32'b0;
+            mepc <= 32'b0;
+            mcause <= 32'b0;
+        end else begin
+            mcycle <= mcycle + 1;
+            if (retire) minstret <= minstret + 1;
+            if (fetch_stall) mhpmcounter3 <= mhpmcounter3 + 1;
+            if (mem_stall) mhpmcounter4 <= mhpmcounter4 + 1;
+            if (bus_stall) mhpmcounter5 <= mhpmcounter5 + 1;
+            if (muldiv_stall) mhpmcounter6 <= mhpmcounter6 + 1;
+
+            if (csr_we) begin
+                case (csr_addr)
+                    `CSR_MSCRATCH:      mscratch <= csr_new;
+                    `CSR_MSTATUS: begin
+                        mstatus_mie  <= csr_new[3];
+                        mstatus_mpie <= csr_new[7];
+                    end
+                    `CSR_MIE:           mie <= csr_new & MIE_MASK;
+                    `CSR_MTVEC:         mtvec <= {csr_new[31:2], 2'b00}; // direct mode only
+                    `CSR_MEPC:          mepc <= {csr_new[31:2], 2'b00};
+                    `CSR_MCAUSE:        mcause <= csr_new;
+                    `CSR_MCYCLE:        mcycle[31:0] <= csr_new;
+                    `CSR_MCYCLEH:       mcycle[63:32] <= csr_new;
+                    `CSR_MINSTRET:      minstret[31:0] <= csr_new;
+                    `CSR_MINSTRETH:     minstret[63:32] <= csr_new;
+                    `CSR_MHPMCOUNTER3:  mhpmcounter3[31:0] <= csr_new;
+                    `CSR_MHPMCOUNTER3H: mhpmcounter3[63:32] <= csr_new;
+                    `CSR_MHPMCOUNTER4:  mhpmcounter4[31:0] <= csr_new;
+                    `CSR_MHPMCOUNTER4H: mhpmcounter4[63:32] <= csr_new;
+                    `CSR_MHPMCOUNTER5:  mhpmcounter5[31:0] <= csr_new;
+                    `CSR_MHPMCOUNTER5H: mhpmcounter5[63:32] <= csr_new;
+                    `CSR_MHPMCOUNTER6:  mhpmcounter6[31:0] <= csr_new;
+                    `CSR_MHPMCOUNTER6H: mhpmcounter6[63:32] <= csr_new;
+                    default: ; // read-only or unimplemented
+                endcase
+            end
+
+            // Trap entry and return (never in the same cycle as a CSR write)
+            if (trap) begin
+                mepc <= trap_pc;
+                // External interrupts have priority over the timer
+                mcause <= {1'b1, 26'b0, mip_enabled[`IRQ_MEI] ? 5'd`IRQ_MEI : 5'd`IRQ_MTI};
+                mstatus_mpie <= mstatus_mie;
+                mstatus_mie <= 1'b0;
+            end else if (mret) begin
+                mstatus_mie <= mstatus_mpie;
+                mstatus_mpie <= 1'b1;
+            end
+        end
+    end
+
+endmodule
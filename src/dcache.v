@@ -0,0 +1,271 @@
+`include "defines.vh"
+
+// Set-associative write-back, write-allocate data cache between the bus controller and dmem_sync.
+// CPU side uses the dmem_sync handshake (RAM offsets, DM_* modes); a hit is answered the cycle
+// after the request. A miss writes the dirty victim line back and refills the line, both as
+// word bursts. flush writes all dirty lines back and invalidates the cache, invalidate drops
+// everything (dirty data is lost); busy stays high until they are done.
+// SIZE and LINE_SIZE are in bytes; SIZE, LINE_SIZE (>= 8) and WAYS must be powers of two.
+// MEM_WIDTH is the RAM data path (32, 64 or 128 bits, at most one line per beat).
+module dcache #(
+    parameter SIZE      = 1024,
+    parameter LINE_SIZE = 16,
+    parameter WAYS      = 2,
+    parameter MEM_WIDTH = 32
+) (
+    input wire clk,
+    input wire rst,
+
+    // CPU side (from the bus controller)
+    input wire [31:0] address,
+    input wire [31:0] write_data,
+    output reg [31:0] read_data,
+    input wire we,
+    input wire [2:0] mode,
+    input wire req,
+    output reg ready,
+
+    // Backing RAM side (line bursts)
+    output reg [31:0] mem_address,
+    output reg [MEM_WIDTH-1:0] mem_write_data,
+    input wire [MEM_WIDTH-1:0] mem_read_data,
+    output wire mem_we,
+    output wire [2:0] mem_mode,
+    output wire mem_req,
+    input wire mem_ready,
+    output wire [7:0] mem_burst_len,
+
+    // Maintenance
+    input wire flush,
+    input wire invalidate,
+    output wire busy,
+
+    // Statistics: requests answered without a refill, and line refills
+    output reg [31:0] hits,
+    output reg [31:0] misses
+);
+
+    localparam WORDS       = LINE_SIZE / 4;
+    localparam SETS        = SIZE / (LINE_SIZE * WAYS);
+    localparam OFFSET_BITS = $clog2(LINE_SIZE);
+    localparam SET_SHIFT   = $clog2(SETS);
+    localparam SET_BITS    = (SETS > 1) ? $clog2(SETS) : 1;
+    localparam WAY_BITS    = (WAYS > 1) ? $clog2(WAYS) : 1;
+    localparam WORD_BITS   = $clog2(WORDS);
+    localparam LINES       = 1 << (SET_BITS + WAY_BITS);
+
+    localparam BEAT_WORDS  = MEM_WIDTH / 32;
+    localparam BEAT_SHIFT  = $clog2(BEAT_WORDS);
+    localparam BEATS       = WORDS / BEAT_WORDS;
+
+    localparam [WORD_BITS-1:0] LAST_BEAT = BEATS - 1;
+    localparam [7:0]           BURST_LEN = BEATS - 1;
+    localparam [SET_BITS+WAY_BITS-1:0] LAST_LINE = LINES - 1;
+
+    localparam IDLE = 2'b00, WRITEBACK = 2'b01, REFILL = 2'b10, FLUSH = 2'b11;
+
+    // Storage, indexed by {set, way} (tags/valid/dirty) and {set, way, word} (data)
+    reg [31:0] tag_mem [0:LINES-1];
+    reg [LINES-1:0] valid;
+    reg [LINES-1:0] dirty;
+    reg [31:0] data_mem [0:LINES*WORDS-1];
+    reg [WAY_BITS-1:0] victim [0:(1 << SET_BITS)-1]; // Round-robin replacement per set
+
+    // Address split
+    wire [31:0] w_line_addr = address >> OFFSET_BITS;
+    wire [SET_BITS-1:0] w_set = (SETS > 1) ? w_line_addr[SET_BITS-1:0] : {SET_BITS{1'b0}};
+    wire [31:0] w_tag = address >> (OFFSET_BITS + SET_SHIFT);
+    wire [WORD_BITS-1:0] w_word = address[OFFSET_BITS-1:2];
+    wire [1:0] w_byte = address[1:0];
+
+    // Tag compare
+    reg w_hit;
+    reg [WAY_BITS-1:0] w_hit_way;
+    always @(*) begin
+        integer i;
+        w_hit     = 1'b0;
+        w_hit_way = {WAY_BITS{1'b0}};
+        for (i = 0; i < WAYS; i = i + 1) begin
+            if (valid[{w_set, i[WAY_BITS-1:0]}] && tag_mem[{w_set, i[WAY_BITS-1:0]}] == w_tag) begin
+                w_hit     = 1'b1;
+                w_hit_way = i[WAY_BITS-1:0];
+            end
+        end
+    end
+
+    wire [31:0] w_hit_word = data_mem[{w_set, w_hit_way, w_word}];
+    wire [WAY_BITS-1:0] w_victim = victim[w_set];
+
+    // Load data for the DM_* mode (same extension rules as dmem_sync)
+    reg [31:0] w_load_data;
+    always @(*) begin
+        case (mode)
+            `DM_LB:  w_load_data = {{24{w_hit_word[{w_byte, 3'b111}]}}, w_hit_word[{w_byte, 3'b000} +: 8]};
+            `DM_LBU: w_load_data = {24'b0, w_hit_word[{w_byte, 3'b000} +: 8]};
+            `DM_LH:  w_load_data = {{16{w_hit_word[{w_byte[1], 4'b1111}]}}, w_hit_word[{w_byte[1], 4'b0000} +: 16]};
+            `DM_LHU: w_load_data = {16'b0, w_hit_word[{w_byte[1], 4'b0000} +: 16]};
+            default: w_load_data = w_hit_word;
+        endcase
+    end
+
+    // Hit word with the store merged in
+    reg [31:0] w_store_word;
+    always @(*) begin
+        w_store_word = w_hit_word;
+        case (mode)
+            `DM_SB:  w_store_word[{w_byte, 3'b000} +: 8]     = write_data[7:0];
+            `DM_SH:  w_store_word[{w_byte[1], 4'b0000} +: 16] = write_data[15:0];
+            default: w_store_word = write_data;
+        endcase
+    end
+
+    // Line being written back or refilled
+    reg [1:0] state;
+    reg refilled;       // Next answer completes a miss (not counted as a hit)
+    reg flush_pending;
+    reg flushing;       // Write-backs return to the FLUSH walk instead of refilling
+    reg [SET_BITS-1:0] line_set;
+    reg [WAY_BITS-1:0] line_way;
+    reg [31:0] line_tag;       // Tag of the line being refilled
+    reg [31:0] refill_address; // Base address of the line being refilled
+    reg [WORD_BITS-1:0] beat;
+    reg [SET_BITS+WAY_BITS-1:0] flush_index;
+
+    wire w_last_beat = mem_ready && (beat == LAST_BEAT);
+
+    // Write-back data runs one beat ahead once the first beat is accepted
+    wire [WORD_BITS-1:0] w_wb_beat = mem_ready ? beat + 1'b1 : beat;
+
+    always @(*) begin
+        integer i;
+        for (i = 0; i < BEAT_WORDS; i = i + 1)
+            mem_write_data[32*i +: 32] = data_mem[{line_set, line_way, (w_wb_beat << BEAT_SHIFT) + i[WORD_BITS-1:0]}];
+    end
+    assign mem_we         = (state == WRITEBACK);
+    assign mem_mode       = (state == WRITEBACK) ? `DM_SW : `DM_LW;
+    assign mem_req        = (state == WRITEBACK || state == REFILL) && !w_last_beat;
+    assign mem_burst_len  = BURST_LEN;
+
+    assign busy = (state != IDLE) || flush_pending;
+
+    // Base address of a cached line
+    function [31:0] line_base(input [31:0] tag, input [SET_BITS-1:0] set);
+        line_base = (tag << (OFFSET_BITS + SET_SHIFT)) | ({{(32-SET_BITS){1'b0}}, set} << OFFSET_BITS);
+    endfunction
+
+    always @(posedge clk) begin
+        integer i;
+        ready <= 1'b0;
+
+        if (rst || invalidate) begin
+            read_data     <= 32'b0;
+            valid         <= '0;
+            dirty         <= '0;
+            state         <= IDLE;
+            refilled      <= 1'b0;
+            flush_pending <= 1'b0;
+            flushing      <= 1'b0;
+            beat          <= '0;
+            if (rst) begin
+                hits   <= 32'b0;
+                misses <= 32'b0;
+                for (i = 0; i < (1 << SET_BITS); i = i + 1)
+                    victim[i] <= '0;
+            end
+        end else begin
+            if (flush)
+                flush_pending <= 1'b1;
+
+            case (state)
+                IDLE: begin
+                    if (flush_pending) begin
+                        state         <= FLUSH;
+                        flushing      <= 1'b1;
+                        flush_index   <= '0;
+                        flush_pending <= 1'b0;
+                    end else if (req && !ready) begin
+                        if (w_hit) begin
+                            ready    <= 1'b1;
+                            refilled <= 1'b0;
+                            if (!refilled)
+                                hits <= hits + 1;
+                            if (we) begin
+                                data_mem[{w_set, w_hit_way, w_word}] <= w_store_word;
+                                dirty[{w_set, w_hit_way}] <= 1'b1;
+                            end else begin
+                                read_data <= w_load_data;
+                            end
+                        end else begin
+                            // Miss: write the victim back if it is dirty, then refill
+                            misses         <= misses + 1;
+                            line_set       <= w_set;
+                            line_way       <= w_victim;
+                            line_tag       <= w_tag;
+                            refill_address <= {address[31:OFFSET_BITS], {OFFSET_BITS{1'b0}}};
+                            beat           <= '0;
+                            if (valid[{w_set, w_victim}] && dirty[{w_set, w_victim}]) begin
+                                state       <= WRITEBACK;
+                                mem_address <= line_base(tag_mem[{w_set, w_victim}], w_set);
+                            end else begin
+                                state       <= REFILL;
+                                mem_address <= {address[31:OFFSET_BITS], {OFFSET_BITS{1'b0}}};
+                            end
+                            valid[{w_set, w_victim}] <= 1'b0;
+                        end
+                    end
+                end
+
+                WRITEBACK: begin
+                    if (mem_ready) begin
+                        beat <= beat + 1;
+                        if (w_last_beat) begin
+                            dirty[{line_set, line_way}] <= 1'b0;
+                            if (flushing) begin
+                                state <= FLUSH;
+                            end else begin
+                                state       <= REFILL;
+                                mem_address <= refill_address;
+                            end
+                        end
+                    end
+                end
+
+                REFILL: begin
+                    if (mem_ready) begin
+                        for (i = 0; i < BEAT_WORDS; i = i + 1)
+                            data_mem[{line_set, line_way, (beat << BEAT_SHIFT) + i[WORD_BITS-1:0]}] <= mem_read_data[32*i +: 32];
+                        beat <= beat + 1;
+                        if (w_last_beat) begin
+                            valid[{line_set, line_way}]   <= 1'b1;
+                            tag_mem[{line_set, line_way}] <= line_tag;
+                            victim[line_set] <= line_way + 1;
+                            refilled <= 1'b1;
+                            state    <= IDLE;
+                        end
+                    end
+                end
+
+                FLUSH: begin
+                    // Walk all lines, writing back the dirty ones
+                    if (valid[flush_index] && dirty[flush_index]) begin
+                        {line_set, line_way} <= flush_index;
+                        mem_address <= line_base(tag_mem[flush_index], flush_index[SET_BITS+WAY_BITS-1:WAY_BITS]);
+                        beat        <= '0;
+                        state       <= WRITEBACK;
+                    end else begin
+                        valid[flush_index] <= 1'b0;
+                        flush_index <= flush_index + 1;
+                        if (flush_index == LAST_LINE) begin
+                            state    <= IDLE;
+                            flushing <= 1'b0;
+                            refilled <= 1'b0;
+                        end
+                    end
+                end
+
+                default: state <= IDLE;
+            endcase
+        end
+    end
+
+endmodule
@@ -29,9 +29,59 @@
 `define DM_SW 3'b111
 
 // Memory map
-// RAM: 4KB 32-bit words: 0x0000_0000 - 0x0000_0FFF
+// RAM: RAM_SIZE bytes (soc_multicycle parameter, default 4KB) from 0x0000_0000, at most 32MB
 `define RAM_BASE 32'h0000_0000
-`define RAM_TOP  32'h0000_0FFF
 // UART: 0x1000_0000 - 0x1000_00FF
 `define UART_BASE 32'h1000_0000
-`define UART_TOP  32'h1000_00FF
\ No newline at end of file
+`define UART_TOP  32'h1000_00FF
+// DMA: 0x1000_0100 - 0x1000_01FF
+`define DMA_BASE 32'h1000_0100
+`define DMA_TOP  32'h1000_01FF
+// CLINT timer (mtime/mtimecmp): 0x0200_0000 - 0x0200_FFFF
+`define CLINT_BASE 32'h0200_0000
+`define CLINT_TOP  32'h0200_FFFF
+// TOHOST: 0x1000_1000 - 0x1000_10FF (any write ends the simulation, except to TRACE_CTRL)
+`define TOHOST_BASE 32'h1000_1000
+`define TOHOST_TOP  32'h1000_10FF
+// Offset of TRACE_CTRL in the TOHOST range: bit 0 asks the testbench to record waveforms
+`define TRACE_CTRL_OFFSET 8'h80
+
+// CSR addresses (Zicsr/Zicntr, machine-mode traps)
+`define CSR_MSTATUS       12'h300
+`define CSR_MISA          12'h301
+`define CSR_MIE           12'h304
+`define CSR_MTVEC         12'h305
+`define CSR_MSCRATCH      12'h340
+`define CSR_MEPC          12'h341
+`define CSR_MCAUSE        12'h342
+`define CSR_MTVAL         12'h343
+`define CSR_MIP           12'h344
+`define CSR_MCYCLE        12'hB00
+`define CSR_MINSTRET      12'hB02
+`define CSR_MHPMCOUNTER3  12'hB03 // FETCH_WAIT cycles
+`define CSR_MHPMCOUNTER4  12'hB04 // MEMORY_WAIT cycles
+`define CSR_MHPMCOUNTER5  12'hB05 // bus stall cycles
+`define CSR_MHPMCOUNTER6  12'hB06 // multiply/divide wait cycles
+`define CSR_MCYCLEH       12'hB80
+`define CSR_MINSTRETH     12'hB82
+`define CSR_MHPMCOUNTER3H 12'hB83
+`define CSR_MHPMCOUNTER4H 12'hB84
+`define CSR_MHPMCOUNTER5H 12'hB85
+`define CSR_MHPMCOUNTER6H 12'hB86
+`define CSR_CYCLE         12'hC00
+`define CSR_INSTRET       12'hC02
+`define CSR_HPMCOUNTER3   12'hC03
+`define CSR_HPMCOUNTER4   12'hC04
+`define CSR_HPMCOUNTER5   12'hC05
+`define CSR_HPMCOUNTER6   12'hC06
+`define CSR_CYCLEH        12'hC80
+`define CSR_INSTRETH      12'hC82
+`define CSR_HPMCOUNTER3H  12'hC83
+`define CSR_HPMCOUNTER4H  12'hC84
+`define CSR_HPMCOUNTER5H  12'hC85
+`define CSR_HPMCOUNTER6H  12'hC86
+`define CSR_MHARTID       12'hF14
+
+// Interrupt bits in mie/mip and their mcause codes
+`define IRQ_MTI 7  // machine timer interrupt (CLINT)
+`define IRQ_MEI 11 // machine external interrupt (UART)
@@ -0,0 +1,287 @@
+`include "defines.vh"
+
+// DMA engine. Copies RAM to RAM, fills RAM with a word pattern or sends RAM bytes to the
+// UART TX FIFO, following a chain of descriptors. Transfers are split into bursts of up to
+// BURST elements: reads fill a small buffer, then the writes drain it. The master port is a
+// second master on the bus controller; a request is taken in the cycle m_grant is high and
+// read data comes back in order on m_rvalid, so back-to-back requests need no bubbles.
+module dma #(
+    parameter BURST = 4,     // elements per burst, power of two (>= 2)
+    parameter RAM_SIZE = 4096 // bytes of RAM from RAM_BASE, transfers must stay inside
+) (
+    input wire clk,
+    input wire rst,
+
+    // Register interface (decoded address)
+    input wire [31:0] address,
+    input wire [31:0] write_data,
+    output reg [31:0] read_data,
+    input wire we,
+    input wire [2:0] mode,
+    input wire req,
+    output reg ready,
+
+    // Master interface
+    output reg [31:0] m_address,
+    output reg [31:0] m_write_data,
+    output reg m_we,
+    output reg [2:0] m_mode,
+    output reg m_req,
+    input wire m_grant,
+    input wire [31:0] m_read_data,
+    input wire m_rvalid,
+
+    // UART TX FIFO has room (flow control for MODE_UART)
+    input wire uart_tx_ready,
+
+    output wire busy
+);
+    localparam SRC_REG_ADDR = 32'h0000_0000;
+    localparam DST_REG_ADDR = 32'h0000_0004;
+    localparam LEN_REG_ADDR = 32'h0000_0008;
+    localparam NEXT_REG_ADDR = 32'h0000_000C;
+    localparam CTRL_REG_ADDR = 32'h0000_0010;
+    localparam STATUS_REG_ADDR = 32'h0000_0014;
+
+    localparam MODE_COPY = 2'd0;
+    localparam MODE_FILL = 2'd1; // SRC holds the pattern
+    localparam MODE_UART = 2'd2; // DST is ignored, bytes go to the UART TX register
+
+    localparam S_IDLE  = 3'd0;
+    localparam S_DESC  = 3'd1; // fetching a descriptor from RAM
+    localparam S_CHECK = 3'd2; // validating the descriptor
+    localparam S_READ  = 3'd3;
+    localparam S_WRITE = 3'd4;
+
+    localparam [7:0] DESC_WORDS = 8'd5; // SRC, DST, LEN, NEXT, CTRL
+    localparam [7:0] BURST_LEN = BURST;
+    localparam IDX_BITS = $clog2(BURST);
+
+    // Descriptor registers
+    reg [31:0] src;
+    reg [31:0] dst;
+    reg [31:0] len;
+    reg [31:0] next;
+    reg [1:0] ctrl_mode;
+
+    reg [2:0] state;
+    reg done;  // chain finished
+    reg error; // descriptor misaligned, outside RAM or unknown mode, the chain stopped
+
+    reg [31:0] desc_address;
+    reg [31:0] count; // elements left in the current descriptor
+    reg [31:0] burst_buffer [0:BURST-1];
+    reg [7:0] burst_n;   // elements in the current burst
+    reg [7:0] issue_idx; // requests granted in the current burst/descriptor fetch
+    reg [7:0] recv_idx;  // read data received
+
+    // Status register: bit 0 busy, bit 1 done, bit 2 error
+    wire [31:0] status_reg = {29'b0, error, done, busy};
+
+    // Descriptor checks: word modes need aligned addresses and a LEN of whole words (the
+    // engine moves words, a partial last word would be dropped), every range must lie in RAM
+    // and so must the next descriptor, word aligned
+    wire [32:0] w_src_end = {1'b0, src} + {1'b0, len};
+    wire [32:0] w_dst_end = {1'b0, dst} + {1'b0, len};
+    localparam [32:0] RAM_END = `RAM_BASE + RAM_SIZE;
+    wire w_src_ok = w_src_end <= RAM_END;
+    wire w_dst_ok = w_dst_end <= RAM_END;
+    wire w_next_ok = {1'b0, next} + {26'b0, DESC_WORDS, 2'b00} <= RAM_END && next[1:0] == 2'b0;
+    reg w_desc_ok;
+    always @(*) begin
+        case (ctrl_mode)
+            MODE_COPY: w_desc_ok = w_src_ok && w_dst_ok && src[1:0] == 2'b0 && dst[1:0] == 2'b0 && len[1:0] == 2'b0;
+            MODE_FILL: w_desc_ok = w_dst_ok && dst[1:0] == 2'b0 && len[1:0] == 2'b0;
+            MODE_UART: w_desc_ok = w_src_ok;
+            default:   w_desc_ok = 1'b0;
+        endcase
+    end
+
+    wire [31:0] w_count = (ctrl_mode == MODE_UART) ? len : {2'b0, len[31:2]};
+
+    // Master request
+    always @(*) begin
+        m_address    = src;
+        m_write_data = 32'b0;
+        m_we         = 1'b0;
+        m_mode       = `DM_LW;
+        m_req        = 1'b0;
+
+        case (state)
+            S_DESC: begin
+                m_address = desc_address + {22'b0, issue_idx, 2'b00};
+                m_req     = issue_idx < DESC_WORDS;
+            end
+            S_READ: begin
+                m_mode = (ctrl_mode == MODE_UART) ? `DM_LBU : `DM_LW;
+                m_req  = issue_idx < burst_n;
+            end
+            S_WRITE: begin
+                m_we = 1'b1;
+                if (ctrl_mode == MODE_UART) begin
+                    m_address    = `UART_BASE;
+                    m_write_data = burst_buffer[issue_idx[IDX_BITS-1:0]];
+                    m_mode       = `DM_SB;
+                    m_req        = issue_idx < burst_n && uart_tx_ready;
+                end else begin
+                    m_address    = dst;
+                    m_write_data = (ctrl_mode == MODE_FILL) ? src : burst_buffer[issue_idx[IDX_BITS-1:0]];
+                    m_mode       = `DM_SW;
+                    m_req        = issue_idx < burst_n;
+                end
+            end
+            default: ;
+        endcase
+    end
+
+    // Next descriptor of the chain, or done
+    task finish_descriptor;
+        begin
+            if (next != 32'b0 && !w_next_ok) begin
+                error <= 1'b1;
+                state <= S_IDLE;
+            end else if (next != 32'b0) begin
+                desc_address <= next;
+                issue_idx    <= 8'b0;
+                recv_idx     <= 8'b0;
+                state        <= S_DESC;
+            end else begin
+                done  <= 1'b1;
+                state <= S_IDLE;
+            end
+        end
+    endtask
+
+    always @(posedge clk) begin
+        if (rst) begin
+            ready <= 1'b0;
+            read_data <= 32'b0;
+
+            src <= 32'b0;
+            dst <= 32'b0;
+            len <= 32'b0;
+            next <= 32'b0;
+            ctrl_mode <= MODE_COPY;
+
+            state <= S_IDLE;
+            done <= 1'b0;
+            error <= 1'b0;
+
+            desc_address <= 32'b0;
+            count <= 32'b0;
+            burst_n <= 8'b0;
+            issue_idx <= 8'b0;
+            recv_idx <= 8'b0;
+        end else begin
+            ready <= 1'b0;
+
+            // Register interface, descriptor registers are read-only while busy
+            if (req) begin
+                ready <= 1'b1;
+
+                if (!we) begin
+                    case (address)
+                        SRC_REG_ADDR:    read_data <= src;
+                        DST_REG_ADDR:    read_data <= dst;
+                        LEN_REG_ADDR:    read_data <= len;
+                        NEXT_REG_ADDR:   read_data <= next;
+                        CTRL_REG_ADDR:   read_data <= {30'b0, ctrl_mode};
+                        STATUS_REG_ADDR: read_data <= status_reg;
+                        default:         read_data <= 32'b0;
+                    endcase
+                end else if (state == S_IDLE) begin
+                    case (address)
+                        SRC_REG_ADDR:  src <= write_data;
+                        DST_REG_ADDR:  dst <= write_data;
+                        LEN_REG_ADDR:  len <= write_data;
+                        NEXT_REG_ADDR: next <= write_data;
+                        CTRL_REG_ADDR: begin
+                            ctrl_mode <= write_data[1:0];
+                            if (write_data[31]) begin
+                                // Start with the descriptor held in the registers
+                                done  <= 1'b0;
+                                error <= 1'b0;
+                                state <= S_CHECK;
+                            end
+                        end
+                        default: ;
+                    endcase
+                end
+            end
+
+            // Transfer engine
+            case (state)
+                S_DESC: begin
+                    if (m_req && m_grant)
+                        issue_idx <= issue_idx + 8'd1;
+
+                    if (m_rvalid) begin
+                        case (recv_idx)
+                            8'd0: src  <= m_read_data;
+                            8'd1: dst  <= m_read_data;
+                            8'd2: len  <= m_read_data;
+                            8'd3: next <= m_read_data;
+                            default: ctrl_mode <= m_read_data[1:0];
+                        endcase
+                        recv_idx <= recv_idx + 8'd1;
+                        if (recv_idx == DESC_WORDS - 8'd1)
+                            state <= S_CHECK;
+                    end
+                end
+                S_CHECK: begin
+                    issue_idx <= 8'b0;
+                    recv_idx  <= 8'b0;
+                    count     <= w_count;
+                    burst_n   <= (w_count > {24'b0, BURST_LEN}) ? BURST_LEN : w_count[7:0];
+
+                    if (!w_desc_ok) begin
+                        error <= 1'b1;
+                        state <= S_IDLE;
+                    end else if (w_count == 32'b0) begin
+                        finish_descriptor;
+                    end else begin
+                        state <= (ctrl_mode == MODE_FILL) ? S_WRITE : S_READ;
+                    end
+                end
+                S_READ: begin
+                    if (m_req && m_grant) begin
+                        issue_idx <= issue_idx + 8'd1;
+                        src <= src + ((ctrl_mode == MODE_UART) ? 32'd1 : 32'd4);
+                    end
+
+                    if (m_rvalid) begin
+                        burst_buffer[recv_idx[IDX_BITS-1:0]] <= m_read_data;
+                        recv_idx <= recv_idx + 8'd1;
+                        if (recv_idx == burst_n - 8'd1) begin
+                            issue_idx <= 8'b0;
+                            state     <= S_WRITE;
+                        end
+                    end
+                end
+                S_WRITE: begin
+                    if (m_req && m_grant) begin
+                        issue_idx <= issue_idx + 8'd1;
+                        count <= count - 32'd1;
+                        if (ctrl_mode != MODE_UART)
+                            dst <= dst + 32'd4;
+
+                        if (issue_idx == burst_n - 8'd1) begin
+                            // Burst done: start the next one or move on in the chain
+                            issue_idx <= 8'b0;
+                            recv_idx  <= 8'b0;
+                            burst_n   <= (count - 32'd1 > {24'b0, BURST_LEN}) ? BURST_LEN : count[7:0] - 8'd1;
+                            if (count == 32'd1)
+                                finish_descriptor;
+                            else if (ctrl_mode != MODE_FILL)
+                                state <= S_READ;
+                        end
+                    end
+                end
+                default: ;
+            endcase
+        end
+    end
+
+    assign busy = (state != S_IDLE);
+
+endmodule
@@ -1,111 +1,167 @@
 `include "defines.vh"
+`include "sparse_mem.vh"
+`include "latency_jitter.vh"
 
 module dmem_sync #(
-    parameter LATENCY = 1 // 1 = default (ready next cycle)
+    parameter LATENCY = 1,     // 1 = default (ready next cycle)
+    parameter DATA_WIDTH = 32, // 32, 64 or 128: wider data paths only transfer whole beats
+    parameter SIZE = 4096,     // bytes, power of two (addresses wrap)
+    parameter SPARSE = 0       // 1 = words live in the harness's sparse memory (DPI)
 ) (
     input wire clk,
     input wire rst,
-    
+
+    input wire [63:0] store,  // harness memory handle for SPARSE, unused otherwise
+
+    // Runtime latency (testbench): cycles to the first beat, 0 = LATENCY. `jitter` is the
+    // harness's LatencyInjector handle adding random cycles to each request (0 = none).
+    input wire [7:0] latency,
+    input wire [63:0] jitter,
+
     input wire [31:0] address,
-    input wire [31:0] write_data,
-    output reg  [31:0] read_data,
+    input wire [DATA_WIDTH-1:0] write_data,
+    output reg  [DATA_WIDTH-1:0] read_data,
     input wire we,
     input wire [2:0] mode,
     input wire req,
-    output reg ready
+    output reg ready,
+
+    // Burst: beats after the first (0 = single access). Later beats access the following
+    // words on consecutive cycles while req is held (use DM_LW/DM_SW)
+    input wire [7:0] burst_len
 );
 
-    // 32 bit wide RAM with 1024 words (4KB)
-    reg [31:0] ram_mem [0:1023];
+    localparam BEAT_WORDS = DATA_WIDTH / 32;
+    localparam BEAT_SHIFT = $clog2(BEAT_WORDS);
+    localparam WORDS = SIZE / 4;
+    localparam AW = $clog2(WORDS);
+    localparam [AW-1:0] BEAT_MASK = ~(BEAT_WORDS - 1); // Wide beats are aligned to their size
+
+    // 32 bit wide RAM, a single dummy word when SPARSE
+    reg [31:0] ram_mem [0:(SPARSE ? 0 : WORDS-1)];
 
 
     wire [1:0] byte_offset;  // Byte offset within the word
-    wire [9:0] word_index;  // Word index in memory
+    wire [AW-1:0] word_index;  // Word index in memory
+
+    reg [8:0] count;
+    reg [7:0] beat; // beat of the current burst, 0 = waiting for the first beat
+    reg [7:0] extra; // jitter of the next request
+
+    // Wait of the current request
+    localparam [8:0] DEFAULT_LATENCY = LATENCY;
+    wire [8:0] wait_cycles = ((latency == 8'b0) ? DEFAULT_LATENCY : {1'b0, latency}) + {1'b0, extra};
+    wire [AW-1:0] beat_offset = {{(AW-8){1'b0}}, beat} << BEAT_SHIFT;
+
+    // Store data moved onto its byte lanes, and the lanes it writes
+    reg [31:0] store_data;
+    reg [3:0] store_mask;
+    always @(*) begin
+        case (mode)
+            `DM_SB: begin
+                store_data = {4{write_data[7:0]}};
+                store_mask = 4'b0001 << byte_offset;
+            end
+            `DM_SH: begin
+                store_data = {2{write_data[15:0]}};
+                store_mask = byte_offset[1] ? 4'b1100 : 4'b0011;
+            end
+            default: begin // DM_SW
+                store_data = write_data[31:0];
+                store_mask = 4'b1111;
+            end
+        endcase
+    end
+
+    function [31:0] read_word(input [AW-1:0] index);
+        if (SPARSE)
+            read_word = sparse_mem_read(store, {{(32-AW){1'b0}}, index});
+        else
+            read_word = ram_mem[index];
+    endfunction
 
-    reg [$clog2(LATENCY+1)-1:0] count;
 
     // Synchronous read/write with configurable latency
     always @(posedge clk) begin
+        integer i, b;
+        reg [31:0] word;
         ready <= 1'b0; // Default to not ready
         
         if (rst) begin
-            read_data <= 32'b0;
+            read_data <= '0;
             ready     <= 1'b0;
             count     <= '0;
+            beat      <= 8'b0;
+            extra     <= 8'b0;
         end else if (req) begin
-            if (count == LATENCY - 1) begin
+            if (beat != 8'b0 || count == wait_cycles - 9'd1) begin
                 count <= '0;
                 ready <= 1'b1;
-                if (we) begin
-                    // Write operation
-                    case (mode)
-                        `DM_SB: begin
-                            // Store Byte
-                            case (byte_offset)
-                                2'b00: ram_mem[word_index][7:0]   <= write_data[7:0];
-                                2'b01: ram_mem[word_index][15:8]  <= write_data[7:0];
-                                2'b10: ram_mem[word_index][23:16] <= write_data[7:0];
-                                2'b11: ram_mem[word_index][31:24] <= write_data[7:0];
-                            endcase
-                        end
-                        `DM_SH: begin
-                            // Store Halfword
-                            case (byte_offset[1])
-                                1'b0: ram_mem[word_index][15:0]  <= write_data[15:0];
-                                1'b1: ram_mem[word_index][31:16] <= write_data[15:0];
-                            endcase
-                        end
-                        `DM_SW: begin
-                            // Store Word
-                            ram_mem[word_index] <= write_data;
-                        end
-                        default: begin
-                            // Default to Store Word
-                            ram_mem[word_index] <= write_data;
-                        end
-                    endcase
+                beat  <= (beat == burst_len) ? 8'b0 : beat + 8'd1;
+                if (beat == burst_len) begin
+                    if (jitter != 64'b0)
+                        extra <= draw_jitter(jitter, `LAT_REGION_DMEM);
+                    else
+                        extra <= 8'b0;
+                end
+                if (BEAT_WORDS > 1) begin
+                    // Whole-beat transfer
+                    for (i = 0; i < BEAT_WORDS; i = i + 1) begin
+                        if (we && SPARSE)
+                            sparse_mem_write(store, {{(32-AW){1'b0}}, word_index + i[AW-1:0]},
+                                             write_data[32*i +: 32], 32'hF);
+                        else if (we)
+                            ram_mem[word_index + i[AW-1:0]] <= write_data[32*i +: 32];
+                        else
+                            read_data[32*i +: 32] <= read_word(word_index + i[AW-1:0]);
+                    end
+                end else if (we) begin
+                    // Write operation (SB/SH/SW): only the masked byte lanes
+                    if (SPARSE) begin
+                        sparse_mem_write(store, {{(32-AW){1'b0}}, word_index}, store_data, {28'b0, store_mask});
+                    end else begin
+                        for (b = 0; b < 4; b = b + 1)
+                            if (store_mask[b]) ram_mem[word_index][8*b +: 8] <= store_data[8*b +: 8];
+                    end
                 end else begin
                     // Read operation
+                    word = read_word(word_index);
                     case (mode)
                         `DM_LB: begin
                             // Load Byte (sign-extended)
                             case (byte_offset)
-                                2'b00: read_data <= {{24{ram_mem[word_index][7]}}, ram_mem[word_index][7:0]};
-                                2'b01: read_data <= {{24{ram_mem[word_index][15]}}, ram_mem[word_index][15:8]};
-                                2'b10: read_data <= {{24{ram_mem[word_index][23]}}, ram_mem[word_index][23:16]};
-                                2'b11: read_data <= {{24{ram_mem[word_index][31]}}, ram_mem[word_index][31:24]};
+                                2'b00: read_data[31:0] <= {{24{word[7]}}, word[7:0]};
+                                2'b01: read_data[31:0] <= {{24{word[15]}}, word[15:8]};
+                                2'b10: read_data[31:0] <= {{24{word[23]}}, word[23:16]};
+                                2'b11: read_data[31:0] <= {{24{word[31]}}, word[31:24]};
                             endcase
                         end
                         `DM_LBU: begin
                             // Load Byte Unsigned (zero-extended)
                             case (byte_offset)
-                                2'b00: read_data <= {24'b0, ram_mem[word_index][7:0]};
-                                2'b01: read_data <= {24'b0, ram_mem[word_index][15:8]};
-                                2'b10: read_data <= {24'b0, ram_mem[word_index][23:16]};
-                                2'b11: read_data <= {24'b0, ram_mem[word_index][31:24]};
+                                2'b00: read_data[31:0] <= {24'b0, word[7:0]};
+                                2'b01: read_data[31:0] <= {24'b0, word[15:8]};
+                                2'b10: read_data[31:0] <= {24'b0, word[23:16]};
+                                2'b11: read_data[31:0] <= {24'b0, word[31:24]};
                             endcase
                         end
                         `DM_LH: begin
                             // Load Halfword (sign-extended)
                             case (byte_offset[1])
-                                1'b0: read_data <= {{16{ram_mem[word_index][15]}}, ram_mem[word_index][15:0]};
-                                1'b1: read_data <= {{16{ram_mem[word_index][31]}}, ram_mem[word_index][31:16]};
+                                1'b0: read_data[31:0] <= {{16{word[15]}}, word[15:0]};
+                                1'b1: read_data[31:0] <= {{16{word[31]}}, word[31:16]};
                             endcase
                         end
                         `DM_LHU: begin
                             // Load Halfword Unsigned (zero-extended)
                             case (byte_offset[1])
-                                1'b0: read_data <= {16'b0, ram_mem[word_index][15:0]};
-                                1'b1: read_data <= {16'b0, ram_mem[word_index][31:16]};
+                                1'b0: read_data[31:0] <= {16'b0, word[15:0]};
+                                1'b1: read_data[31:0] <= {16'b0, word[31:16]};
                             endcase
                         end
-                        `DM_LW: begin
-                            // Load Word
-                            read_data <= ram_mem[word_index];
-                        end
                         default: begin
-                            // Default to Load Word
-                            read_data <= ram_mem[word_index];
+                            // Load Word
+                            read_data[31:0] <= word;
                         end
                     endcase
                 end
@@ -114,10 +170,11 @@ module dmem_sync #(
             end
         end else begin
             count <= '0;
+            beat  <= 8'b0;
         end
     end
 
     // Address decoding
     assign byte_offset = address[1:0];  // Bottom 2 bits for byte offset
-    assign word_index  = address[11:2]; // Next 10 bits for word index (4KB RAM)
+    assign word_index  = (address[AW+1:2] & BEAT_MASK) + beat_offset; // Word index within SIZE, plus the burst beat
 endmodule
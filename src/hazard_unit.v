@@ -0,0 +1,59 @@
+// Forwarding and interlock logic for the pipelined core
+module hazard_unit (
+    // ID stage (instruction in IF/ID)
+    input wire       id_valid,
+    input wire [4:0] id_rs1,
+    input wire [4:0] id_rs2,
+    input wire       id_uses_rs1,
+    input wire       id_uses_rs2,
+
+    // EX stage (instruction in ID/EX)
+    input wire       ex_valid,
+    input wire [4:0] ex_rs1,
+    input wire [4:0] ex_rs2,
+    input wire [4:0] ex_rd,
+    input wire       ex_mem_read,
+
+    // MEM stage (instruction in EX/MEM)
+    input wire       mem_valid,
+    input wire [4:0] mem_rd,
+    input wire       mem_reg_we,
+
+    // WB stage (instruction in MEM/WB)
+    input wire       wb_valid,
+    input wire [4:0] wb_rd,
+    input wire       wb_reg_we,
+
+    // Operand select for EX: 00 = register value, 01 = EX/MEM result, 10 = WB data
+    output reg [1:0] fwd_a_sel,
+    output reg [1:0] fwd_b_sel,
+
+    // Load in EX whose result the instruction in ID needs: hold ID one cycle
+    output wire      load_use
+);
+
+    wire mem_fwd = mem_valid && mem_reg_we && (mem_rd != 5'b0);
+    wire wb_fwd  = wb_valid && wb_reg_we && (wb_rd != 5'b0);
+
+    // The youngest producer wins. A load in MEM never matches here:
+    // the interlock puts a bubble between a load and its first consumer.
+    always @(*) begin
+        if (mem_fwd && mem_rd == ex_rs1)
+            fwd_a_sel = 2'b01;
+        else if (wb_fwd && wb_rd == ex_rs1)
+            fwd_a_sel = 2'b10;
+        else
+            fwd_a_sel = 2'b00;
+
+        if (mem_fwd && mem_rd == ex_rs2)
+            fwd_b_sel = 2'b01;
+        else if (wb_fwd && wb_rd == ex_rs2)
+            fwd_b_sel = 2'b10;
+        else
+            fwd_b_sel = 2'b00;
+    end
+
+    assign load_use = id_valid && ex_valid && ex_mem_read && (ex_rd != 5'b0) &&
+                      ((id_uses_rs1 && id_rs1 == ex_rd) || (id_uses_rs2 && id_rs2 == ex_rd));
+
+endmodule
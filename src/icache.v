@@ -0,0 +1,139 @@
+// Set-associative instruction cache between the CPU ROM port and imem_sync.
+// CPU side uses the imem_sync handshake: a hit is answered the cycle after the request,
+// a miss refills the whole line from the ROM as one burst and then answers.
+// SIZE and LINE_SIZE are in bytes; SIZE, LINE_SIZE (>= 8) and WAYS must be powers of two.
+// MEM_WIDTH is the ROM data path (32, 64 or 128 bits, at most one line per beat).
+module icache #(
+    parameter SIZE      = 1024,
+    parameter LINE_SIZE = 16,
+    parameter WAYS      = 2,
+    parameter MEM_WIDTH = 32
+) (
+    input wire clk,
+    input wire rst,
+
+    // CPU side
+    input wire [31:0] address,
+    output reg [31:0] read_data,
+    input wire req,
+    output reg ready,
+
+    // Backing ROM side (line bursts)
+    output wire [31:0] mem_address,
+    input wire [MEM_WIDTH-1:0] mem_read_data,
+    output wire mem_req,
+    input wire mem_ready,
+    output wire [7:0] mem_burst_len,
+
+    // Statistics: requests answered without a refill, and line refills
+    output reg [31:0] hits,
+    output reg [31:0] misses
+);
+
+    localparam WORDS       = LINE_SIZE / 4;
+    localparam SETS        = SIZE / (LINE_SIZE * WAYS);
+    localparam OFFSET_BITS = $clog2(LINE_SIZE);
+    localparam SET_SHIFT   = $clog2(SETS);
+    localparam SET_BITS    = (SETS > 1) ? $clog2(SETS) : 1;
+    localparam WAY_BITS    = (WAYS > 1) ? $clog2(WAYS) : 1;
+    localparam WORD_BITS   = $clog2(WORDS);
+    localparam LINES       = 1 << (SET_BITS + WAY_BITS);
+    localparam BEAT_WORDS  = MEM_WIDTH / 32;
+    localparam BEAT_SHIFT  = $clog2(BEAT_WORDS);
+    localparam BEATS       = WORDS / BEAT_WORDS;
+
+    localparam [WORD_BITS-1:0] LAST_BEAT = BEATS - 1;
+    localparam [7:0]           BURST_LEN = BEATS - 1;
+
+    // Storage, indexed by {set, way} (tags/valid) and {set, way, word} (data)
+    reg [31:0] tag_mem [0:LINES-1];
+    reg [LINES-1:0] valid;
+    reg [31:0] data_mem [0:LINES*WORDS-1];
+    reg [WAY_BITS-1:0] victim [0:(1 << SET_BITS)-1]; // Round-robin replacement per set
+
+    // Address split
+    wire [31:0] w_line_addr = address >> OFFSET_BITS;
+    wire [SET_BITS-1:0] w_set = (SETS > 1) ? w_line_addr[SET_BITS-1:0] : {SET_BITS{1'b0}};
+    wire [31:0] w_tag = address >> (OFFSET_BITS + SET_SHIFT);
+    wire [WORD_BITS-1:0] w_word = address[OFFSET_BITS-1:2];
+
+    // Tag compare
+    reg w_hit;
+    reg [WAY_BITS-1:0] w_hit_way;
+    always @(*) begin
+        integer i;
+        w_hit     = 1'b0;
+        w_hit_way = {WAY_BITS{1'b0}};
+        for (i = 0; i < WAYS; i = i + 1) begin
+            if (valid[{w_set, i[WAY_BITS-1:0]}] && tag_mem[{w_set, i[WAY_BITS-1:0]}] == w_tag) begin
+                w_hit     = 1'b1;
+                w_hit_way = i[WAY_BITS-1:0];
+            end
+        end
+    end
+
+    // Refill state
+    reg refilling;
+    reg refilled;  // Next answer completes a miss (not counted as a hit)
+    reg [31:0] refill_base;
+    reg [31:0] refill_tag;
+    reg [SET_BITS-1:0] refill_set;
+    reg [WAY_BITS-1:0] refill_way;
+    reg [WORD_BITS-1:0] refill_beat;
+
+    wire w_last_beat = mem_ready && (refill_beat == LAST_BEAT);
+
+    // Hold the burst request until the last beat arrives
+    assign mem_address   = refill_base;
+    assign mem_req       = refilling && !w_last_beat;
+    assign mem_burst_len = BURST_LEN;
+
+    always @(posedge clk) begin
+        integer i;
+        ready <= 1'b0;
+
+        if (rst) begin
+            read_data   <= 32'b0;
+            valid       <= '0;
+            refilling   <= 1'b0;
+            refilled    <= 1'b0;
+            refill_beat <= '0;
+            hits        <= 32'b0;
+            misses      <= 32'b0;
+            for (i = 0; i < (1 << SET_BITS); i = i + 1)
+                victim[i] <= '0;
+        end else if (refilling) begin
+            if (mem_ready) begin
+                for (i = 0; i < BEAT_WORDS; i = i + 1)
+                    data_mem[{refill_set, refill_way, (refill_beat << BEAT_SHIFT) + i[WORD_BITS-1:0]}] <= mem_read_data[32*i +: 32];
+                refill_beat <= refill_beat + 1;
+                if (w_last_beat) begin
+                    valid[{refill_set, refill_way}]   <= 1'b1;
+                    tag_mem[{refill_set, refill_way}] <= refill_tag;
+                    victim[refill_set] <= refill_way + 1;
+                    refilling <= 1'b0;
+                    refilled  <= 1'b1;
+                end
+            end
+        end else if (req) begin
+            if (w_hit) begin
+                ready     <= 1'b1;
+                read_data <= data_mem[{w_set, w_hit_way, w_word}];
+                refilled  <= 1'b0;
+                if (!refilled)
+                    hits <= hits + 1;
+            end else begin
+                // Miss: evict the victim way and fetch the whole line
+                refilling   <= 1'b1;
+                refill_base <= {address[31:OFFSET_BITS], {OFFSET_BITS{1'b0}}};
+                refill_tag  <= w_tag;
+                refill_set  <= w_set;
+                refill_way  <= victim[w_set];
+                refill_beat <= '0;
+                valid[{w_set, victim[w_set]}] <= 1'b0;
+                misses <= misses + 1;
+            end
+        end
+    end
+
+endmodule
@@ -1,38 +1,88 @@
+`include "sparse_mem.vh"
+`include "latency_jitter.vh"
+
 module imem_sync #(
-    parameter LATENCY = 1  // 1 = default (ready next cycle)
+    parameter LATENCY = 1,     // 1 = default (ready next cycle)
+    parameter DATA_WIDTH = 32, // 32, 64 or 128: words returned per beat
+    parameter SIZE = 4096,     // bytes, power of two (addresses wrap)
+    parameter SPARSE = 0       // 1 = words live in the harness's sparse memory (DPI)
 ) (
     input wire clk,
     input wire rst,
-    
+
+    input wire [63:0] store,  // harness memory handle for SPARSE, unused otherwise
+
+    // Runtime latency (testbench): cycles to the first beat, 0 = LATENCY. `jitter` is the
+    // harness's LatencyInjector handle adding random cycles to each request (0 = none).
+    input wire [7:0] latency,
+    input wire [63:0] jitter,
+
     input wire [31:0] address,
-    output reg [31:0] read_data,
+    output reg [DATA_WIDTH-1:0] read_data,
     input wire req,
-    output reg ready
+    output reg ready,
+
+    // Burst: beats after the first (0 = single beat). Later beats come from the following
+    // words on consecutive cycles while req is held.
+    input wire [7:0] burst_len
 );
 
-    // 32 bit wide ROM with 1024 words (4KB)
-    reg [31:0] rom_mem [0:1023];
+    localparam BEAT_WORDS = DATA_WIDTH / 32;
+    localparam BEAT_SHIFT = $clog2(BEAT_WORDS);
+    localparam WORDS = SIZE / 4;
+    localparam AW = $clog2(WORDS);
+    localparam [AW-1:0] BEAT_MASK = ~(BEAT_WORDS - 1); // Wide beats are aligned to their size
+
+    // 32 bit wide ROM, a single dummy word when SPARSE
+    reg [31:0] rom_mem [0:(SPARSE ? 0 : WORDS-1)];
+
+    reg [8:0] count;
+    reg [7:0] beat; // beat of the current burst, 0 = waiting for the first beat
+    reg [7:0] extra; // jitter of the next request
+
+    // Wait of the current request
+    localparam [8:0] DEFAULT_LATENCY = LATENCY;
+    wire [8:0] wait_cycles = ((latency == 8'b0) ? DEFAULT_LATENCY : {1'b0, latency}) + {1'b0, extra};
+
+    // First word of the current beat
+    wire [AW-1:0] beat_offset = {{(AW-8){1'b0}}, beat} << BEAT_SHIFT;
+    wire [AW-1:0] word_index = (address[AW+1:2] & BEAT_MASK) + beat_offset;
 
-    reg [$clog2(LATENCY+1)-1:0] count;
 
     // Synchronous read with configurable latency
     always @(posedge clk) begin
+        integer i;
         ready <= 1'b0; // Default to not ready
 
         if (rst) begin
-            read_data <= 32'b0;
+            read_data <= '0;
             ready     <= 1'b0;
             count     <= '0;
+            beat      <= 8'b0;
+            extra     <= 8'b0;
         end else if (req) begin
-            if (count == LATENCY - 1) begin
-                ready     <= 1'b1;
-                read_data <= rom_mem[address[11:2]];
-                count     <= '0;
+            if (beat != 8'b0 || count == wait_cycles - 9'd1) begin
+                ready <= 1'b1;
+                count <= '0;
+                beat  <= (beat == burst_len) ? 8'b0 : beat + 8'd1;
+                if (beat == burst_len) begin
+                    if (jitter != 64'b0)
+                        extra <= draw_jitter(jitter, `LAT_REGION_IMEM);
+                    else
+                        extra <= 8'b0;
+                end
+                for (i = 0; i < BEAT_WORDS; i = i + 1) begin
+                    if (SPARSE)
+                        read_data[32*i +: 32] <= sparse_mem_read(store, {{(32-AW){1'b0}}, word_index + i[AW-1:0]});
+                    else
+                        read_data[32*i +: 32] <= rom_mem[word_index + i[AW-1:0]];
+                end
             end else begin
                 count <= count + 1;
             end
         end else begin
             count <= '0;
+            beat  <= 8'b0;
         end
     end
-endmodule
\ No newline at end of file
+endmodule
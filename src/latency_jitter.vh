@@ -0,0 +1,20 @@
+`ifndef LATENCY_JITTER_VH
+`define LATENCY_JITTER_VH
+
+// Random extra cycles per request from the harness's LatencyInjector (sim/latency_injector.hpp).
+// Memories with a non-zero `jitter` handle draw the extra latency of their next request when
+// the current one completes, so the wait of a request is known from its first cycle.
+`define LAT_REGION_IMEM 0
+`define LAT_REGION_DMEM 1
+`define LAT_REGION_UART 2
+
+import "DPI-C" function int latency_jitter(input longint injector, input int region);
+
+// Extra cycles for the next request (the injector caps them at 255)
+function [7:0] draw_jitter(input [63:0] injector, input [31:0] region);
+    reg [31:0] cycles;
+    cycles = latency_jitter(injector, region);
+    draw_jitter = cycles[7:0];
+endfunction
+
+`endif
@@ -0,0 +1,192 @@
+`include "defines.vh"
+
+// RV32M multiply/divide unit. IMPL selects the implementation:
+//   0: single cycle, done in the start cycle (result combinational from a/b)
+//   1: iterative, one bit per cycle: done 34 cycles after start
+//   2: iterative with early termination: multiplies stop once the remaining multiplier bits
+//      are zero, divides skip the leading zero bits of the dividend
+// Iterative versions latch the operands on start, pulse done when the result is ready and
+// hold the result until the next start. Signed operations work on magnitudes and fix the
+// sign at the end. Division by zero and overflow give the results the spec requires.
+module muldiv #(
+    parameter IMPL = 0
+) (
+    input wire clk,
+    input wire rst,
+
+    input wire start,        // begin an operation (ignored while busy)
+    input wire [2:0] op,     // funct3
+    input wire [31:0] a,     // rs1
+    input wire [31:0] b,     // rs2
+
+    output wire [31:0] result,
+    output wire done,        // result valid this cycle
+    output wire busy
+);
+
+    // funct3 of the M extension (opcode OP, funct7 0000001)
+    localparam MUL    = 3'b000;
+    localparam MULH   = 3'b001;
+    localparam MULHSU = 3'b010;
+    localparam MULHU  = 3'b011;
+    localparam DIV    = 3'b100;
+    localparam DIVU   = 3'b101;
+    localparam REM    = 3'b110;
+    localparam REMU   = 3'b111;
+
+    // Operand signedness per operation
+    wire w_a_signed = (op == MULH) || (op == MULHSU) || (op == DIV) || (op == REM);
+    wire w_b_signed = (op == MULH) || (op == DIV) || (op == REM);
+    wire w_a_neg = w_a_signed && a[31];
+    wire w_b_neg = w_b_signed && b[31];
+    wire [31:0] w_a_mag = w_a_neg ? -a : a;
+    wire [31:0] w_b_mag = w_b_neg ? -b : b;
+
+    generate
+        if (IMPL == 0) begin : gen_single
+            // Single cycle: 33x33 signed product, dividers from the operators
+            wire signed [32:0] w_a_ext = {w_a_signed && a[31], a};
+            wire signed [32:0] w_b_ext = {w_b_signed && b[31], b};
+            wire signed [65:0] w_product = w_a_ext * w_b_ext;
+
+            wire [31:0] w_quo_mag = w_a_mag / w_b_mag;
+            wire [31:0] w_rem_mag = w_a_mag % w_b_mag;
+
+            reg [31:0] r_result;
+            always @(*) begin
+                case (op)
+                    MUL:          r_result = w_product[31:0];
+                    MULH,
+                    MULHSU,
+                    MULHU:        r_result = w_product[63:32];
+                    DIV,
+                    DIVU:         r_result = (b == 32'b0) ? 32'hFFFF_FFFF :
+                                             (w_a_neg ^ w_b_neg) ? -w_quo_mag : w_quo_mag;
+                    default:      r_result = (b == 32'b0) ? a :
+                                             w_a_neg ? -w_rem_mag : w_rem_mag;
+                endcase
+            end
+
+            assign result = r_result;
+            assign done = start;
+            assign busy = 1'b0;
+        end else begin : gen_iterative
+            reg r_busy;
+            reg r_done;
+            reg r_is_div;
+            reg r_rem;        // REM/REMU: result is the remainder
+            reg r_high;       // MULH*: result is the high word
+            reg r_neg;        // negate the magnitude result
+            reg r_div_zero;
+            reg [31:0] r_dividend_orig;
+            reg [5:0] r_count;  // steps left
+
+            reg [63:0] r_product;
+            reg [63:0] r_multiplicand;
+            reg [31:0] r_multiplier;
+
+            reg [31:0] r_quotient;  // dividend bits shift out of the top as quotient bits enter
+            reg [32:0] r_remainder;
+            reg [31:0] r_divisor;
+
+            reg [31:0] r_result;
+
+            // Leading zeros of the dividend magnitude (early termination skips them)
+            reg [5:0] w_clz;
+            always @(*) begin
+                integer i;
+                w_clz = 6'd32;
+                for (i = 0; i < 32; i = i + 1)
+                    if (w_a_mag[i]) w_clz = 6'd31 - i[5:0];
+            end
+
+            wire [5:0] w_div_skip = (IMPL == 2) ? w_clz : 6'd0;
+
+            // One restoring division step
+            wire [32:0] w_rem_shift = {r_remainder[31:0], r_quotient[31]};
+            wire w_rem_ge = w_rem_shift >= {1'b0, r_divisor};
+
+            // One shift-and-add multiply step
+            wire [63:0] w_product_next = r_multiplier[0] ? r_product + r_multiplicand : r_product;
+
+            // Result once the last step is in
+            wire [63:0] w_product_signed = r_neg ? -r_product : r_product;
+            wire [31:0] w_quo_signed = r_neg ? -r_quotient : r_quotient;
+            wire [31:0] w_rem_signed = r_neg ? -r_remainder[31:0] : r_remainder[31:0];
+
+            wire w_last = r_busy && (r_count == 6'd0 ||
+                                     (IMPL == 2 && !r_is_div && r_multiplier == 32'b0));
+
+            always @(posedge clk or posedge rst) begin
+                if (rst) begin
+                    r_busy <= 1'b0;
+                    r_done <= 1'b0;
+                    r_is_div <= 1'b0;
+                    r_rem <= 1'b0;
+                    r_high <= 1'b0;
+                    r_neg <= 1'b0;
+                    r_div_zero <= 1'b0;
+                    r_dividend_orig <= 32'b0;
+                    r_count <= 6'd0;
+                    r_product <= 64'b0;
+                    r_multiplicand <= 64'b0;
+                    r_multiplier <= 32'b0;
+                    r_quotient <= 32'b0;
+                    r_remainder <= 33'b0;
+                    r_divisor <= 32'b0;
+                    r_result <= 32'b0;
+                end else begin
+                    r_done <= 1'b0;
+
+                    if (start && !r_busy) begin
+                        r_busy <= 1'b1;
+                        r_is_div <= op[2];
+                        r_rem <= op[1];
+                        r_high <= (op != MUL);
+                        r_div_zero <= (b == 32'b0);
+                        r_dividend_orig <= a;
+
+                        if (op[2]) begin
+                            // Quotient sign: operands differ, remainder sign: dividend
+                            r_neg <= op[1] ? w_a_neg : (w_a_neg ^ w_b_neg);
+                            r_quotient <= w_a_mag << w_div_skip;
+                            r_remainder <= 33'b0;
+                            r_divisor <= w_b_mag;
+                            r_count <= 6'd32 - w_div_skip;
+                        end else begin
+                            r_neg <= w_a_neg ^ w_b_neg;
+                            r_product <= 64'b0;
+                            r_multiplicand <= {32'b0, w_a_mag};
+                            r_multiplier <= w_b_mag;
+                            r_count <= 6'd32;
+                        end
+                    end else if (w_last) begin
+                        r_busy <= 1'b0;
+                        r_done <= 1'b1;
+                        if (!r_is_div)
+                            r_result <= r_high ? w_product_signed[63:32] : w_product_signed[31:0];
+                        else if (r_div_zero)
+                            r_result <= r_rem ? r_dividend_orig : 32'hFFFF_FFFF;
+                        else
+                            r_result <= r_rem ? w_rem_signed : w_quo_signed;
+                    end else if (r_busy) begin
+                        r_count <= r_count - 6'd1;
+                        if (r_is_div) begin
+                            r_remainder <= w_rem_ge ? w_rem_shift - {1'b0, r_divisor} : w_rem_shift;
+                            r_quotient <= {r_quotient[30:0], w_rem_ge};
+                        end else begin
+                            r_product <= w_product_next;
+                            r_multiplicand <= r_multiplicand << 1;
+                            r_multiplier <= r_multiplier >> 1;
+                        end
+                    end
+                end
+            end
+
+            assign result = r_result;
+            assign done = r_done;
+            assign busy = r_busy;
+        end
+    endgenerate
+
+endmodule
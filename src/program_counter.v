@@ -1,6 +1,7 @@
 module program_counter (
     input wire clk,
     input wire rst,
+    input wire [31:0] reset_pc, // PC value loaded on reset
     input wire [31:0] next_pc,
     output reg [31:0] pc,
     input wire pc_we
@@ -8,7 +9,7 @@ module program_counter (
 
     always @(posedge clk or posedge rst) begin
         if (rst) begin
-            pc <= 32'b0;
+            pc <= reset_pc;
         end else if (pc_we) begin
             pc <= next_pc;
         end
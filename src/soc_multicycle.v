@@ -1,15 +1,75 @@
 module soc_multicycle #(
+    parameter PIPELINED = 0,     // 0 = cpu_multicycle, 1 = cpu_pipelined
+    parameter MULDIV_IMPL = 0,   // RV32M unit: 0 = single cycle, 1 = iterative, 2 = early termination
     parameter IMEM_LATENCY = 1,  // cycles before imem asserts ready
     parameter DMEM_LATENCY = 1,   // cycles before dmem asserts ready
-    parameter UART_LATENCY = 1   // cycles before uart asserts ready
+    parameter UART_LATENCY = 1,  // cycles before uart asserts ready
+    parameter UART_TX_FIFO_DEPTH = 16,
+    parameter UART_RX_FIFO_DEPTH = 16,
+    parameter STORE_BUFFER_DEPTH = 4, // posted stores in the bus controller
+    parameter DMA_BURST = 4,          // DMA elements per burst
+    parameter ICACHE = 0,            // 1 = instruction cache in front of the ROM
+    parameter ICACHE_SIZE = 1024,    // bytes
+    parameter ICACHE_LINE_SIZE = 16, // bytes
+    parameter ICACHE_WAYS = 2,
+    parameter DCACHE = 0,            // 1 = write-back data cache in front of the RAM
+    parameter DCACHE_SIZE = 1024,    // bytes
+    parameter DCACHE_LINE_SIZE = 16, // bytes
+    parameter DCACHE_WAYS = 2,
+    parameter MEM_WIDTH = 32,        // ROM/RAM data path behind the caches: 32, 64 or 128 bits
+    parameter ROM_SIZE = 4096,       // bytes, power of two
+    parameter RAM_SIZE = 4096,       // bytes, power of two, at most 32MB (below the CLINT)
+    parameter SPARSE_MEM = 0         // 1 = ROM/RAM words held by the harness through DPI
 ) (
     input wire clk,
     input wire rst,
+    input wire [31:0] reset_vector, // PC after reset (0 unless state is handed over)
+
+    // Harness handles of the sparse ROM/RAM stores (SPARSE_MEM only)
+    input wire [63:0] rom_store,
+    input wire [63:0] ram_store,
+
+    // Runtime latencies set by the testbench (0 = the *_LATENCY parameter) and the handle of
+    // its LatencyInjector, which adds random cycles per request when non-zero
+    input wire [7:0] imem_latency,
+    input wire [7:0] dmem_latency,
+    input wire [7:0] uart_latency,
+    input wire [63:0] latency_injector,
 
     output wire uart_tx,
-    input wire uart_rx
+    input wire uart_rx,
+
+    // End of program: ECALL/EBREAK or TOHOST write, once the bus and the DMA have drained
+    output wire halted,
+    output wire [31:0] tohost,
+
+    // Core asleep in WFI with the bus, DMA and data cache idle: only the UART and the counters
+    // (mcycle, mtime) can change state until an interrupt wakes it, so the testbench can skip ahead
+    output wire cpu_idle,
+
+    // Debug: retirement pulse and current PC (next PC once the instruction retires)
+    output wire retire,
+    output wire [31:0] pc,
+
+    // Firmware asks for waveforms (TRACE_CTRL bit 0)
+    output wire trace_on,
+
+    // Instruction cache statistics (zero without ICACHE)
+    output wire [31:0] icache_hits,
+    output wire [31:0] icache_misses,
+
+    // Data cache maintenance (flush: write back dirty lines and invalidate) and statistics
+    input wire dcache_flush,
+    input wire dcache_invalidate,
+    output wire dcache_busy,
+    output wire [31:0] dcache_hits,
+    output wire [31:0] dcache_misses
 );
 
+    // Memories are only wider than a word behind a cache, which refills whole beats
+    localparam IMEM_WIDTH = ICACHE ? MEM_WIDTH : 32;
+    localparam DMEM_WIDTH = DCACHE ? MEM_WIDTH : 32;
+
     // Internal signals
     // CPU <-> ROM
     wire [31:0] rom_addr;
@@ -17,6 +77,13 @@ module soc_multicycle #(
     wire rom_req;
     wire rom_ready;
 
+    // Cache <-> ROM (same as CPU <-> ROM without ICACHE)
+    wire [31:0] imem_addr;
+    wire [IMEM_WIDTH-1:0] imem_data;
+    wire imem_req;
+    wire imem_ready;
+    wire [7:0] imem_burst_len;
+
     // CPU <-> BC
     wire [31:0] cpu_addr;
     wire [31:0] cpu_wdata;
@@ -26,59 +93,229 @@ module soc_multicycle #(
     wire cpu_req;
     wire cpu_ready;
 
-    // BC <-> RAM / UART
+    // BC <-> RAM / UART / DMA / CLINT registers
     wire [31:0] mem_addr;
     wire [31:0] mem_wdata;
-    wire [31:0] mem_rdata [1:0]; // 0: dmem data, 1: uart data
+    wire [31:0] mem_rdata [3:0]; // 0: dmem data, 1: uart data, 2: dma data, 3: clint data
     wire mem_we;
     wire [2:0] mem_mode;
-    wire [1:0] mem_req; // 01: dmem, 10: uart
-    wire [1:0] mem_ready; // 01: dmem, 10: uart
+    wire [3:0] mem_req; // 0001: dmem, 0010: uart, 0100: dma, 1000: clint
+    wire [3:0] mem_ready; // 0001: dmem, 0010: uart, 0100: dma, 1000: clint
 
-    // CPU instantiation
-    cpu_multicycle cpu_inst (
-        .clk(clk),
-        .rst(rst),
-        .o_rom_addr(rom_addr),
-        .i_rom_data(rom_data),
-        .o_ram_addr(cpu_addr),
-        .o_ram_wdata(cpu_wdata),
-        .i_ram_rdata(cpu_rdata),
-        .o_ram_we(cpu_we),
-        .o_ram_mode(cpu_mode),
-        .o_rom_req(rom_req),
-        .i_rom_ready(rom_ready),
-        .o_ram_req(cpu_req),
-        .i_ram_ready(cpu_ready)
-    );
+    // DMA master <-> BC
+    wire [31:0] dma_addr;
+    wire [31:0] dma_wdata;
+    wire [31:0] dma_rdata;
+    wire dma_we;
+    wire [2:0] dma_mode;
+    wire dma_req;
+    wire dma_grant;
+    wire dma_rvalid;
+    wire dma_busy;
+    wire uart_tx_fifo_ready;
+    wire uart_irq;
+    wire timer_irq;
+
+    // Cache <-> RAM (same as BC <-> RAM without DCACHE)
+    wire [31:0] dmem_addr;
+    wire [DMEM_WIDTH-1:0] dmem_wdata;
+    wire [DMEM_WIDTH-1:0] dmem_rdata;
+    wire dmem_we;
+    wire [2:0] dmem_mode;
+    wire dmem_req;
+    wire dmem_ready;
+    wire [7:0] dmem_burst_len;
+
+    // Halt detection
+    wire cpu_halted;
+    wire core_idle;
+    wire tohost_valid;
+    wire bus_busy;
+    wire bus_stall;
+
+    // CPU instantiation (both variants share the instance path gen_cpu.cpu_inst)
+    generate
+        if (PIPELINED) begin : gen_cpu
+            cpu_pipelined #(.MULDIV_IMPL(MULDIV_IMPL)) cpu_inst (
+                .clk(clk),
+                .rst(rst),
+                .i_reset_vector(reset_vector),
+                .o_rom_addr(rom_addr),
+                .i_rom_data(rom_data),
+                .o_ram_addr(cpu_addr),
+                .o_ram_wdata(cpu_wdata),
+                .i_ram_rdata(cpu_rdata),
+                .o_ram_we(cpu_we),
+                .o_ram_mode(cpu_mode),
+                .o_rom_req(rom_req),
+                .i_rom_ready(rom_ready),
+                .o_ram_req(cpu_req),
+                .i_ram_ready(cpu_ready),
+                .i_bus_stall(bus_stall),
+                .o_halted(cpu_halted),
+                .o_retire(retire),
+                .o_pc(pc)
+            );
+            assign core_idle = 1'b0; // WFI is a NOP in the pipelined core
+        end else begin : gen_cpu
+            cpu_multicycle #(.MULDIV_IMPL(MULDIV_IMPL)) cpu_inst (
+                .clk(clk),
+                .rst(rst),
+                .i_reset_vector(reset_vector),
+                .o_rom_addr(rom_addr),
+                .i_rom_data(rom_data),
+                .o_ram_addr(cpu_addr),
+                .o_ram_wdata(cpu_wdata),
+                .i_ram_rdata(cpu_rdata),
+                .o_ram_we(cpu_we),
+                .o_ram_mode(cpu_mode),
+                .o_rom_req(rom_req),
+                .i_rom_ready(rom_ready),
+                .o_ram_req(cpu_req),
+                .i_ram_ready(cpu_ready),
+                .i_bus_stall(bus_stall),
+                .i_irq_external(uart_irq),
+                .i_irq_timer(timer_irq),
+                .o_halted(cpu_halted),
+                .o_idle(core_idle),
+                .o_retire(retire),
+                .o_pc(pc)
+            );
+        end
+    endgenerate
+
+    // Instruction cache
+    generate
+        if (ICACHE) begin : gen_icache
+            icache #(
+                .SIZE(ICACHE_SIZE),
+                .LINE_SIZE(ICACHE_LINE_SIZE),
+                .WAYS(ICACHE_WAYS),
+                .MEM_WIDTH(IMEM_WIDTH)
+            ) icache_inst (
+                .clk(clk),
+                .rst(rst),
+                .address(rom_addr),
+                .read_data(rom_data),
+                .req(rom_req),
+                .ready(rom_ready),
+                .mem_address(imem_addr),
+                .mem_read_data(imem_data),
+                .mem_req(imem_req),
+                .mem_ready(imem_ready),
+                .mem_burst_len(imem_burst_len),
+                .hits(icache_hits),
+                .misses(icache_misses)
+            );
+        end else begin : gen_icache
+            assign imem_addr      = rom_addr;
+            assign rom_data       = imem_data;
+            assign imem_req       = rom_req;
+            assign rom_ready      = imem_ready;
+            assign imem_burst_len = 8'b0;
+            assign icache_hits    = 32'b0;
+            assign icache_misses  = 32'b0;
+        end
+    endgenerate
 
     // ROM instantiation
-    imem_sync #(.LATENCY(IMEM_LATENCY)) rom_inst (
+    imem_sync #(
+        .LATENCY(IMEM_LATENCY),
+        .DATA_WIDTH(IMEM_WIDTH),
+        .SIZE(ROM_SIZE),
+        .SPARSE(SPARSE_MEM)
+    ) rom_inst (
         .clk(clk),
         .rst(rst),
-        .address(rom_addr),
-        .read_data(rom_data),
-        .req(rom_req),
-        .ready(rom_ready)
+        .store(rom_store),
+        .latency(imem_latency),
+        .jitter(latency_injector),
+        .address(imem_addr),
+        .read_data(imem_data),
+        .req(imem_req),
+        .ready(imem_ready),
+        .burst_len(imem_burst_len)
     );
 
+    // Data cache (RAM only, UART and TOHOST stay uncached)
+    generate
+        if (DCACHE) begin : gen_dcache
+            dcache #(
+                .SIZE(DCACHE_SIZE),
+                .LINE_SIZE(DCACHE_LINE_SIZE),
+                .WAYS(DCACHE_WAYS),
+                .MEM_WIDTH(DMEM_WIDTH)
+            ) dcache_inst (
+                .clk(clk),
+                .rst(rst),
+                .address(mem_addr),
+                .write_data(mem_wdata),
+                .read_data(mem_rdata[0]),
+                .we(mem_we),
+                .mode(mem_mode),
+                .req(mem_req[0]),
+                .ready(mem_ready[0]),
+                .mem_address(dmem_addr),
+                .mem_write_data(dmem_wdata),
+                .mem_read_data(dmem_rdata),
+                .mem_we(dmem_we),
+                .mem_mode(dmem_mode),
+                .mem_req(dmem_req),
+                .mem_ready(dmem_ready),
+                .mem_burst_len(dmem_burst_len),
+                .flush(dcache_flush),
+                .invalidate(dcache_invalidate),
+                .busy(dcache_busy),
+                .hits(dcache_hits),
+                .misses(dcache_misses)
+            );
+        end else begin : gen_dcache
+            assign dmem_addr      = mem_addr;
+            assign dmem_wdata     = mem_wdata;
+            assign mem_rdata[0]   = dmem_rdata;
+            assign dmem_we        = mem_we;
+            assign dmem_mode      = mem_mode;
+            assign dmem_req       = mem_req[0];
+            assign mem_ready[0]   = dmem_ready;
+            assign dmem_burst_len = 8'b0;
+            assign dcache_busy    = 1'b0;
+            assign dcache_hits    = 32'b0;
+            assign dcache_misses  = 32'b0;
+        end
+    endgenerate
+
     // RAM instantiation
-    dmem_sync #(.LATENCY(DMEM_LATENCY)) ram_inst (
+    dmem_sync #(
+        .LATENCY(DMEM_LATENCY),
+        .DATA_WIDTH(DMEM_WIDTH),
+        .SIZE(RAM_SIZE),
+        .SPARSE(SPARSE_MEM)
+    ) ram_inst (
         .clk(clk),
         .rst(rst),
-        .address(mem_addr),
-        .write_data(mem_wdata),
-        .read_data(mem_rdata[0]),
-        .we(mem_we),
-        .mode(mem_mode),
-        .req(mem_req[0]), 
-        .ready(mem_ready[0])
+        .store(ram_store),
+        .latency(dmem_latency),
+        .jitter(latency_injector),
+        .address(dmem_addr),
+        .write_data(dmem_wdata),
+        .read_data(dmem_rdata),
+        .we(dmem_we),
+        .mode(dmem_mode),
+        .req(dmem_req),
+        .ready(dmem_ready),
+        .burst_len(dmem_burst_len)
     );
 
     // UART instantiation
-    uart #(.LATENCY(UART_LATENCY)) uart_inst (
+    uart #(
+        .LATENCY(UART_LATENCY),
+        .TX_FIFO_DEPTH(UART_TX_FIFO_DEPTH),
+        .RX_FIFO_DEPTH(UART_RX_FIFO_DEPTH)
+    ) uart_inst (
         .clk(clk),
         .rst(rst),
+        .latency(uart_latency),
+        .jitter(latency_injector),
         .address(mem_addr),
         .write_data(mem_wdata),
         .read_data(mem_rdata[1]),
@@ -87,11 +324,50 @@ module soc_multicycle #(
         .req(mem_req[1]), 
         .ready(mem_ready[1]),
         .tx(uart_tx),
-        .rx(uart_rx)
+        .rx(uart_rx),
+        .tx_fifo_ready(uart_tx_fifo_ready),
+        .irq(uart_irq)
+    );
+
+    // DMA instantiation
+    dma #(.BURST(DMA_BURST), .RAM_SIZE(RAM_SIZE)) dma_inst (
+        .clk(clk),
+        .rst(rst),
+        .address(mem_addr),
+        .write_data(mem_wdata),
+        .read_data(mem_rdata[2]),
+        .we(mem_we),
+        .mode(mem_mode),
+        .req(mem_req[2]),
+        .ready(mem_ready[2]),
+        .m_address(dma_addr),
+        .m_write_data(dma_wdata),
+        .m_we(dma_we),
+        .m_mode(dma_mode),
+        .m_req(dma_req),
+        .m_grant(dma_grant),
+        .m_read_data(dma_rdata),
+        .m_rvalid(dma_rvalid),
+        .uart_tx_ready(uart_tx_fifo_ready),
+        .busy(dma_busy)
+    );
+
+    // CLINT timer instantiation
+    clint clint_inst (
+        .clk(clk),
+        .rst(rst),
+        .address(mem_addr),
+        .write_data(mem_wdata),
+        .read_data(mem_rdata[3]),
+        .we(mem_we),
+        .mode(mem_mode),
+        .req(mem_req[3]),
+        .ready(mem_ready[3]),
+        .irq(timer_irq)
     );
 
     // Bus controller instantiation
-    bus_controller bus_ctrl_inst (
+    bus_controller #(.STORE_BUFFER_DEPTH(STORE_BUFFER_DEPTH), .RAM_SIZE(RAM_SIZE)) bus_ctrl_inst (
         .clk(clk),
         .rst(rst),
         // CPU Interface
@@ -109,7 +385,25 @@ module soc_multicycle #(
         .mem_we(mem_we),
         .mem_mode(mem_mode),
         .mem_req(mem_req),
-        .mem_ready(mem_ready)
+        .mem_ready(mem_ready),
+        // DMA master
+        .dma_address(dma_addr),
+        .dma_write_data(dma_wdata),
+        .dma_we(dma_we),
+        .dma_mode(dma_mode),
+        .dma_req(dma_req),
+        .dma_grant(dma_grant),
+        .dma_read_data(dma_rdata),
+        .dma_rvalid(dma_rvalid),
+        // TOHOST
+        .tohost_data(tohost),
+        .tohost_valid(tohost_valid),
+        .trace_on(trace_on),
+        .busy(bus_busy),
+        .stall(bus_stall)
     ); 
 
+    assign halted = (cpu_halted || tohost_valid) && !bus_busy && !dma_busy;
+    assign cpu_idle = core_idle && !bus_busy && !dma_busy && !dcache_busy;
+
 endmodule
\ No newline at end of file
@@ -0,0 +1,11 @@
+`ifndef SPARSE_MEM_VH
+`define SPARSE_MEM_VH
+
+// Host-side sparse memory (sim/sparse_memory.cpp) for imem_sync/dmem_sync with SPARSE = 1.
+// `store` is the harness's handle, words are indexed from the start of the memory and pages
+// are allocated on the first write; untouched words read as the memory's background value.
+import "DPI-C" function int sparse_mem_read(input longint store, input int word_index);
+import "DPI-C" function void sparse_mem_write(input longint store, input int word_index,
+                                              input int data, input int byte_mask);
+
+`endif
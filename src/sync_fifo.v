@@ -0,0 +1,54 @@
+// Synchronous FIFO with the head word visible on read_data (first-word fall-through).
+// DEPTH must be a power of two. Pushing when full or popping when empty is ignored.
+module sync_fifo #(
+    parameter WIDTH = 8,
+    parameter DEPTH = 16
+) (
+    input wire clk,
+    input wire rst,
+
+    input wire push,
+    input wire [WIDTH-1:0] write_data,
+    input wire pop,
+    output wire [WIDTH-1:0] read_data,
+
+    output wire full,
+    output wire empty,
+    output reg [$clog2(DEPTH):0] level
+);
+
+    localparam PTR_BITS = $clog2(DEPTH);
+    localparam [PTR_BITS:0] FULL_LEVEL = DEPTH;
+
+    reg [WIDTH-1:0] mem [0:DEPTH-1];
+    reg [PTR_BITS-1:0] head;
+    reg [PTR_BITS-1:0] tail;
+
+    wire do_push = push && !full;
+    wire do_pop  = pop && !empty;
+
+    always @(posedge clk) begin
+        if (rst) begin
+            head  <= '0;
+            tail  <= '0;
+            level <= '0;
+        end else begin
+            if (do_push) begin
+                mem[tail] <= write_data;
+                tail <= tail + 1;
+            end
+            if (do_pop)
+                head <= head + 1;
+
+            if (do_push && !do_pop)
+                level <= level + 1;
+            else if (do_pop && !do_push)
+                level <= level - 1;
+        end
+    end
+
+    assign read_data = mem[head];
+    assign full  = (level == FULL_LEVEL);
+    assign empty = (level == '0);
+
+endmodule
@@ -1,11 +1,19 @@
 `include "defines.vh"
+`include "latency_jitter.vh"
 
 module uart #(
-    parameter LATENCY = 1 // 1 = default (ready next cycle)
+    parameter LATENCY = 1,        // 1 = default (ready next cycle)
+    parameter TX_FIFO_DEPTH = 16, // power of two
+    parameter RX_FIFO_DEPTH = 16  // power of two
 ) (
     input wire clk,
     input wire rst,
-    
+
+    // Runtime latency (testbench): cycles until ready, 0 = LATENCY. `jitter` is the
+    // harness's LatencyInjector handle adding random cycles to each access (0 = none).
+    input wire [7:0] latency,
+    input wire [63:0] jitter,
+
     input wire [31:0] address,
     input wire [31:0] write_data,
     output reg [31:0] read_data,
@@ -14,21 +22,57 @@ module uart #(
     input wire req,
     output reg ready,
     output reg tx, // UART transmit line
-    input wire rx   // UART receive line
+    input wire rx,  // UART receive line
+    output wire tx_fifo_ready, // Tx FIFO can accept a byte (DMA flow control)
+    output wire irq            // enabled Rx/Tx interrupt condition (level)
 );
     localparam TX_REG_ADDR = 32'h0000_0000;
     localparam RX_REG_ADDR = 32'h0000_0004;
     localparam STATUS_REG_ADDR = 32'h0000_0008;
     localparam BAUD_RATE_REG_ADDR = 32'h0000_000C;
+    localparam LEVEL_REG_ADDR = 32'h0000_0010;
+    localparam THRESHOLD_REG_ADDR = 32'h0000_0014;
+    localparam IRQ_ENABLE_REG_ADDR = 32'h0000_0018;
+
+    localparam [15:0] TX_THRESHOLD_RESET = TX_FIFO_DEPTH / 2;
+
+    // Tx FIFO (written at address 0x0000_0000)
+    wire [7:0] tx_head;
+    wire tx_full, tx_empty;
+    wire [$clog2(TX_FIFO_DEPTH):0] tx_level;
+    // Rx FIFO (read at address 0x0000_0004)
+    wire [7:0] rx_head;
+    wire rx_full, rx_empty;
+    wire [$clog2(RX_FIFO_DEPTH):0] rx_level;
+
+    // Level register (address 0x0000_0010): [15:0] Tx level, [31:16] Rx level
+    reg [31:0] level_reg;
+    always @(*) begin
+        level_reg = 32'b0;
+        level_reg[$clog2(TX_FIFO_DEPTH):0] = tx_level;
+        level_reg[16 +: $clog2(RX_FIFO_DEPTH) + 1] = rx_level;
+    end
+
+    // Threshold register (address 0x0000_0014): [15:0] Tx threshold, [31:16] Rx threshold
+    reg [15:0] tx_threshold;
+    reg [15:0] rx_threshold;
+    reg rx_overrun; // A byte arrived while the Rx FIFO was full (cleared by reading the status)
 
-    // Tx register (address 0x0000_0000)
-    reg [7:0] tx_reg;
-    // Rx register (address 0x0000_0004)
-    reg [7:0] rx_reg;
     // Status register (address 0x0000_0008)
-    // Bit 0: Tx ready (1 = ready to accept new byte, 0 = still transmitting previous byte)
-    // Bit 1: Rx ready (1 = new byte received and ready to read, 0 = no new data)
-    wire [7:0] status_reg = {6'b0, rx_ready, ~tx_busy};
+    // Bit 0: Tx ready (1 = Tx FIFO can accept a byte)
+    // Bit 1: Rx ready (1 = Rx FIFO holds at least one byte)
+    // Bit 2: Tx idle (1 = Tx FIFO empty and the last byte fully sent)
+    // Bit 3: Tx level <= Tx threshold
+    // Bit 4: Rx level >= Rx threshold
+    // Bit 5: Rx overrun
+    wire [31:0] status_reg = {26'b0, rx_overrun, level_reg[31:16] >= rx_threshold,
+                              level_reg[15:0] <= tx_threshold, tx_empty && !tx_busy, !rx_empty, !tx_full};
+    // Interrupt enable register (address 0x0000_0018)
+    // Bit 0: Rx interrupt while Rx level >= Rx threshold (1 = Rx ready by default)
+    // Bit 1: Tx interrupt while the Tx FIFO is empty
+    reg [1:0] irq_enable;
+    assign irq = (irq_enable[0] && status_reg[4]) || (irq_enable[1] && tx_empty);
+
     // Baud rate register
     reg [7:0] baud_rate_reg; 
 
@@ -36,12 +80,10 @@ module uart #(
     reg [7:0] tx_bit_count;
     reg [8:0] tx_cycle_count;
     reg tx_busy; // Indicates if a byte is currently being transmitted
-    reg tx_start; // Indicates the start of a new transmission
 
     reg[7:0] rx_shift_reg;
     reg [3:0] rx_bit_count;
     reg [7:0] rx_cycle_count;
-    reg rx_ready; // Indicates if a new byte has been received
     reg rx_done; // Signal to indicate a byte has been fully received and is ready to be read
     reg [7:0] rx_temp; // Temporary holding buffer inside Rx FSM
 
@@ -57,50 +99,105 @@ module uart #(
     localparam RX_STOP = 2'b11;
     reg [1:0] rx_state;
 
+    // Bus latency: req is held until ready, the access happens in the last cycle of the wait
+    reg [8:0] count;
+    reg [7:0] extra; // jitter of the next access
+    localparam [8:0] DEFAULT_LATENCY = LATENCY;
+    wire [8:0] wait_cycles = ((latency == 8'b0) ? DEFAULT_LATENCY : {1'b0, latency}) + {1'b0, extra};
+    wire access = req && count == wait_cycles - 9'd1;
+
+    // FIFO handshakes: the CPU pushes Tx and pops Rx, the shift registers do the opposite
+    wire tx_push = access && we && address == TX_REG_ADDR;
+    wire tx_pop  = (tx_state == TX_IDLE) && !tx_empty;
+    wire rx_pop  = access && !we && address == RX_REG_ADDR;
+
+    sync_fifo #(.WIDTH(8), .DEPTH(TX_FIFO_DEPTH)) tx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .push(tx_push),
+        .write_data(write_data[7:0]),
+        .pop(tx_pop),
+        .read_data(tx_head),
+        .full(tx_full),
+        .empty(tx_empty),
+        .level(tx_level)
+    );
+
+    sync_fifo #(.WIDTH(8), .DEPTH(RX_FIFO_DEPTH)) rx_fifo (
+        .clk(clk),
+        .rst(rst),
+        .push(rx_done),
+        .write_data(rx_temp),
+        .pop(rx_pop),
+        .read_data(rx_head),
+        .full(rx_full),
+        .empty(rx_empty),
+        .level(rx_level)
+    );
+
+    assign tx_fifo_ready = !tx_full;
+
     // Bus interface state machine
     always @(posedge clk) begin
         if (rst) begin
             ready <= 1'b0;
             read_data <= 32'b0;
+            count <= 9'b0;
+            extra <= 8'b0;
 
-            tx_start <= 1'b0;
-            tx_reg <= 8'b0;
-
-            rx_ready <= 1'b0;
-            rx_reg <= 8'b0;
+            rx_overrun <= 1'b0;
+            tx_threshold <= TX_THRESHOLD_RESET;
+            rx_threshold <= 16'd1;
+            irq_enable <= 2'b00;
 
             baud_rate_reg <= 8'd10; // Default baud rate top value
         end else begin
             ready <= 1'b0;
-            tx_start <= 1'b0;
 
-            if (rx_done) begin
-                rx_reg <= rx_temp;
-                rx_ready <= 1'b1;
+            if (rx_done && rx_full) begin
+                rx_overrun <= 1'b1;
+            end
+
+            if (req && !access) begin
+                count <= count + 1;
+            end else begin
+                count <= 9'b0;
             end
 
-            if (req) begin
+            if (access) begin
                 ready <= 1'b1;
+                if (jitter != 64'b0)
+                    extra <= draw_jitter(jitter, `LAT_REGION_UART);
+                else
+                    extra <= 8'b0;
 
                 if (we && address == TX_REG_ADDR) begin
-                    // CPU is writing to the Tx register
-                    if (!tx_busy) begin
-                        tx_reg <= write_data[7:0]; // Load holding register
-                        tx_start <= 1'b1;
-                    end else begin
-                        // Still busy transmitting previous byte
+                    // CPU is writing to the Tx FIFO
+                    if (tx_full) begin
+                        // No room, the CPU retries until a byte has been sent
                         ready <= 1'b0;
                     end
                 end else if (!we && address == STATUS_REG_ADDR) begin
                     // CPU is reading the status register
-                    read_data <= {24'b0, status_reg};
+                    read_data <= status_reg;
+                    rx_overrun <= 1'b0;
                 end else if (!we && address == RX_REG_ADDR) begin
-                    // CPU is reading the Rx register
-                    read_data <= {24'b0, rx_reg};
-                    rx_ready <= 1'b0;
+                    // CPU is reading the Rx FIFO (0 when empty)
+                    read_data <= rx_empty ? 32'b0 : {24'b0, rx_head};
+                end else if (!we && address == LEVEL_REG_ADDR) begin
+                    read_data <= level_reg;
                 end else if (we && address == BAUD_RATE_REG_ADDR) begin
                     // CPU is writing to the baud rate register
                     baud_rate_reg <= write_data[7:0];
+                end else if (we && address == THRESHOLD_REG_ADDR) begin
+                    tx_threshold <= write_data[15:0];
+                    rx_threshold <= write_data[31:16];
+                end else if (!we && address == THRESHOLD_REG_ADDR) begin
+                    read_data <= {rx_threshold, tx_threshold};
+                end else if (we && address == IRQ_ENABLE_REG_ADDR) begin
+                    irq_enable <= write_data[1:0];
+                end else if (!we && address == IRQ_ENABLE_REG_ADDR) begin
+                    read_data <= {30'b0, irq_enable};
                 end else begin
                     // Invalid address, ignore
                     ready <= 1'b0;
@@ -123,8 +220,8 @@ module uart #(
                     // Idle
                     tx <= 1'b1;
 
-                    if (tx_start) begin
-                        tx_shift_reg <= tx_reg;
+                    if (tx_pop) begin
+                        tx_shift_reg <= tx_head;
                         tx_busy <= 1'b1;
                         tx_bit_count <= 0;
                         tx_cycle_count <= 0;